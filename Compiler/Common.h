@@ -24,6 +24,12 @@ using ValueData = std::variant<int, String, bool>;
 namespace Constants {
     constexpr const char* VERSION = "0.0.3";
     constexpr int MAX_RECURSION_DEPTH = 1000;
+    constexpr size_t AUTO_PARALLEL_MIN_ITERATIONS = 1000;
+    constexpr size_t TASK_STACK_MARGIN = 32 * 1024;
+    constexpr size_t TASK_POOL_SIZE = 64;
+    constexpr size_t MAX_ARRAY_LENGTH = size_t(1) << 28;
+    constexpr size_t BUDGET_CHECK_INTERVAL = 1024;
+    constexpr size_t SCHEDULER_SLOTS_PER_THREAD = 16;
 }
 
 #define MAKE_PTR(T, ...) std::make_shared<T>(__VA_ARGS__)
\ No newline at end of file
@@ -1,12 +1,20 @@
 #include "Common.h"
 #include "lexer/Lexer.h"
 #include "parser/Parser.h"
+#include "analysis/TypeChecker.h"
+#include "analysis/ParallelAnalysis.h"
 #include "runtime/Interpreter.h"
-#include "builtins/builtins.h"
+#include "runtime/ThreadPool.h"
+#include "runtime/Scheduler.h"
+#include "runtime/Zygote.h"
+#include "runtime/ConsoleOutput.h"
 #include "utils/Error.h"
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 String readFile(const String& filename) {
     std::ifstream file(filename);
@@ -19,39 +27,377 @@ String readFile(const String& filename) {
     return buffer.str();
 }
 
-void runFile(const String& filename) {
-    try {
-        String source = readFile(filename);
+struct RunOptions {
+    size_t gcHeapMax = 0;
+    bool gcStats = false;
+    bool explainParallel = false;
+    Budget::Limits budget;
+    int64_t timeSliceMs = 0;
+};
 
-        Lexer lexer(source);
-        Vec<Token> tokens = lexer.tokenize();
+size_t parseByteSize(const String& text) {
+    size_t pos = 0;
+    unsigned long long value = std::stoull(text, &pos);
 
-        Parser parser(tokens);
-        Ptr<ProgramNode> program = parser.parse();
+    String suffix = text.substr(pos);
+    if (suffix == "K" || suffix == "k") value <<= 10;
+    else if (suffix == "M" || suffix == "m") value <<= 20;
+    else if (suffix == "G" || suffix == "g") value <<= 30;
+    else if (!suffix.empty()) {
+        throw std::runtime_error("Invalid size: " + text);
+    }
 
-        BuiltinRegistry::instance().registerAll();
+    return static_cast<size_t>(value);
+}
 
-        Interpreter interpreter;
+void printGcStats(const Heap& heap) {
+    const HeapStats& stats = heap.getStats();
+    std::cerr << "[gc] collections: " << stats.collections
+        << ", pause total: " << stats.totalPauseMs << " ms"
+        << ", pause max: " << stats.maxPauseMs << " ms" << std::endl;
+    std::cerr << "[gc] heap: " << stats.heapBytes << " bytes in " << stats.liveObjects
+        << " objects, peak " << stats.peakHeapBytes << " bytes"
+        << ", freed " << stats.bytesFreed << " bytes in " << stats.objectsFreed << " objects" << std::endl;
+}
+
+void printBudgetStats(const Budget& budget, const String& exceeded) {
+    const Budget::Limits& limits = budget.getLimits();
+    std::cerr << "[budget] steps: " << budget.getSteps();
+    if (limits.maxSteps > 0) {
+        std::cerr << " of " << limits.maxSteps;
+    }
+    std::cerr << ", elapsed: " << budget.elapsedMs() << " ms";
+    if (limits.maxMilliseconds > 0) {
+        std::cerr << " of " << limits.maxMilliseconds << " ms";
+    }
+    if (!exceeded.empty()) {
+        std::cerr << ", exceeded: " << exceeded;
+    }
+    std::cerr << std::endl;
+}
+
+// Heap limit and a fresh budget for one run of a script.
+void configureInterpreter(Interpreter& interpreter, const RunOptions& options) {
+    interpreter.getHeap().setMaxBytes(options.gcHeapMax);
+    interpreter.getIsolate().setBudget(MAKE_PTR(Budget, options.budget));
+}
+
+Ptr<ProgramNode> compileProgram(const String& source, const RunOptions& options) {
+    Lexer lexer(source);
+    Vec<Token> tokens = lexer.tokenize();
+
+    Parser parser(tokens);
+    Ptr<ProgramNode> program = parser.parse();
+
+    TypeChecker checker;
+    checker.check(program);
+
+    ParallelAnalysis parallelAnalysis;
+    parallelAnalysis.analyze(program);
+    if (options.explainParallel) {
+        parallelAnalysis.printReport(std::cerr);
+    }
+
+    return program;
+}
+
+// Runs filename, or the already compiled program if one is given, and
+// returns the process exit code.
+int runFile(const String& filename, const Vec<String>& arguments, const RunOptions& options,
+    Ptr<ProgramNode> program = nullptr) {
+    Interpreter interpreter;
+    configureInterpreter(interpreter, options);
+    interpreter.getIsolate().setArguments(arguments);
+
+    int exitCode = 0;
+    String exceeded;
+
+    try {
+        if (!program) {
+            program = compileProgram(readFile(filename), options);
+        }
         interpreter.execute(program);
     }
 
+    catch (const BudgetExceededError& e) {
+        std::cerr << e.formatMessage() << std::endl;
+        exceeded = e.resource;
+        exitCode = 1;
+    }
+
     catch (const CompilerError& e) {
         std::cerr << e.formatMessage() << std::endl;
-        std::exit(1);
+        exitCode = 1;
+    }
+
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exitCode = 1;
+    }
+
+    if (options.gcStats) {
+        printGcStats(interpreter.getHeap());
+        printBudgetStats(*interpreter.getIsolate().getBudget(), exceeded);
+    }
+
+    return exitCode;
+}
+
+// Compiles the preloaded scripts up front so forked children start from
+// their AST; any other script is compiled by the child that runs it.
+// Nothing here may start a thread before the server forks.
+int runZygote(const String& socketPath, const Vec<String>& preload, const RunOptions& options) {
+    Map<String, Ptr<ProgramNode>> programs;
+
+    try {
+        BuiltinRegistry::instance();
+        for (auto& script : preload) {
+            programs[Zygote::resolvePath(script)] = compileProgram(readFile(script), options);
+        }
+
+        Zygote::serve(socketPath, [&](const String& script, const Vec<String>& arguments) {
+            auto it = programs.find(script);
+            return runFile(script, arguments, options, it != programs.end() ? it->second : nullptr);
+        });
+    }
+    catch (const CompilerError& e) {
+        std::cerr << e.formatMessage() << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    return 1;
+}
+
+// One run per non-empty line of the inputs file; the words on the line are
+// the script arguments.
+Vec<Vec<String>> readBatchInputs(const String& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
     }
 
+    Vec<Vec<String>> inputs;
+    String line;
+    while (std::getline(file, line)) {
+        std::istringstream words(line);
+        Vec<String> arguments;
+        String word;
+        while (words >> word) {
+            arguments.push_back(word);
+        }
+        if (!arguments.empty()) {
+            inputs.push_back(std::move(arguments));
+        }
+    }
+    return inputs;
+}
+
+// Compiles the program once and runs it for every input on the shared
+// pool, each run in a fresh interpreter with its own globals, heap and
+// budget. The AST is only read while running. Output of each run is
+// captured and written in input order as soon as all earlier runs have
+// finished. With --time-slice the runs go through a Scheduler instead, so
+// a long run shares its thread with the others rather than blocking them.
+void runBatch(const String& programFile, const String& inputsFile, const RunOptions& options) {
+    Ptr<ProgramNode> program;
+    Vec<Vec<String>> inputs;
+
+    try {
+        program = compileProgram(readFile(programFile), options);
+        inputs = readBatchInputs(inputsFile);
+    }
+    catch (const CompilerError& e) {
+        std::cerr << e.formatMessage() << std::endl;
+        std::exit(1);
+    }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         std::exit(1);
     }
+
+    struct BatchRun {
+        String output;
+        String error;
+        bool overBudget = false;
+        bool done = false;
+    };
+
+    Vec<BatchRun> runs(inputs.size());
+    std::mutex emitMutex;
+    size_t nextToEmit = 0;
+
+    auto started = std::chrono::steady_clock::now();
+
+    auto runOne = [&](size_t index) {
+        BatchRun& run = runs[index];
+        std::ostringstream output;
+
+        {
+            Interpreter interpreter;
+            configureInterpreter(interpreter, options);
+            interpreter.getIsolate().setArguments(inputs[index]);
+            interpreter.getIsolate().setOutput(&output);
+
+            try {
+                interpreter.execute(program);
+            }
+            catch (const BudgetExceededError& e) {
+                run.error = e.formatMessage();
+                run.overBudget = true;
+            }
+            catch (const CompilerError& e) {
+                run.error = e.formatMessage();
+            }
+            catch (const std::exception& e) {
+                run.error = String("Error: ") + e.what();
+            }
+        }
+        run.output = output.str();
+
+        std::lock_guard<std::mutex> lock(emitMutex);
+        run.done = true;
+        while (nextToEmit < runs.size() && runs[nextToEmit].done) {
+            BatchRun& ready = runs[nextToEmit];
+            std::cout << ready.output;
+            if (!ready.error.empty()) {
+                std::cerr << "[run " << nextToEmit + 1 << "] " << ready.error << std::endl;
+            }
+            String().swap(ready.output);
+            nextToEmit++;
+        }
+    };
+
+    size_t yields = 0;
+    if (options.timeSliceMs > 0) {
+        Scheduler scheduler(ThreadPool::defaultSize(), Constants::SCHEDULER_SLOTS_PER_THREAD,
+            std::chrono::milliseconds(options.timeSliceMs));
+        scheduler.run(inputs.size(), runOne);
+        yields = scheduler.getStats().yields;
+    }
+    else {
+        ThreadPool::shared().run(inputs.size(), [&](size_t index, size_t /*participant*/) {
+            runOne(index);
+        });
+    }
+    std::cout.flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    size_t failed = 0;
+    size_t overBudget = 0;
+    for (auto& run : runs) {
+        if (!run.error.empty()) {
+            failed++;
+        }
+        if (run.overBudget) {
+            overBudget++;
+        }
+    }
+
+    std::cerr << "[batch] " << runs.size() << " runs in " << seconds * 1000.0 << " ms ("
+        << (seconds > 0.0 ? runs.size() / seconds : 0.0) << " runs/sec), "
+        << failed << " failed (" << overBudget << " over budget)";
+    if (options.timeSliceMs > 0) {
+        std::cerr << ", " << yields << " preemptions";
+    }
+    std::cerr << std::endl;
+
+    if (failed > 0) {
+        std::exit(1);
+    }
+}
+
+// --selftest-isolates <n>: runs one script in n interpreters at once,
+// first each on its own parsed program and then all on one shared
+// program, and checks every run prints what a lone run prints. Build with
+// -fsanitize=thread to check the isolates for data races too.
+int runIsolateSelfTest(size_t count, const RunOptions& options) {
+    static const char* SOURCE = R"npp(define func[fib]: [int n], {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+define func[Main]: [], {
+    define int[total]: [0];
+    define string[text]: [""];
+    for i: [1, 2000], {
+        total: total + fib(i % 15);
+        if (random.int(1, 1000) > 0) {
+            total: total + 1;
+        }
+        text: string.upper(string.substring("isolates", 0, i % 8 + 1));
+        if (i % 500 == 0) {
+            system.gc();
+        }
+    }
+    console.print(total, text);
 }
+)npp";
+
+    auto runOnce = [&](const Ptr<ProgramNode>& program, String& output, String& error) {
+        std::ostringstream captured;
+        Interpreter interpreter;
+        configureInterpreter(interpreter, options);
+        interpreter.getIsolate().setOutput(&captured);
+
+        try {
+            interpreter.execute(program ? program : compileProgram(SOURCE, options));
+        }
+        catch (const CompilerError& e) {
+            error = e.formatMessage();
+        }
+        catch (const std::exception& e) {
+            error = String("Error: ") + e.what();
+        }
+        output = captured.str();
+    };
 
-void runREPL() {
+    String expected;
+    String expectedError;
+    runOnce(nullptr, expected, expectedError);
+    if (!expectedError.empty()) {
+        std::cerr << "[selftest] reference run failed: " << expectedError << std::endl;
+        return 1;
+    }
+
+    size_t failed = 0;
+    for (bool shared : { false, true }) {
+        Ptr<ProgramNode> program = shared ? compileProgram(SOURCE, options) : nullptr;
+        Vec<String> outputs(count);
+        Vec<String> errors(count);
+
+        Vec<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([&, i] { runOnce(program, outputs[i], errors[i]); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (errors[i].empty() && outputs[i] == expected) {
+                continue;
+            }
+            failed++;
+            std::cerr << "[selftest] isolate " << i << (shared ? " (shared program): " : " (own program): ")
+                << (errors[i].empty() ? "printed " + outputs[i] : errors[i]) << std::endl;
+        }
+    }
+
+    std::cerr << "[selftest] " << count << " isolates, own and shared programs: "
+        << (failed == 0 ? String("ok") : std::to_string(failed) + " failed") << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+void runREPL(const RunOptions& options) {
     std::cout << "Language REPL v" << Constants::VERSION << std::endl;
     std::cout << "Type 'exit' to quit" << std::endl;
 
-    BuiltinRegistry::instance().registerAll();
-
+    TypeChecker checker;
+    ParallelAnalysis parallelAnalysis;
     Interpreter interpreter;
     String line;
 
@@ -74,6 +420,11 @@ void runREPL() {
             Parser parser(tokens);
             Ptr<ProgramNode> program = parser.parse();
 
+            checker.check(program);
+            parallelAnalysis.analyze(program);
+
+            // Each line gets the whole budget.
+            configureInterpreter(interpreter, options);
             interpreter.execute(program);
 
         }
@@ -84,22 +435,142 @@ void runREPL() {
             std::cerr << "Error: " << e.what() << std::endl;
         }
     }
+
+    if (options.gcStats) {
+        printGcStats(interpreter.getHeap());
+    }
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <filename.npp>" << std::endl;
-        std::cout << "   or: " << argv[0] << " --repl" << std::endl;
+        std::cout << "Usage: " << argv[0] << " [options] <filename.npp> [arguments...]" << std::endl;
+        std::cout << "   or: " << argv[0] << " [options] --batch <filename.npp> <inputs-file>" << std::endl;
+        std::cout << "   or: " << argv[0] << " [options] --zygote <socket> [preload.npp...]" << std::endl;
+        std::cout << "   or: " << argv[0] << " --connect <socket> <filename.npp> [arguments...]" << std::endl;
+        std::cout << "   or: " << argv[0] << " [options] --repl" << std::endl;
+        std::cout << "   or: " << argv[0] << " [options] --selftest-isolates <n>" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --gc-heap-max <size>   Limit the script heap (e.g. 64M, 1G)" << std::endl;
+        std::cout << "  --gc-stats             Print garbage collector and budget statistics on exit" << std::endl;
+        std::cout << "  --threads <n>          Cap threads used by parallel for (default: all cores)" << std::endl;
+        std::cout << "  --explain-parallel     Report which for loops run in parallel and why" << std::endl;
+        std::cout << "  --max-steps <n>        Stop a run after n loop iterations and calls" << std::endl;
+        std::cout << "  --max-time <ms>        Stop a run after ms milliseconds of wall time" << std::endl;
+        std::cout << "  --time-slice <ms>      Time-slice --batch runs over the threads, ms per turn" << std::endl;
+        std::cout << "  --async-output         Write console output from a background thread" << std::endl;
         return 1;
     }
 
-    String arg = argv[1];
+    RunOptions options;
+    String filename;
+    String inputsFile;
+    String zygoteSocket;
+    String connectSocket;
+    Vec<String> arguments;
+    Vec<String> preload;
+    bool repl = false;
+    bool batch = false;
+    bool asyncOutput = false;
+    size_t selfTestIsolates = 0;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            String arg = argv[i];
 
-    if (arg == "--repl" || arg == "-r") {
-        runREPL();
+            // Everything after the script name belongs to the script.
+            if (!filename.empty() && !batch) {
+                arguments.push_back(arg);
+            }
+            else if (arg == "--repl" || arg == "-r") {
+                repl = true;
+            }
+            else if (arg == "--gc-stats") {
+                options.gcStats = true;
+            }
+            else if (arg == "--async-output") {
+                asyncOutput = true;
+            }
+            else if (arg == "--explain-parallel") {
+                options.explainParallel = true;
+            }
+            else if (arg == "--gc-heap-max" && i + 1 < argc) {
+                options.gcHeapMax = parseByteSize(argv[++i]);
+            }
+            else if (arg == "--max-steps" && i + 1 < argc) {
+                options.budget.maxSteps = std::stoull(argv[++i]);
+            }
+            else if (arg == "--max-time" && i + 1 < argc) {
+                options.budget.maxMilliseconds = std::stoll(argv[++i]);
+            }
+            else if (arg == "--time-slice" && i + 1 < argc) {
+                options.timeSliceMs = std::stoll(argv[++i]);
+                if (options.timeSliceMs < 1) {
+                    throw std::runtime_error("--time-slice must be at least 1 ms");
+                }
+            }
+            else if (arg == "--batch" && i + 2 < argc) {
+                batch = true;
+                filename = argv[++i];
+                inputsFile = argv[++i];
+            }
+            else if (arg == "--zygote" && i + 1 < argc) {
+                zygoteSocket = argv[++i];
+            }
+            else if (arg == "--selftest-isolates" && i + 1 < argc) {
+                int count = std::stoi(argv[++i]);
+                if (count < 1) {
+                    throw std::runtime_error("--selftest-isolates must be at least 1");
+                }
+                selfTestIsolates = static_cast<size_t>(count);
+            }
+            else if (arg == "--connect" && i + 1 < argc) {
+                connectSocket = argv[++i];
+            }
+            else if (arg == "--threads" && i + 1 < argc) {
+                int threads = std::stoi(argv[++i]);
+                if (threads < 1) {
+                    throw std::runtime_error("--threads must be at least 1");
+                }
+                ThreadPool::setDefaultSize(static_cast<size_t>(threads));
+            }
+            else if (!zygoteSocket.empty()) {
+                preload.push_back(arg);
+            }
+            else if (filename.empty()) {
+                filename = arg;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    ConsoleOutput::install(asyncOutput ? ConsoleOutput::Mode::ASYNC : ConsoleOutput::Mode::BUFFERED);
+
+    if (repl) {
+        runREPL(options);
+    }
+    else if (selfTestIsolates > 0) {
+        return runIsolateSelfTest(selfTestIsolates, options);
+    }
+    else if (!zygoteSocket.empty()) {
+        return runZygote(zygoteSocket, preload, options);
+    }
+    else if (!connectSocket.empty()) {
+        try {
+            return Zygote::connect(connectSocket, filename, arguments);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    else if (batch) {
+        runBatch(filename, inputsFile, options);
     }
     else {
-        runFile(arg);
+        return runFile(filename, arguments, options);
     }
 
     return 0;
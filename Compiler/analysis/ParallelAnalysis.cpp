@@ -0,0 +1,665 @@
+#include "ParallelAnalysis.h"
+#include "../utils/Error.h"
+#include "../builtins/builtins.h"
+#include "../utils/StringUtil.h"
+
+namespace {
+    String reductionName(ReductionKind kind) {
+        switch (kind) {
+        case ReductionKind::SUM: return "sum";
+        case ReductionKind::MIN: return "min";
+        case ReductionKind::MAX: return "max";
+        case ReductionKind::COUNT: return "count";
+        default: return "?";
+        }
+    }
+
+    bool isIdentifier(const Ptr<ASTNode>& node, const String& name) {
+        return node && node->nodeType == ASTNodeType::IDENTIFIER &&
+            static_cast<IdentifierNode*>(node.get())->name == name;
+    }
+}
+
+void ParallelAnalysis::analyze(Ptr<ProgramNode> program) {
+    for (auto& def : program->definitions) {
+        if (def->nodeType == ASTNodeType::FUNC_DEFINITION) {
+            auto func = static_cast<FuncDefinitionNode*>(def.get());
+            functions[func->name] = func;
+        }
+    }
+
+    for (auto& def : program->definitions) {
+        if (def->nodeType == ASTNodeType::FUNC_DEFINITION) {
+            auto func = static_cast<FuncDefinitionNode*>(def.get());
+            analyzeBlock(func, func->body);
+
+            String reason;
+            func->pure = isPureFunction(func->name, reason);
+
+            rules = CallRules::PARALLEL_SAFE;
+            func->parallelSafe = isPureFunction(func->name, reason);
+            rules = CallRules::PURE;
+        }
+    }
+}
+
+void ParallelAnalysis::printReport(std::ostream& out) const {
+    for (auto& report : reports) {
+        out << "[parallel] " << report.function << ":" << report.line << " "
+            << (report.parallel ? "parallel" : "sequential") << ": " << report.detail << std::endl;
+    }
+}
+
+void ParallelAnalysis::analyzeBlock(FuncDefinitionNode* func, const Vec<Ptr<ASTNode>>& body) {
+    for (auto& stmt : body) {
+        if (stmt->nodeType == ASTNodeType::IF_STMT) {
+            auto ifNode = static_cast<IfNode*>(stmt.get());
+            analyzeBlock(func, ifNode->thenBranch);
+            for (auto& branch : ifNode->elseIfBranches) {
+                analyzeBlock(func, branch.body);
+            }
+            analyzeBlock(func, ifNode->elseBranch);
+            continue;
+        }
+
+        if (stmt->nodeType != ASTNodeType::FOR_STMT) {
+            continue;
+        }
+
+        auto loop = static_cast<ForNode*>(stmt.get());
+        if (loop->parallel) {
+            checkExplicitBody(loop);
+            reports.push_back({ func->name, loop->line, true, "explicit parallel for" });
+            continue;
+        }
+        if (loop->source) {
+            reports.push_back({ func->name, loop->line, false, "iterates a reader" });
+            analyzeBlock(func, loop->body);
+            continue;
+        }
+
+        Vec<Reduction> reductions;
+        String reason;
+        if (!classifyLoop(func, loop, reductions, reason)) {
+            reports.push_back({ func->name, loop->line, false, reason });
+            analyzeBlock(func, loop->body);
+            continue;
+        }
+
+        Vec<String> clauses;
+        for (auto& reduction : reductions) {
+            clauses.push_back(reductionName(reduction.kind) + "[" + reduction.variable + "]");
+        }
+
+        loop->parallel = true;
+        loop->autoParallel = true;
+        loop->pureBody = true;
+        loop->reductions = reductions;
+        reports.push_back({ func->name, loop->line, true,
+            clauses.empty() ? "no reductions" : StringUtil::join(clauses, ", ") });
+    }
+}
+
+bool ParallelAnalysis::classifyLoop(FuncDefinitionNode* func, ForNode* loop, Vec<Reduction>& reductions, String& reason) {
+    String bodyReason;
+    forEachStatement(loop->body, [&](ASTNode* stmt) {
+        if (!bodyReason.empty()) return;
+        if (stmt->nodeType == ASTNodeType::RETURN_STMT) {
+            bodyReason = "returns from the loop body";
+        }
+        else if (stmt->nodeType == ASTNodeType::FOR_STMT && static_cast<ForNode*>(stmt)->parallel) {
+            bodyReason = "contains an explicit parallel for";
+        }
+        else if (stmt->nodeType == ASTNodeType::FOR_STMT && static_cast<ForNode*>(stmt)->source) {
+            bodyReason = "reads lines from a reader";
+        }
+    });
+    if (!bodyReason.empty()) {
+        reason = bodyReason;
+        return false;
+    }
+
+    if (!checkCallsInBlock(loop->body, reason)) {
+        return false;
+    }
+
+    std::set<String> locals{ loop->iterator };
+    collectDefinitions(loop->body, locals);
+
+    String carried = findCarriedLocal(loop->body, locals, loop->iterator);
+    if (!carried.empty()) {
+        reason = "'" + carried + "' may keep its value from an earlier iteration";
+        return false;
+    }
+
+    std::set<String> outsideUses;
+    collectOutsideUses(func->body, loop, outsideUses);
+    for (auto& name : locals) {
+        if (outsideUses.count(name)) {
+            reason = "'" + name + "' is also used outside the loop";
+            return false;
+        }
+    }
+
+    std::set<String> functionLocals;
+    for (auto& param : func->parameters) {
+        functionLocals.insert(param.name);
+    }
+    collectDefinitions(func->body, functionLocals);
+
+    Map<String, size_t> updates;
+    forEachStatement(loop->body, [&](ASTNode* stmt) {
+        if (!reason.empty() || stmt->nodeType != ASTNodeType::ASSIGNMENT) return;
+
+        auto assignment = static_cast<AssignmentNode*>(stmt);
+        const String& name = assignment->identifier;
+        if (locals.count(name)) return;
+
+        ReductionKind kind;
+        if (!matchReduction(assignment, kind)) {
+            reason = "assigns outer variable '" + name + "'";
+            return;
+        }
+        if (!functionLocals.count(name)) {
+            reason = "accumulates into global '" + name + "'";
+            return;
+        }
+
+        StaticType type = assignment->value->staticType;
+        if (type == StaticType::FLOAT && kind == ReductionKind::SUM) {
+            reason = "float sum into '" + name + "' depends on evaluation order";
+            return;
+        }
+        if (type != StaticType::INT && type != StaticType::FLOAT) {
+            reason = "accumulator '" + name + "' is not statically numeric";
+            return;
+        }
+
+        for (auto& existing : reductions) {
+            if (existing.variable == name) {
+                if (existing.kind != kind) {
+                    reason = "mixes reductions on '" + name + "'";
+                }
+                updates[name]++;
+                return;
+            }
+        }
+
+        reductions.push_back({ kind, name, type });
+        updates[name]++;
+    });
+    if (!reason.empty()) {
+        return false;
+    }
+
+    for (auto& reduction : reductions) {
+        if (countReads(loop->body, reduction.variable) != updates[reduction.variable]) {
+            reason = "reads accumulator '" + reduction.variable + "' outside its update";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Workers keep what they create on their own heaps and run at the same
+// time, so a call that stores into a shared object would race with the
+// other workers and leave the object holding values another heap frees.
+void ParallelAnalysis::checkExplicitBody(ForNode* loop) {
+    String reason;
+    forEachStatement(loop->body, [&](ASTNode* stmt) {
+        if (reason.empty() && stmt->nodeType == ASTNodeType::FOR_STMT && static_cast<ForNode*>(stmt)->source) {
+            reason = "reads lines from a reader";
+        }
+    });
+
+    rules = CallRules::PARALLEL_SAFE;
+    bool safe = reason.empty() && checkCallsInBlock(loop->body, reason);
+    rules = CallRules::PURE;
+
+    if (!safe) {
+        throw TypeError("A parallel for body may not change shared objects or readers, but it " +
+            reason, loop->line);
+    }
+
+    String impurity;
+    loop->pureBody = checkCallsInBlock(loop->body, impurity);
+}
+
+bool ParallelAnalysis::isPureFunction(const String& name, String& reason) {
+    Map<String, Purity>& purity = this->purity[static_cast<size_t>(rules)];
+    Map<String, String>& impurityReasons = this->impurityReasons[static_cast<size_t>(rules)];
+
+    auto state = purity.find(name);
+    if (state != purity.end()) {
+        if (state->second == Purity::IMPURE) {
+            reason = impurityReasons[name];
+            return false;
+        }
+        // CHECKING means a recursive call; it is pure if the rest of the
+        // cycle turns out to be.
+        return true;
+    }
+
+    auto funcIt = functions.find(name);
+    if (funcIt == functions.end()) {
+        reason = "calls unknown function '" + name + "'";
+        return false;
+    }
+
+    FuncDefinitionNode* func = funcIt->second;
+    purity[name] = Purity::CHECKING;
+    checkingDepth++;
+
+    std::set<String> locals;
+    for (auto& param : func->parameters) {
+        locals.insert(param.name);
+    }
+    collectDefinitions(func->body, locals);
+
+    String why;
+    forEachStatement(func->body, [&](ASTNode* stmt) {
+        if (why.empty() && stmt->nodeType == ASTNodeType::ASSIGNMENT) {
+            auto assignment = static_cast<AssignmentNode*>(stmt);
+            if (!locals.count(assignment->identifier)) {
+                why = "assigns global '" + assignment->identifier + "'";
+            }
+        }
+        else if (why.empty() && stmt->nodeType == ASTNodeType::FOR_STMT && static_cast<ForNode*>(stmt)->source) {
+            why = "reads lines from a reader";
+        }
+    });
+
+    if (why.empty()) {
+        checkCallsInBlock(func->body, why);
+    }
+
+    checkingDepth--;
+
+    if (!why.empty()) {
+        purity[name] = Purity::IMPURE;
+        impurityReasons[name] = "calls '" + name + "', which " + why;
+        reason = impurityReasons[name];
+        return false;
+    }
+
+    // A verdict reached while an enclosing caller is still being checked
+    // assumed that caller pure; only keep it once the whole cycle is known.
+    if (checkingDepth == 0) {
+        purity[name] = Purity::PURE;
+    }
+    else {
+        purity.erase(name);
+    }
+    return true;
+}
+
+bool ParallelAnalysis::checkCalls(ASTNode* expr, String& reason) {
+    bool pure = true;
+
+    forEachSubexpression(expr, [&](ASTNode* node) {
+        if (!pure) return;
+
+        if (node->nodeType == ASTNodeType::SPAWN_EXPR || node->nodeType == ASTNodeType::AWAIT_EXPR) {
+            reason = node->nodeType == ASTNodeType::SPAWN_EXPR ? "spawns a task" : "awaits a task";
+            pure = false;
+            return;
+        }
+        if (node->nodeType != ASTNodeType::CALL_EXPR) return;
+
+        const String& callee = static_cast<CallExprNode*>(node)->callee;
+        if (BuiltinRegistry::instance().hasFunction(callee)) {
+            if (!allowsBuiltin(callee)) {
+                reason = "calls " + callee;
+                pure = false;
+            }
+        }
+        else if (!isPureFunction(callee, reason)) {
+            pure = false;
+        }
+    });
+
+    return pure;
+}
+
+bool ParallelAnalysis::checkCallsInBlock(const Vec<Ptr<ASTNode>>& body, String& reason) {
+    bool pure = true;
+
+    forEachStatement(body, [&](ASTNode* stmt) {
+        forEachExpression(stmt, [&](ASTNode* expr) {
+            if (pure && !checkCalls(expr, reason)) {
+                pure = false;
+            }
+        });
+    });
+
+    return pure;
+}
+
+void ParallelAnalysis::forEachStatement(const Vec<Ptr<ASTNode>>& body, const StatementVisitor& visit) {
+    for (auto& stmt : body) {
+        visit(stmt.get());
+
+        if (stmt->nodeType == ASTNodeType::IF_STMT) {
+            auto ifNode = static_cast<IfNode*>(stmt.get());
+            forEachStatement(ifNode->thenBranch, visit);
+            for (auto& branch : ifNode->elseIfBranches) {
+                forEachStatement(branch.body, visit);
+            }
+            forEachStatement(ifNode->elseBranch, visit);
+        }
+        else if (stmt->nodeType == ASTNodeType::FOR_STMT) {
+            forEachStatement(static_cast<ForNode*>(stmt.get())->body, visit);
+        }
+    }
+}
+
+void ParallelAnalysis::forEachExpression(ASTNode* stmt, const ExpressionVisitor& visit) {
+    switch (stmt->nodeType) {
+    case ASTNodeType::VAR_DEFINITION:
+        for (auto& value : static_cast<VarDefinitionNode*>(stmt)->values) {
+            visit(value.get());
+        }
+        break;
+    case ASTNodeType::ASSIGNMENT:
+        visit(static_cast<AssignmentNode*>(stmt)->value.get());
+        break;
+    case ASTNodeType::RETURN_STMT:
+        if (auto& value = static_cast<ReturnNode*>(stmt)->value) {
+            visit(value.get());
+        }
+        break;
+    case ASTNodeType::IF_STMT: {
+        auto ifNode = static_cast<IfNode*>(stmt);
+        visit(ifNode->condition.get());
+        for (auto& branch : ifNode->elseIfBranches) {
+            visit(branch.condition.get());
+        }
+        break;
+    }
+    case ASTNodeType::FOR_STMT: {
+        auto loop = static_cast<ForNode*>(stmt);
+        if (loop->source) {
+            visit(loop->source.get());
+        }
+        else {
+            visit(loop->start.get());
+            visit(loop->end.get());
+        }
+        break;
+    }
+    case ASTNodeType::STRUCT_DEFINITION:
+    case ASTNodeType::FUNC_DEFINITION:
+        break;
+    default:
+        visit(stmt);
+        break;
+    }
+}
+
+void ParallelAnalysis::forEachSubexpression(ASTNode* expr, const ExpressionVisitor& visit) {
+    if (!expr) {
+        return;
+    }
+
+    visit(expr);
+
+    switch (expr->nodeType) {
+    case ASTNodeType::BINARY_EXPR: {
+        auto binary = static_cast<BinaryExprNode*>(expr);
+        forEachSubexpression(binary->left.get(), visit);
+        forEachSubexpression(binary->right.get(), visit);
+        break;
+    }
+    case ASTNodeType::UNARY_EXPR:
+        forEachSubexpression(static_cast<UnaryExprNode*>(expr)->operand.get(), visit);
+        break;
+    case ASTNodeType::TERNARY_EXPR: {
+        auto ternary = static_cast<TernaryExprNode*>(expr);
+        forEachSubexpression(ternary->condition.get(), visit);
+        forEachSubexpression(ternary->trueExpr.get(), visit);
+        forEachSubexpression(ternary->falseExpr.get(), visit);
+        break;
+    }
+    case ASTNodeType::CALL_EXPR:
+        for (auto& arg : static_cast<CallExprNode*>(expr)->arguments) {
+            forEachSubexpression(arg.get(), visit);
+        }
+        break;
+    case ASTNodeType::SPAWN_EXPR:
+        forEachSubexpression(static_cast<SpawnExprNode*>(expr)->call.get(), visit);
+        break;
+    case ASTNodeType::AWAIT_EXPR:
+        forEachSubexpression(static_cast<AwaitExprNode*>(expr)->task.get(), visit);
+        break;
+    default:
+        break;
+    }
+}
+
+bool ParallelAnalysis::isPureBuiltin(const String& name) {
+    return StringUtil::startsWith(name, "math.") || StringUtil::startsWith(name, "string.");
+}
+
+bool ParallelAnalysis::allowsBuiltin(const String& name) const {
+    return rules == CallRules::PURE ? isPureBuiltin(name) : isParallelSafeBuiltin(name);
+}
+
+// Builtins that only read their arguments or build new values, plus
+// console output, which is serialized, channels, which are shared between
+// threads by design, and random numbers, which each worker draws from its
+// own stream. random.fillInts() and fillFloats() store into a buffer.
+bool ParallelAnalysis::isParallelSafeBuiltin(const String& name) {
+    static const std::set<String> safe = {
+        "array.length", "array.get",
+        "bytes.make", "bytes.slice", "bytes.length",
+        "bytes.getInt", "bytes.getUint", "bytes.getFloat", "bytes.getString",
+        "json.object", "json.get", "json.keys", "json.parse", "json.stringify",
+        "console.print", "console.write", "console.error", "console.flush",
+        "channel.send", "channel.recv", "channel.tryRecv", "channel.close",
+        "random.int", "random.float", "random.bytes", "random.ints", "random.floats",
+        "random.seed", "random.jump",
+    };
+    return isPureBuiltin(name) || safe.count(name) > 0;
+}
+
+// True if expr is x plus or minus terms that do not read x, with x itself
+// added rather than subtracted, e.g. `x + a - b` or `a + x`.
+bool ParallelAnalysis::isSumInto(ASTNode* expr, const String& name) {
+    if (expr->nodeType == ASTNodeType::IDENTIFIER) {
+        return static_cast<IdentifierNode*>(expr)->name == name;
+    }
+    if (expr->nodeType != ASTNodeType::BINARY_EXPR) {
+        return false;
+    }
+
+    auto binary = static_cast<BinaryExprNode*>(expr);
+    if (binary->opCode == BinaryOp::ADD) {
+        return (isSumInto(binary->left.get(), name) && countReads(binary->right.get(), name) == 0) ||
+            (isSumInto(binary->right.get(), name) && countReads(binary->left.get(), name) == 0);
+    }
+    if (binary->opCode == BinaryOp::SUB) {
+        return isSumInto(binary->left.get(), name) && countReads(binary->right.get(), name) == 0;
+    }
+    return false;
+}
+
+// Recognizes sums into x (see isSumInto), and `x: math.min(x, e)` or
+// `x: math.max(x, e)` in either argument order where e does not read x.
+bool ParallelAnalysis::matchReduction(AssignmentNode* node, ReductionKind& kind) {
+    const String& name = node->identifier;
+    ASTNode* value = node->value.get();
+
+    if (value->nodeType == ASTNodeType::BINARY_EXPR) {
+        kind = ReductionKind::SUM;
+        return isSumInto(value, name);
+    }
+
+    if (value->nodeType == ASTNodeType::CALL_EXPR) {
+        auto call = static_cast<CallExprNode*>(value);
+        if (call->arguments.size() != 2) {
+            return false;
+        }
+        if (call->callee == "math.min") kind = ReductionKind::MIN;
+        else if (call->callee == "math.max") kind = ReductionKind::MAX;
+        else return false;
+
+        const auto& a = call->arguments[0];
+        const auto& b = call->arguments[1];
+        return (isIdentifier(a, name) && countReads(b.get(), name) == 0) ||
+            (isIdentifier(b, name) && countReads(a.get(), name) == 0);
+    }
+
+    return false;
+}
+
+size_t ParallelAnalysis::countReads(ASTNode* expr, const String& name) {
+    size_t reads = 0;
+    forEachSubexpression(expr, [&](ASTNode* node) {
+        if (node->nodeType == ASTNodeType::IDENTIFIER && static_cast<IdentifierNode*>(node)->name == name) {
+            reads++;
+        }
+        else if (node->nodeType == ASTNodeType::MEMBER_ACCESS && static_cast<MemberAccessNode*>(node)->object == name) {
+            reads++;
+        }
+    });
+    return reads;
+}
+
+size_t ParallelAnalysis::countReads(const Vec<Ptr<ASTNode>>& body, const String& name) {
+    size_t reads = 0;
+    forEachStatement(body, [&](ASTNode* stmt) {
+        forEachExpression(stmt, [&](ASTNode* expr) {
+            reads += countReads(expr, name);
+        });
+    });
+    return reads;
+}
+
+void ParallelAnalysis::collectDefinitions(const Vec<Ptr<ASTNode>>& body, std::set<String>& names) {
+    forEachStatement(body, [&](ASTNode* stmt) {
+        if (stmt->nodeType == ASTNodeType::VAR_DEFINITION) {
+            for (auto& name : static_cast<VarDefinitionNode*>(stmt)->names) {
+                names.insert(name);
+            }
+        }
+        else if (stmt->nodeType == ASTNodeType::FOR_STMT) {
+            names.insert(static_cast<ForNode*>(stmt)->iterator);
+        }
+    });
+}
+
+// Names read or assigned outside `loop`. Inside another for loop its own
+// iterator is rebound first, so uses of that name there do not count.
+void ParallelAnalysis::collectOutsideUses(const Vec<Ptr<ASTNode>>& body, const ASTNode* loop, std::set<String>& names) {
+    std::function<void(const Vec<Ptr<ASTNode>>&, const std::set<String>&)> walk =
+        [&](const Vec<Ptr<ASTNode>>& block, const std::set<String>& bound) {
+        auto use = [&](const String& name) {
+            if (!bound.count(name)) names.insert(name);
+        };
+
+        for (auto& stmt : block) {
+            if (stmt.get() == loop) {
+                continue;
+            }
+
+            forEachExpression(stmt.get(), [&](ASTNode* expr) {
+                forEachSubexpression(expr, [&](ASTNode* node) {
+                    if (node->nodeType == ASTNodeType::IDENTIFIER) {
+                        use(static_cast<IdentifierNode*>(node)->name);
+                    }
+                    else if (node->nodeType == ASTNodeType::MEMBER_ACCESS) {
+                        use(static_cast<MemberAccessNode*>(node)->object);
+                    }
+                });
+            });
+
+            if (stmt->nodeType == ASTNodeType::ASSIGNMENT) {
+                use(static_cast<AssignmentNode*>(stmt.get())->identifier);
+            }
+            else if (stmt->nodeType == ASTNodeType::IF_STMT) {
+                auto ifNode = static_cast<IfNode*>(stmt.get());
+                walk(ifNode->thenBranch, bound);
+                for (auto& branch : ifNode->elseIfBranches) {
+                    walk(branch.body, bound);
+                }
+                walk(ifNode->elseBranch, bound);
+            }
+            else if (stmt->nodeType == ASTNodeType::FOR_STMT) {
+                auto inner = static_cast<ForNode*>(stmt.get());
+                std::set<String> innerBound = bound;
+                innerBound.insert(inner->iterator);
+                walk(inner->body, innerBound);
+            }
+        }
+    };
+
+    walk(body, {});
+}
+
+// Locals live in one frame for the whole function, so a loop local that an
+// iteration uses before it surely binds it may still hold the value an
+// earlier iteration left there. Workers start with none of them bound, so
+// such a loop cannot be split. Returns the first such local, or "".
+String ParallelAnalysis::findCarriedLocal(const Vec<Ptr<ASTNode>>& body, const std::set<String>& locals, const String& iterator) {
+    String carried;
+
+    std::function<void(const Vec<Ptr<ASTNode>>&, std::set<String>&)> walk =
+        [&](const Vec<Ptr<ASTNode>>& block, std::set<String>& bound) {
+        auto use = [&](const String& name) {
+            if (carried.empty() && locals.count(name) && !bound.count(name)) carried = name;
+        };
+
+        for (auto& stmt : block) {
+            forEachExpression(stmt.get(), [&](ASTNode* expr) {
+                forEachSubexpression(expr, [&](ASTNode* node) {
+                    if (node->nodeType == ASTNodeType::IDENTIFIER) {
+                        use(static_cast<IdentifierNode*>(node)->name);
+                    }
+                    else if (node->nodeType == ASTNodeType::MEMBER_ACCESS) {
+                        use(static_cast<MemberAccessNode*>(node)->object);
+                    }
+                });
+            });
+
+            if (stmt->nodeType == ASTNodeType::VAR_DEFINITION) {
+                for (auto& name : static_cast<VarDefinitionNode*>(stmt.get())->names) {
+                    bound.insert(name);
+                }
+            }
+            else if (stmt->nodeType == ASTNodeType::ASSIGNMENT) {
+                use(static_cast<AssignmentNode*>(stmt.get())->identifier);
+            }
+            else if (stmt->nodeType == ASTNodeType::IF_STMT) {
+                // Bound after the if only when every branch binds it; a
+                // missing else binds nothing.
+                auto ifNode = static_cast<IfNode*>(stmt.get());
+                std::set<String> after = bound;
+                walk(ifNode->thenBranch, after);
+                for (auto& branch : ifNode->elseIfBranches) {
+                    std::set<String> branchBound = bound;
+                    walk(branch.body, branchBound);
+                    for (auto it = after.begin(); it != after.end();) {
+                        it = branchBound.count(*it) ? std::next(it) : after.erase(it);
+                    }
+                }
+                std::set<String> elseBound = bound;
+                walk(ifNode->elseBranch, elseBound);
+                for (auto it = after.begin(); it != after.end();) {
+                    it = elseBound.count(*it) ? std::next(it) : after.erase(it);
+                }
+                bound = after;
+            }
+            else if (stmt->nodeType == ASTNodeType::FOR_STMT) {
+                auto inner = static_cast<ForNode*>(stmt.get());
+                std::set<String> innerBound = bound;
+                innerBound.insert(inner->iterator);
+                walk(inner->body, innerBound);
+            }
+        }
+    };
+
+    std::set<String> bound{ iterator };
+    walk(body, bound);
+    return carried;
+}
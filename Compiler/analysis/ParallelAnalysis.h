@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../Common.h"
+#include "../parser/AST.h"
+#include <functional>
+#include <ostream>
+#include <set>
+
+// Finds ordinary for loops that can run as parallel for loops without
+// changing the program's result, and marks them on the AST. A loop
+// qualifies when its body only calls pure builtins (math, string) and
+// functions that are pure themselves, writes nothing outside the body
+// except integer sums and int/float min/max accumulators held in locals,
+// and nothing it defines is read elsewhere in the function or, within an
+// iteration, before the iteration defines it. Float sums are left
+// sequential because their result depends on evaluation order.
+//
+// Explicit parallel for bodies are checked too, under looser rules: they
+// may also read arrays, byte buffers and objects, write to the console,
+// use channels and draw random numbers, but may not call builtins that
+// change a shared object or reader, since the workers run at once and
+// keep their values on their own heaps.
+//
+// Functions are marked pure, and parallel-safe under the looser rules,
+// so builtins such as parallel.map() know whether calls may run on
+// several threads at once.
+class ParallelAnalysis {
+public:
+    struct LoopReport {
+        String function;
+        int line;
+        bool parallel;
+        String detail;
+    };
+
+    void analyze(Ptr<ProgramNode> program);
+    void printReport(std::ostream& out) const;
+
+    const Vec<LoopReport>& getReports() const { return reports; }
+
+private:
+    enum class Purity { UNKNOWN, CHECKING, PURE, IMPURE };
+
+    // Which builtins a body may call: pure ones for loops parallelized
+    // here, and the parallel-safe ones too in explicit parallel fors.
+    enum class CallRules { PURE, PARALLEL_SAFE, COUNT };
+
+    Map<String, FuncDefinitionNode*> functions;
+    CallRules rules = CallRules::PURE;
+    Map<String, Purity> purity[static_cast<size_t>(CallRules::COUNT)];
+    Map<String, String> impurityReasons[static_cast<size_t>(CallRules::COUNT)];
+    int checkingDepth = 0;
+    Vec<LoopReport> reports;
+
+    void analyzeBlock(FuncDefinitionNode* func, const Vec<Ptr<ASTNode>>& body);
+    bool classifyLoop(FuncDefinitionNode* func, ForNode* loop, Vec<Reduction>& reductions, String& reason);
+
+    bool isPureFunction(const String& name, String& reason);
+    bool checkCalls(ASTNode* expr, String& reason);
+    bool checkCallsInBlock(const Vec<Ptr<ASTNode>>& body, String& reason);
+
+    using StatementVisitor = std::function<void(ASTNode*)>;
+    using ExpressionVisitor = std::function<void(ASTNode*)>;
+
+    static void forEachStatement(const Vec<Ptr<ASTNode>>& body, const StatementVisitor& visit);
+    static void forEachExpression(ASTNode* stmt, const ExpressionVisitor& visit);
+    static void forEachSubexpression(ASTNode* expr, const ExpressionVisitor& visit);
+
+    bool allowsBuiltin(const String& name) const;
+    void checkExplicitBody(ForNode* loop);
+
+    static bool isPureBuiltin(const String& name);
+    static bool isParallelSafeBuiltin(const String& name);
+    static bool matchReduction(AssignmentNode* node, ReductionKind& kind);
+    static bool isSumInto(ASTNode* expr, const String& name);
+    static size_t countReads(ASTNode* expr, const String& name);
+    static size_t countReads(const Vec<Ptr<ASTNode>>& body, const String& name);
+    static void collectDefinitions(const Vec<Ptr<ASTNode>>& body, std::set<String>& names);
+    static String findCarriedLocal(const Vec<Ptr<ASTNode>>& body, const std::set<String>& locals, const String& iterator);
+    static void collectOutsideUses(const Vec<Ptr<ASTNode>>& body, const ASTNode* loop, std::set<String>& names);
+};
@@ -0,0 +1,815 @@
+#include "TypeChecker.h"
+#include "../builtins/builtins.h"
+#include "../utils/Error.h"
+#include "../runtime/Operators.h"
+#include "../runtime/Json.h"
+#include "../utils/StringUtil.h"
+
+TypeChecker::TypeChecker() : locals(nullptr), parallelWritable(nullptr), reporting(true), currentLine(0) {}
+
+void TypeChecker::check(Ptr<ProgramNode> program) {
+    Vec<Ptr<FuncDefinitionNode>> newFunctions;
+    Vec<Ptr<VarDefinitionNode>> newGlobals;
+
+    for (auto& def : program->definitions) {
+        if (def->nodeType == ASTNodeType::STRUCT_DEFINITION) {
+            auto structDef = std::static_pointer_cast<StructDefinitionNode>(def);
+            StaticType builtin;
+            if (builtinType(structDef->name, builtin)) {
+                typeError("Cannot define struct '" + structDef->name + "': it is a built-in type", structDef->line);
+            }
+            structs[structDef->name] = structDef;
+        }
+        else if (def->nodeType == ASTNodeType::FUNC_DEFINITION) {
+            auto funcDef = std::static_pointer_cast<FuncDefinitionNode>(def);
+            if (functions.find(funcDef->name) != functions.end()) {
+                nameError("Function '" + funcDef->name + "' is already defined", funcDef->line);
+            }
+            functions[funcDef->name] = funcDef;
+            newFunctions.push_back(funcDef);
+        }
+        else if (def->nodeType == ASTNodeType::VAR_DEFINITION) {
+            newGlobals.push_back(std::static_pointer_cast<VarDefinitionNode>(def));
+        }
+    }
+
+    for (auto& def : program->definitions) {
+        if (def->nodeType == ASTNodeType::STRUCT_DEFINITION) {
+            auto structDef = std::static_pointer_cast<StructDefinitionNode>(def);
+            for (auto& field : structDef->fields) {
+                resolveType(field.type, structDef->line);
+            }
+        }
+    }
+
+    for (auto& func : newFunctions) {
+        for (auto& param : func->parameters) {
+            param.staticType = resolveType(param.type, func->line);
+        }
+    }
+
+    for (auto& global : newGlobals) {
+        StaticType declared = resolveType(global->type, global->line);
+        for (auto& name : global->names) {
+            declareVariable(name, declared, global->line);
+        }
+    }
+
+    inferReturnTypes(newFunctions);
+
+    for (auto& global : newGlobals) {
+        checkStatement(global);
+    }
+
+    for (auto& func : newFunctions) {
+        checkFunction(func.get());
+    }
+}
+
+// Return types are the least fixpoint over all function bodies: every
+// function starts as NEVER and is widened until no inferred type changes,
+// so recursive functions such as fib still come out as int.
+void TypeChecker::inferReturnTypes(const Vec<Ptr<FuncDefinitionNode>>& funcs) {
+    for (auto& func : funcs) {
+        returnTypes[func->name] = StaticType::NEVER;
+    }
+
+    reporting = false;
+
+    bool changed = true;
+    size_t maxPasses = funcs.size() * 2 + 2;
+
+    for (size_t pass = 0; changed && pass < maxPasses; ++pass) {
+        changed = false;
+        for (auto& func : funcs) {
+            StaticType inferred = checkFunction(func.get());
+            if (inferred != returnTypes[func->name]) {
+                returnTypes[func->name] = inferred;
+                changed = true;
+            }
+        }
+    }
+
+    reporting = true;
+
+    for (auto& func : funcs) {
+        if (changed || returnTypes[func->name] == StaticType::NEVER) {
+            returnTypes[func->name] = StaticType::UNKNOWN;
+        }
+    }
+}
+
+StaticType TypeChecker::checkFunction(FuncDefinitionNode* func) {
+    Map<String, StaticType> scope;
+    functionLocals.clear();
+    definite.clear();
+    for (auto& param : func->parameters) {
+        scope[param.name] = param.staticType;
+        definite.insert(param.name);
+    }
+    collectLocals(func->body);
+
+    locals = &scope;
+    returnStack.push_back(StaticType::NEVER);
+    currentLine = func->line;
+
+    checkBlock(func->body);
+
+    StaticType result = returnStack.back();
+    returnStack.pop_back();
+    locals = nullptr;
+
+    if (!definitelyReturns(func->body)) {
+        result = join(result, StaticType::NIL);
+    }
+
+    return result;
+}
+
+void TypeChecker::checkBlock(const Vec<Ptr<ASTNode>>& body) {
+    for (auto& stmt : body) {
+        checkStatement(stmt);
+    }
+}
+
+void TypeChecker::checkStatement(const Ptr<ASTNode>& node) {
+    if (node->line > 0) {
+        currentLine = node->line;
+    }
+
+    switch (node->nodeType) {
+    case ASTNodeType::VAR_DEFINITION:
+        checkVarDefinition(static_cast<VarDefinitionNode*>(node.get()));
+        break;
+    case ASTNodeType::ASSIGNMENT:
+        checkAssignment(static_cast<AssignmentNode*>(node.get()));
+        break;
+    case ASTNodeType::IF_STMT:
+        checkIf(static_cast<IfNode*>(node.get()));
+        break;
+    case ASTNodeType::FOR_STMT:
+        checkFor(static_cast<ForNode*>(node.get()));
+        break;
+    case ASTNodeType::RETURN_STMT:
+        checkReturn(static_cast<ReturnNode*>(node.get()));
+        break;
+    case ASTNodeType::STRUCT_DEFINITION:
+    case ASTNodeType::FUNC_DEFINITION:
+        break;
+    default:
+        infer(node);
+        break;
+    }
+}
+
+void TypeChecker::checkVarDefinition(VarDefinitionNode* node) {
+    StaticType declared = resolveType(node->type, node->line);
+
+    if (node->names.size() != node->values.size()) {
+        typeError("Mismatch between number of names and values in definition", node->line);
+    }
+
+    StaticType guard = StaticType::UNKNOWN;
+    for (size_t i = 0; i < node->values.size(); ++i) {
+        StaticType actual = infer(node->values[i]);
+        String name = i < node->names.size() ? node->names[i] : "";
+        if (guardFor(declared, actual, name, node->line) != StaticType::UNKNOWN) {
+            guard = declared;
+        }
+    }
+    node->guardType = guard;
+
+    for (auto& name : node->names) {
+        if (parallelWritable && !parallelWritable->count(name)) {
+            StaticType outer;
+            if (lookupVariable(name, outer)) {
+                typeError("Definition of '" + name + "' in a parallel for body shadows an outer variable", node->line);
+            }
+            parallelWritable->insert(name);
+        }
+        declareVariable(name, declared, node->line);
+        definite.insert(name);
+    }
+}
+
+void TypeChecker::checkAssignment(AssignmentNode* node) {
+    StaticType actual = infer(node->value);
+
+    StaticType declared;
+    if (!lookupVariable(node->identifier, declared)) {
+        nameError("Undefined variable: " + node->identifier, node->line);
+        node->guardType = StaticType::UNKNOWN;
+        return;
+    }
+
+    // Storing into the global would change its type for every other reader.
+    if (mixesGlobal(node->identifier)) {
+        typeError("Cannot assign to '" + node->identifier + "' here: it is only defined on some paths, "
+            "and on the others it is the global " + typeName(globals[node->identifier]), node->line);
+    }
+
+    node->guardType = guardFor(declared, actual, node->identifier, node->line);
+
+    if (parallelWritable && !parallelWritable->count(node->identifier)) {
+        typeError("Cannot assign to '" + node->identifier +
+            "' from a parallel for body; declare it as a reduction", node->line);
+    }
+}
+
+// A name is bound after the if when every branch that falls through binds
+// it; a missing else falls through with what was bound before.
+void TypeChecker::checkIf(IfNode* node) {
+    std::set<String> before = definite;
+    std::set<String> after;
+    bool reached = false;
+
+    auto checkBranch = [&](const Vec<Ptr<ASTNode>>& body) {
+        definite = before;
+        checkBlock(body);
+        if (definitelyReturns(body)) {
+            return;
+        }
+        if (!reached) {
+            after = definite;
+            reached = true;
+            return;
+        }
+        for (auto it = after.begin(); it != after.end();) {
+            it = definite.count(*it) ? std::next(it) : after.erase(it);
+        }
+    };
+
+    infer(node->condition);
+    checkBranch(node->thenBranch);
+
+    for (auto& branch : node->elseIfBranches) {
+        definite = before;
+        infer(branch.condition);
+        checkBranch(branch.body);
+    }
+
+    checkBranch(node->elseBranch);
+    definite = reached ? after : before;
+}
+
+void TypeChecker::checkFor(ForNode* node) {
+    if (node->source) {
+        checkForEach(node);
+        return;
+    }
+
+    StaticType start = infer(node->start);
+    StaticType end = infer(node->end);
+
+    auto isRange = [](StaticType t) {
+        return t == StaticType::INT || t == StaticType::UNKNOWN || t == StaticType::NEVER;
+    };
+
+    if (!isRange(start) || !isRange(end)) {
+        typeError("For loop range must be integers", node->line);
+    }
+
+    if (node->parallel) {
+        checkParallelFor(node);
+        return;
+    }
+
+    if (parallelWritable) {
+        parallelWritable->insert(node->iterator);
+    }
+
+    std::set<String> before = definite;
+    declareVariable(node->iterator, StaticType::INT, node->line);
+    definite.insert(node->iterator);
+    checkBlock(node->body);
+    definite = before;
+}
+
+// Readers are not safe to share between workers, so a parallel body may
+// not read lines at all. A line reader yields strings, a csv reader and a
+// walker arrays, and an ndjson reader whatever each line holds.
+void TypeChecker::checkForEach(ForNode* node) {
+    StaticType source = infer(node->source);
+
+    if (source != StaticType::READER && source != StaticType::CSV_READER &&
+        source != StaticType::NDJSON_READER && source != StaticType::DIR_WALKER &&
+        source != StaticType::UNKNOWN && source != StaticType::NEVER) {
+        typeError("For loop source must be a range or a reader, got " + typeName(source), node->line);
+    }
+
+    if (parallelWritable) {
+        typeError("Cannot read lines from a parallel for body", node->line);
+        parallelWritable->insert(node->iterator);
+    }
+
+    StaticType element = source == StaticType::CSV_READER || source == StaticType::DIR_WALKER ? StaticType::ARRAY
+        : source == StaticType::READER ? StaticType::STRING : StaticType::UNKNOWN;
+    std::set<String> before = definite;
+    declareVariable(node->iterator, element, node->line);
+    definite.insert(node->iterator);
+    checkBlock(node->body);
+    definite = before;
+}
+
+// A parallel body runs in per-worker frames, so it may only write its own
+// locals and its reduction variables, and nothing it defines is visible
+// after the loop.
+void TypeChecker::checkParallelFor(ForNode* node) {
+    std::set<String> writable{ node->iterator };
+
+    for (auto& reduction : node->reductions) {
+        StaticType type;
+        if (!lookupVariable(reduction.variable, type)) {
+            nameError("Undefined reduction variable: " + reduction.variable, node->line);
+            continue;
+        }
+
+        bool numeric = type == StaticType::INT ||
+            (type == StaticType::FLOAT && reduction.kind != ReductionKind::COUNT);
+        if (!numeric) {
+            typeError("Reduction variable '" + reduction.variable + "' cannot be " + typeName(type), node->line);
+        }
+        if (parallelWritable && !parallelWritable->count(reduction.variable)) {
+            typeError("Cannot reduce into '" + reduction.variable + "' from an enclosing parallel for body", node->line);
+        }
+
+        reduction.staticType = type;
+        writable.insert(reduction.variable);
+    }
+
+    Map<String, StaticType>& scope = locals ? *locals : globals;
+    std::set<String> outerNames;
+    for (auto& entry : scope) {
+        outerNames.insert(entry.first);
+    }
+
+    std::set<String>* enclosing = parallelWritable;
+    std::set<String> before = definite;
+    parallelWritable = &writable;
+    declareVariable(node->iterator, StaticType::INT, node->line);
+    definite.insert(node->iterator);
+    checkBlock(node->body);
+    parallelWritable = enclosing;
+    definite = before;
+
+    for (auto it = scope.begin(); it != scope.end();) {
+        it = outerNames.count(it->first) ? std::next(it) : scope.erase(it);
+    }
+}
+
+void TypeChecker::checkReturn(ReturnNode* node) {
+    StaticType actual = node->value ? infer(node->value) : StaticType::NIL;
+
+    if (parallelWritable) {
+        typeError("Cannot return from a parallel for body", node->line);
+    }
+
+    if (!returnStack.empty()) {
+        returnStack.back() = join(returnStack.back(), actual);
+    }
+}
+
+StaticType TypeChecker::infer(const Ptr<ASTNode>& node) {
+    if (!node) {
+        return StaticType::NIL;
+    }
+
+    StaticType result;
+
+    switch (node->nodeType) {
+    case ASTNodeType::BINARY_EXPR:
+        result = inferBinary(static_cast<BinaryExprNode*>(node.get()));
+        break;
+    case ASTNodeType::UNARY_EXPR:
+        result = inferUnary(static_cast<UnaryExprNode*>(node.get()));
+        break;
+    case ASTNodeType::TERNARY_EXPR:
+        result = inferTernary(static_cast<TernaryExprNode*>(node.get()));
+        break;
+    case ASTNodeType::CALL_EXPR:
+        result = inferCall(static_cast<CallExprNode*>(node.get()));
+        break;
+    case ASTNodeType::LITERAL:
+        result = inferLiteral(static_cast<LiteralNode*>(node.get()));
+        break;
+    case ASTNodeType::IDENTIFIER:
+        result = inferIdentifier(static_cast<IdentifierNode*>(node.get()));
+        break;
+    case ASTNodeType::SPAWN_EXPR:
+        result = inferSpawn(static_cast<SpawnExprNode*>(node.get()));
+        break;
+    case ASTNodeType::AWAIT_EXPR:
+        result = inferAwait(static_cast<AwaitExprNode*>(node.get()));
+        break;
+    default:
+        result = StaticType::UNKNOWN;
+        break;
+    }
+
+    node->staticType = result;
+    return result;
+}
+
+StaticType TypeChecker::inferBinary(BinaryExprNode* node) {
+    StaticType left = infer(node->left);
+    StaticType right = infer(node->right);
+
+    if (left == StaticType::NEVER || right == StaticType::NEVER) {
+        return StaticType::NEVER;
+    }
+
+    BinaryOp op = node->opCode;
+
+    if (Operators::isLogical(op)) {
+        return StaticType::BOOL;
+    }
+
+    // Without both operand types the kernel is only chosen at runtime.
+    if (left == StaticType::UNKNOWN || right == StaticType::UNKNOWN) {
+        return Operators::isComparison(op) ? StaticType::BOOL : StaticType::UNKNOWN;
+    }
+
+    ValueType leftValue;
+    ValueType rightValue;
+    if (!toValueType(left, leftValue) || !toValueType(right, rightValue) ||
+        !Operators::lookup(leftValue, rightValue, op)) {
+        typeError("Operator '" + node->op + "' cannot be applied to " +
+            typeName(left) + " and " + typeName(right), node->line);
+        return StaticType::UNKNOWN;
+    }
+
+    if (Operators::isComparison(op)) {
+        return StaticType::BOOL;
+    }
+    if (left == right) {
+        return left;
+    }
+    return StaticType::FLOAT;
+}
+
+StaticType TypeChecker::inferUnary(UnaryExprNode* node) {
+    StaticType operand = infer(node->operand);
+
+    if (node->op != "-") {
+        typeError("Unknown unary operator: " + node->op, node->line);
+        return StaticType::UNKNOWN;
+    }
+
+    if (operand == StaticType::NEVER || operand == StaticType::UNKNOWN ||
+        operand == StaticType::INT || operand == StaticType::FLOAT) {
+        return operand;
+    }
+
+    typeError("Unary '-' cannot be applied to " + typeName(operand), node->line);
+    return StaticType::UNKNOWN;
+}
+
+StaticType TypeChecker::inferTernary(TernaryExprNode* node) {
+    infer(node->condition);
+    return join(infer(node->trueExpr), infer(node->falseExpr));
+}
+
+StaticType TypeChecker::inferCall(CallExprNode* node) {
+    Vec<StaticType> argTypes;
+    for (auto& arg : node->arguments) {
+        argTypes.push_back(infer(arg));
+    }
+
+    if (BuiltinRegistry::instance().hasFunction(node->callee)) {
+        node->target = nullptr;
+        StaticType declared = BuiltinRegistry::instance().returnType(node->callee);
+        if (declared == StaticType::UNKNOWN && node->callee.compare(0, 5, "math.") == 0) {
+            return numericReturnType(argTypes);
+        }
+        return declared;
+    }
+
+    auto it = functions.find(node->callee);
+    if (it == functions.end()) {
+        nameError("Undefined function: " + node->callee, node->line);
+        return StaticType::UNKNOWN;
+    }
+
+    FuncDefinitionNode* func = it->second.get();
+    node->target = func;
+    node->checkArguments = false;
+
+    if (argTypes.size() != func->parameters.size()) {
+        typeError("Function '" + func->name + "' expects " +
+            std::to_string(func->parameters.size()) + " arguments, got " +
+            std::to_string(argTypes.size()), node->line);
+        node->checkArguments = true;
+    }
+
+    for (size_t i = 0; i < argTypes.size() && i < func->parameters.size(); ++i) {
+        const Parameter& param = func->parameters[i];
+        if (guardFor(param.staticType, argTypes[i], param.name, node->line) != StaticType::UNKNOWN) {
+            node->checkArguments = true;
+        }
+    }
+
+    auto ret = returnTypes.find(func->name);
+    return ret != returnTypes.end() ? ret->second : StaticType::UNKNOWN;
+}
+
+StaticType TypeChecker::inferLiteral(LiteralNode* node) {
+    switch (node->litType) {
+    case LiteralNode::LiteralType::INTEGER:
+        if (!StringUtil::parseInt(node->value, node->intValue)) {
+            typeError("Integer literal out of range: " + node->value, node->line);
+            return StaticType::UNKNOWN;
+        }
+        return StaticType::INT;
+    case LiteralNode::LiteralType::FLOAT:
+        if (!StringUtil::parseFloat(node->value, node->floatValue)) {
+            typeError("Invalid float literal: " + node->value, node->line);
+            return StaticType::UNKNOWN;
+        }
+        return StaticType::FLOAT;
+    case LiteralNode::LiteralType::STRING:
+        return StaticType::STRING;
+    case LiteralNode::LiteralType::BOOLEAN:
+        return StaticType::BOOL;
+    default:
+        return StaticType::UNKNOWN;
+    }
+}
+
+StaticType TypeChecker::inferIdentifier(IdentifierNode* node) {
+    StaticType type;
+    if (!lookupVariable(node->name, type)) {
+        nameError("Undefined variable: " + node->name, node->line);
+        return StaticType::UNKNOWN;
+    }
+    return type;
+}
+
+StaticType TypeChecker::inferSpawn(SpawnExprNode* node) {
+    if (parallelWritable) {
+        typeError("Cannot spawn a task from a parallel for body", node->line);
+    }
+
+    infer(node->call);
+    return StaticType::TASK;
+}
+
+// A task's result type is not tracked, so awaited values are checked when
+// they are assigned.
+StaticType TypeChecker::inferAwait(AwaitExprNode* node) {
+    StaticType operand = infer(node->task);
+
+    if (parallelWritable) {
+        typeError("Cannot await a task from a parallel for body", node->line);
+    }
+
+    if (operand != StaticType::TASK && operand != StaticType::UNKNOWN && operand != StaticType::NEVER) {
+        typeError("await expects a task, got " + typeName(operand), node->line);
+    }
+
+    return operand == StaticType::NEVER ? StaticType::NEVER : StaticType::UNKNOWN;
+}
+
+// "object" is the struct json.parse(), json.object() and fs.stat() build,
+// whose fields are whatever the data holds.
+bool TypeChecker::builtinType(const String& name, StaticType& type) {
+    static const Map<String, StaticType> types = {
+        { "int", StaticType::INT },
+        { "float", StaticType::FLOAT },
+        { "string", StaticType::STRING },
+        { "bool", StaticType::BOOL },
+        { "task", StaticType::TASK },
+        { "channel", StaticType::CHANNEL },
+        { "array", StaticType::ARRAY },
+        { "reader", StaticType::READER },
+        { "writer", StaticType::WRITER },
+        { "bytes", StaticType::BYTES },
+        { "csv", StaticType::CSV_READER },
+        { "ndjson", StaticType::NDJSON_READER },
+        { "walker", StaticType::DIR_WALKER },
+        { Json::OBJECT_TYPE, StaticType::STRUCT },
+    };
+
+    auto it = types.find(name);
+    if (it == types.end()) {
+        return false;
+    }
+    type = it->second;
+    return true;
+}
+
+StaticType TypeChecker::resolveType(const String& name, int line) {
+    StaticType type;
+    if (builtinType(name, type)) return type;
+    if (structs.find(name) != structs.end()) return StaticType::STRUCT;
+
+    typeError("Unknown type '" + name + "'", line);
+    return StaticType::UNKNOWN;
+}
+
+bool TypeChecker::lookupVariable(const String& name, StaticType& type) const {
+    if (mixesGlobal(name)) {
+        type = StaticType::UNKNOWN;
+        return true;
+    }
+
+    if (locals) {
+        auto it = locals->find(name);
+        if (it != locals->end()) {
+            type = it->second;
+            return true;
+        }
+    }
+
+    auto it = globals.find(name);
+    if (it != globals.end()) {
+        type = it->second;
+        return true;
+    }
+
+    return false;
+}
+
+// A local the function binds only on some paths to here (in one branch of
+// an if, in a loop body, or further down a loop body) is looked up in the
+// globals on the other paths at runtime. True if a global of that name has
+// another type, so the name has no single static type here.
+bool TypeChecker::mixesGlobal(const String& name) const {
+    if (!locals || definite.count(name)) {
+        return false;
+    }
+
+    auto local = functionLocals.find(name);
+    auto global = globals.find(name);
+    return local != functionLocals.end() && global != globals.end() &&
+        (local->second != global->second || local->second == StaticType::UNKNOWN);
+}
+
+// Records every local the body defines, before it is checked, so a read
+// near the top of a loop body knows about a definition further down.
+// Elements of a reader are not typed here and count as unknown.
+void TypeChecker::collectLocals(const Vec<Ptr<ASTNode>>& body) {
+    auto note = [&](const String& name, StaticType type) {
+        auto it = functionLocals.find(name);
+        functionLocals[name] = it == functionLocals.end() || it->second == type ? type : StaticType::UNKNOWN;
+    };
+
+    for (auto& stmt : body) {
+        if (stmt->nodeType == ASTNodeType::VAR_DEFINITION) {
+            auto def = static_cast<VarDefinitionNode*>(stmt.get());
+            StaticType type;
+            if (!builtinType(def->type, type)) {
+                type = structs.count(def->type) ? StaticType::STRUCT : StaticType::UNKNOWN;
+            }
+            for (auto& name : def->names) {
+                note(name, type);
+            }
+        }
+        else if (stmt->nodeType == ASTNodeType::IF_STMT) {
+            auto ifNode = static_cast<IfNode*>(stmt.get());
+            collectLocals(ifNode->thenBranch);
+            for (auto& branch : ifNode->elseIfBranches) {
+                collectLocals(branch.body);
+            }
+            collectLocals(ifNode->elseBranch);
+        }
+        else if (stmt->nodeType == ASTNodeType::FOR_STMT) {
+            auto loop = static_cast<ForNode*>(stmt.get());
+            note(loop->iterator, loop->source ? StaticType::UNKNOWN : StaticType::INT);
+            collectLocals(loop->body);
+        }
+    }
+}
+
+// Function bodies share one scope at runtime, so a name keeps one type for
+// the whole function; redefining it with another type would make earlier
+// uses inside a loop body unsound.
+void TypeChecker::declareVariable(const String& name, StaticType type, int line) {
+    Map<String, StaticType>& scope = locals ? *locals : globals;
+
+    auto it = scope.find(name);
+    if (it != scope.end() && it->second != type) {
+        typeError("Variable '" + name + "' redefined as " + typeName(type) +
+            ", was " + typeName(it->second), line);
+        return;
+    }
+
+    scope[name] = type;
+}
+
+StaticType TypeChecker::guardFor(StaticType declared, StaticType actual, const String& what, int line) {
+    if (declared == StaticType::UNKNOWN || actual == declared || actual == StaticType::NEVER) {
+        return StaticType::UNKNOWN;
+    }
+
+    if (actual == StaticType::UNKNOWN) {
+        return declared;
+    }
+
+    typeError("Cannot assign " + typeName(actual) + " to " + typeName(declared) +
+        " '" + what + "'", line);
+    return StaticType::UNKNOWN;
+}
+
+bool TypeChecker::toValueType(StaticType type, ValueType& out) {
+    switch (type) {
+    case StaticType::INT: out = ValueType::INTEGER; return true;
+    case StaticType::FLOAT: out = ValueType::FLOAT; return true;
+    case StaticType::STRING: out = ValueType::STRING; return true;
+    case StaticType::BOOL: out = ValueType::BOOLEAN; return true;
+    case StaticType::NIL: out = ValueType::NIL; return true;
+    case StaticType::STRUCT: out = ValueType::STRUCT_INSTANCE; return true;
+    case StaticType::TASK: out = ValueType::TASK; return true;
+    case StaticType::CHANNEL: out = ValueType::CHANNEL; return true;
+    case StaticType::ARRAY: out = ValueType::ARRAY; return true;
+    case StaticType::READER: out = ValueType::READER; return true;
+    case StaticType::WRITER: out = ValueType::WRITER; return true;
+    case StaticType::BYTES: out = ValueType::BYTES; return true;
+    case StaticType::CSV_READER: out = ValueType::CSV_READER; return true;
+    case StaticType::NDJSON_READER: out = ValueType::NDJSON_READER; return true;
+    case StaticType::DIR_WALKER: out = ValueType::DIR_WALKER; return true;
+    default: return false;
+    }
+}
+
+StaticType TypeChecker::join(StaticType a, StaticType b) {
+    if (a == StaticType::NEVER) return b;
+    if (b == StaticType::NEVER) return a;
+    if (a == b) return a;
+    return StaticType::UNKNOWN;
+}
+
+bool TypeChecker::definitelyReturns(const Vec<Ptr<ASTNode>>& body) {
+    for (auto& stmt : body) {
+        if (stmt->nodeType == ASTNodeType::RETURN_STMT) {
+            return true;
+        }
+
+        if (stmt->nodeType == ASTNodeType::IF_STMT) {
+            auto ifNode = static_cast<IfNode*>(stmt.get());
+            if (ifNode->elseBranch.empty() || !definitelyReturns(ifNode->thenBranch) ||
+                !definitelyReturns(ifNode->elseBranch)) {
+                continue;
+            }
+
+            bool allBranches = true;
+            for (auto& branch : ifNode->elseIfBranches) {
+                allBranches = allBranches && definitelyReturns(branch.body);
+            }
+
+            if (allBranches) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The math builtins keep ints exact and go to floats as soon as a float is
+// involved; floor() and ceil(), which always give an int, are registered
+// as such.
+StaticType TypeChecker::numericReturnType(const Vec<StaticType>& argTypes) {
+    bool anyFloat = false;
+    for (StaticType type : argTypes) {
+        if (type == StaticType::FLOAT) {
+            anyFloat = true;
+        }
+        else if (type != StaticType::INT) {
+            return StaticType::UNKNOWN;
+        }
+    }
+    return anyFloat ? StaticType::FLOAT : StaticType::INT;
+}
+
+String TypeChecker::typeName(StaticType type) {
+    switch (type) {
+    case StaticType::INT: return "int";
+    case StaticType::FLOAT: return "float";
+    case StaticType::STRING: return "string";
+    case StaticType::BOOL: return "bool";
+    case StaticType::NIL: return "nil";
+    case StaticType::STRUCT: return "struct";
+    case StaticType::TASK: return "task";
+    case StaticType::CHANNEL: return "channel";
+    case StaticType::ARRAY: return "array";
+    case StaticType::READER: return "reader";
+    case StaticType::WRITER: return "writer";
+    case StaticType::BYTES: return "bytes";
+    case StaticType::CSV_READER: return "csv";
+    case StaticType::NDJSON_READER: return "ndjson";
+    case StaticType::DIR_WALKER: return "walker";
+    case StaticType::NEVER: return "never";
+    default: return "unknown";
+    }
+}
+
+void TypeChecker::typeError(const String& message, int line) {
+    if (reporting) {
+        throw TypeError(message, line > 0 ? line : currentLine);
+    }
+}
+
+void TypeChecker::nameError(const String& message, int line) {
+    if (reporting) {
+        throw NameError(message, line > 0 ? line : currentLine);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../Common.h"
+#include "../parser/AST.h"
+#include "../runtime/Value.h"
+#include <set>
+
+class TypeChecker {
+public:
+    TypeChecker();
+    void check(Ptr<ProgramNode> program);
+
+    static String typeName(StaticType type);
+
+private:
+    Map<String, StaticType> globals;
+    Map<String, StaticType>* locals;
+    Map<String, Ptr<FuncDefinitionNode>> functions;
+    Map<String, Ptr<StructDefinitionNode>> structs;
+    Map<String, StaticType> returnTypes;
+
+    // Locals the current function defines anywhere, with their declared
+    // types, and those bound on every path to the statement being checked.
+    Map<String, StaticType> functionLocals;
+    std::set<String> definite;
+
+    Vec<StaticType> returnStack;
+
+    // Names the innermost parallel for body may assign: its iterator, its
+    // reductions and its own locals. Null outside parallel loops.
+    std::set<String>* parallelWritable;
+    bool reporting;
+    int currentLine;
+
+    void inferReturnTypes(const Vec<Ptr<FuncDefinitionNode>>& funcs);
+
+    StaticType checkFunction(FuncDefinitionNode* func);
+    void checkBlock(const Vec<Ptr<ASTNode>>& body);
+    void checkStatement(const Ptr<ASTNode>& node);
+    void checkVarDefinition(VarDefinitionNode* node);
+    void checkAssignment(AssignmentNode* node);
+    void checkIf(IfNode* node);
+    void checkFor(ForNode* node);
+    void checkForEach(ForNode* node);
+    void checkParallelFor(ForNode* node);
+    void checkReturn(ReturnNode* node);
+
+    StaticType infer(const Ptr<ASTNode>& node);
+    StaticType inferBinary(BinaryExprNode* node);
+    StaticType inferUnary(UnaryExprNode* node);
+    StaticType inferTernary(TernaryExprNode* node);
+    StaticType inferCall(CallExprNode* node);
+    StaticType inferLiteral(LiteralNode* node);
+    StaticType inferIdentifier(IdentifierNode* node);
+    StaticType inferSpawn(SpawnExprNode* node);
+    StaticType inferAwait(AwaitExprNode* node);
+
+    StaticType resolveType(const String& name, int line);
+    static bool builtinType(const String& name, StaticType& type);
+    bool lookupVariable(const String& name, StaticType& type) const;
+    bool mixesGlobal(const String& name) const;
+    void collectLocals(const Vec<Ptr<ASTNode>>& body);
+    void declareVariable(const String& name, StaticType type, int line);
+    StaticType guardFor(StaticType declared, StaticType actual, const String& what, int line);
+
+    static bool toValueType(StaticType type, ValueType& out);
+    static StaticType join(StaticType a, StaticType b);
+    static bool definitelyReturns(const Vec<Ptr<ASTNode>>& body);
+    static StaticType numericReturnType(const Vec<StaticType>& argTypes);
+
+    void typeError(const String& message, int line);
+    void nameError(const String& message, int line);
+};
@@ -0,0 +1,28 @@
+#include "array.h"
+#include "../../utils/Error.h"
+#include "../../runtime/Heap.h"
+
+namespace Builtins {
+    namespace Array {
+        Value length(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isArray()) {
+                throw TypeError("array.length() requires an array");
+            }
+            return Value::makeInt(static_cast<int64_t>(args[0].asArray()->elements.size()));
+        }
+
+        Value get(const Vec<Value>& args) {
+            if (args.size() != 2 || !args[0].isArray() || !args[1].isInt()) {
+                throw TypeError("array.get() requires an array and an integer index");
+            }
+
+            const Vec<Value>& elements = args[0].asArray()->elements;
+            int64_t index = args[1].asInt();
+            if (index < 0 || static_cast<uint64_t>(index) >= elements.size()) {
+                throw RuntimeError("Array index " + std::to_string(index) + " out of range (length " +
+                    std::to_string(elements.size()) + ")");
+            }
+            return elements[static_cast<size_t>(index)];
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Array {
+		Value length(const Vec<Value>& args);
+		Value get(const Vec<Value>& args);
+	}
+}
@@ -5,60 +5,165 @@
 #include "string/String.h"
 #include "system/System.h"
 #include "file/File.h"
+#include "channel/Channel.h"
+#include "parallel/parallel.h"
+#include "array/array.h"
+#include "reader/reader.h"
+#include "bytes/bytes.h"
+#include "csv/csv.h"
+#include "json/json.h"
+#include "fs/fs.h"
 #include "../utils/Error.h"
 
-BuiltinRegistry& BuiltinRegistry::instance() {
-    static BuiltinRegistry reg;
+BuiltinRegistry::BuiltinRegistry() {
+    registerAll();
+}
+
+const BuiltinRegistry& BuiltinRegistry::instance() {
+    static const BuiltinRegistry reg;
     return reg;
 }
 
-void BuiltinRegistry::registerFunction(const String& name, BuiltinFunction func) {
-    functions[name] = func;
+void BuiltinRegistry::registerFunction(const String& name, BuiltinFunction func, StaticType returnType) {
+    functions[name] = Builtin{ std::move(func), returnType };
 }
 
 bool BuiltinRegistry::hasFunction(const String& name) const {
     return functions.find(name) != functions.end();
 }
 
+const BuiltinFunction* BuiltinRegistry::findFunction(const String& name) const {
+    auto it = functions.find(name);
+    return it != functions.end() ? &it->second.function : nullptr;
+}
+
+StaticType BuiltinRegistry::returnType(const String& name) const {
+    auto it = functions.find(name);
+    return it != functions.end() ? it->second.returnType : StaticType::UNKNOWN;
+}
+
 Value BuiltinRegistry::callFunction(const String& name, const Vec<Value>& args) const {
     auto it = functions.find(name);
     if (it == functions.end()) {
         throw RuntimeError("Unknown built-in function: " + name);
     }
-    return it->second(args);
+    return it->second.function(args);
 }
 
 void BuiltinRegistry::registerAll() {
-    registerFunction("console.print", Builtins::Console::print);
-    registerFunction("console.write", Builtins::Console::write);
-    registerFunction("console.error", Builtins::Console::error);
-
-    registerFunction("random.int", Builtins::Random::randomInt);
-    registerFunction("random.float", Builtins::Random::randomFloat);
-
-    registerFunction("math.abs", Builtins::Math::abs);
-    registerFunction("math.min", Builtins::Math::min);
-    registerFunction("math.max", Builtins::Math::max);
-    registerFunction("math.pow", Builtins::Math::pow);
-    registerFunction("math.sqrt", Builtins::Math::sqrt);
-    registerFunction("math.floor", Builtins::Math::floor);
-    registerFunction("math.ceil", Builtins::Math::ceil);
-
-    registerFunction("string.length", Builtins::String::length);
-    registerFunction("string.substring", Builtins::String::substring);
-    registerFunction("string.upper", Builtins::String::toupper);
-    registerFunction("string.lower", Builtins::String::tolower);
-    registerFunction("string.contains", Builtins::String::contains);
-    registerFunction("string.replace", Builtins::String::replace);
-    registerFunction("string.split", Builtins::String::split);
-    registerFunction("string.trim", Builtins::String::trim);
-
-    registerFunction("system.exit", Builtins::System::exit);
-    registerFunction("system.pause", Builtins::System::pause);
-    registerFunction("system.version", Builtins::System::version);
-
-    registerFunction("file.read", Builtins::File::read);
-    registerFunction("file.write", Builtins::File::write);
-    registerFunction("file.create", Builtins::File::create);
-    registerFunction("file.exists", Builtins::File::exists);
+    registerFunction("console.print", Builtins::Console::print, StaticType::NIL);
+    registerFunction("console.write", Builtins::Console::write, StaticType::NIL);
+    registerFunction("console.flush", Builtins::Console::flush, StaticType::NIL);
+    registerFunction("console.error", Builtins::Console::error, StaticType::NIL);
+    registerFunction("console.readLine", Builtins::Console::readLine, StaticType::UNKNOWN);
+    registerFunction("console.eof", Builtins::Console::eof, StaticType::BOOL);
+    registerFunction("console.readAll", Builtins::Console::readAll, StaticType::STRING);
+    registerFunction("console.lines", Builtins::Console::lines, StaticType::READER);
+
+    registerFunction("random.int", Builtins::Random::randomInt, StaticType::INT);
+    registerFunction("random.float", Builtins::Random::randomFloat, StaticType::FLOAT);
+    registerFunction("random.seed", Builtins::Random::seed, StaticType::NIL);
+    registerFunction("random.jump", Builtins::Random::jump, StaticType::NIL);
+    registerFunction("random.bytes", Builtins::Random::bytes, StaticType::STRING);
+    registerFunction("random.ints", Builtins::Random::ints, StaticType::ARRAY);
+    registerFunction("random.floats", Builtins::Random::floats, StaticType::ARRAY);
+    registerFunction("random.fillInts", Builtins::Random::fillInts, StaticType::INT);
+    registerFunction("random.fillFloats", Builtins::Random::fillFloats, StaticType::INT);
+
+    // Int or float as the arguments are; see TypeChecker::numericReturnType().
+    registerFunction("math.abs", Builtins::Math::abs, StaticType::UNKNOWN);
+    registerFunction("math.min", Builtins::Math::min, StaticType::UNKNOWN);
+    registerFunction("math.max", Builtins::Math::max, StaticType::UNKNOWN);
+    registerFunction("math.pow", Builtins::Math::pow, StaticType::UNKNOWN);
+    registerFunction("math.sqrt", Builtins::Math::sqrt, StaticType::UNKNOWN);
+    registerFunction("math.floor", Builtins::Math::floor, StaticType::INT);
+    registerFunction("math.ceil", Builtins::Math::ceil, StaticType::INT);
+
+    registerFunction("string.length", Builtins::String::length, StaticType::INT);
+    registerFunction("string.substring", Builtins::String::substring, StaticType::STRING);
+    registerFunction("string.upper", Builtins::String::toupper, StaticType::STRING);
+    registerFunction("string.lower", Builtins::String::tolower, StaticType::STRING);
+    registerFunction("string.contains", Builtins::String::contains, StaticType::BOOL);
+    registerFunction("string.replace", Builtins::String::replace, StaticType::STRING);
+    registerFunction("string.split", Builtins::String::split, StaticType::INT);
+    registerFunction("string.trim", Builtins::String::trim, StaticType::STRING);
+
+    registerFunction("system.exit", Builtins::System::exit, StaticType::NEVER);
+    registerFunction("system.pause", Builtins::System::pause, StaticType::NIL);
+    registerFunction("system.version", Builtins::System::version, StaticType::STRING);
+    registerFunction("system.allocations", Builtins::System::allocations, StaticType::INT);
+    registerFunction("system.gc", Builtins::System::gc, StaticType::NIL);
+    registerFunction("system.sleepAsync", Builtins::System::sleepAsync, StaticType::TASK);
+    registerFunction("system.argc", Builtins::System::argc, StaticType::INT);
+    registerFunction("system.arg", Builtins::System::arg, StaticType::STRING);
+
+    registerFunction("file.read", Builtins::File::read, StaticType::STRING);
+    registerFunction("file.map", Builtins::File::map, StaticType::STRING);
+    registerFunction("file.open", Builtins::File::open, StaticType::READER);
+    registerFunction("file.lines", Builtins::File::lines, StaticType::READER);
+    registerFunction("file.parallelLines", Builtins::File::parallelLines, StaticType::UNKNOWN);
+    registerFunction("file.openWrite", Builtins::File::openWrite, StaticType::WRITER);
+    registerFunction("file.append", Builtins::File::append, StaticType::WRITER);
+    registerFunction("file.write", Builtins::File::write, StaticType::BOOL);
+    registerFunction("file.flush", Builtins::File::flush, StaticType::NIL);
+    registerFunction("file.close", Builtins::File::close, StaticType::NIL);
+    registerFunction("file.readBytes", Builtins::File::readBytes, StaticType::UNKNOWN);
+    registerFunction("file.writeBytes", Builtins::File::writeBytes, StaticType::BOOL);
+    registerFunction("file.create", Builtins::File::create, StaticType::BOOL);
+    registerFunction("file.exists", Builtins::File::exists, StaticType::BOOL);
+    registerFunction("file.readAsync", Builtins::File::readAsync, StaticType::TASK);
+    registerFunction("file.writeAsync", Builtins::File::writeAsync, StaticType::TASK);
+
+    registerFunction("channel.make", Builtins::Channel::make, StaticType::CHANNEL);
+    registerFunction("channel.send", Builtins::Channel::send, StaticType::NIL);
+    registerFunction("channel.recv", Builtins::Channel::recv, StaticType::UNKNOWN);
+    registerFunction("channel.tryRecv", Builtins::Channel::tryRecv, StaticType::UNKNOWN);
+    registerFunction("channel.close", Builtins::Channel::close, StaticType::NIL);
+
+    registerFunction("parallel.sum", Builtins::Parallel::sum, StaticType::UNKNOWN);
+    registerFunction("parallel.count", Builtins::Parallel::count, StaticType::INT);
+    registerFunction("parallel.map", Builtins::Parallel::map, StaticType::ARRAY);
+
+    registerFunction("array.length", Builtins::Array::length, StaticType::INT);
+    registerFunction("array.get", Builtins::Array::get, StaticType::UNKNOWN);
+
+    registerFunction("reader.nextLine", Builtins::Reader::nextLine, StaticType::UNKNOWN);
+    registerFunction("reader.eof", Builtins::Reader::eof, StaticType::BOOL);
+    registerFunction("reader.close", Builtins::Reader::close, StaticType::NIL);
+
+    registerFunction("bytes.make", Builtins::Bytes::make, StaticType::BYTES);
+    registerFunction("bytes.length", Builtins::Bytes::length, StaticType::INT);
+    registerFunction("bytes.slice", Builtins::Bytes::slice, StaticType::BYTES);
+    registerFunction("bytes.getInt", Builtins::Bytes::getInt, StaticType::INT);
+    registerFunction("bytes.getUint", Builtins::Bytes::getUint, StaticType::INT);
+    registerFunction("bytes.getFloat", Builtins::Bytes::getFloat, StaticType::FLOAT);
+    registerFunction("bytes.getString", Builtins::Bytes::getString, StaticType::STRING);
+    registerFunction("bytes.putInt", Builtins::Bytes::putInt, StaticType::NIL);
+    registerFunction("bytes.putFloat", Builtins::Bytes::putFloat, StaticType::NIL);
+    registerFunction("bytes.putString", Builtins::Bytes::putString, StaticType::NIL);
+
+    registerFunction("csv.open", Builtins::Csv::open, StaticType::CSV_READER);
+    registerFunction("csv.rows", Builtins::Csv::rows, StaticType::CSV_READER);
+    registerFunction("csv.nextRow", Builtins::Csv::nextRow, StaticType::UNKNOWN);
+    registerFunction("csv.eof", Builtins::Csv::eof, StaticType::BOOL);
+    registerFunction("csv.close", Builtins::Csv::close, StaticType::NIL);
+
+    registerFunction("json.parse", Builtins::Json::parse, StaticType::UNKNOWN);
+    registerFunction("json.stringify", Builtins::Json::stringify, StaticType::STRING);
+    registerFunction("json.object", Builtins::Json::object, StaticType::STRUCT);
+    registerFunction("json.get", Builtins::Json::get, StaticType::UNKNOWN);
+    registerFunction("json.set", Builtins::Json::set, StaticType::NIL);
+    registerFunction("json.keys", Builtins::Json::keys, StaticType::ARRAY);
+    registerFunction("json.lines", Builtins::Json::lines, StaticType::NDJSON_READER);
+    registerFunction("json.next", Builtins::Json::next, StaticType::UNKNOWN);
+    registerFunction("json.eof", Builtins::Json::eof, StaticType::BOOL);
+    registerFunction("json.close", Builtins::Json::close, StaticType::NIL);
+
+    registerFunction("fs.list", Builtins::Fs::list, StaticType::ARRAY);
+    registerFunction("fs.walk", Builtins::Fs::walk, StaticType::ARRAY);
+    registerFunction("fs.walker", Builtins::Fs::walker, StaticType::DIR_WALKER);
+    registerFunction("fs.nextBatch", Builtins::Fs::nextBatch, StaticType::UNKNOWN);
+    registerFunction("fs.done", Builtins::Fs::done, StaticType::BOOL);
+    registerFunction("fs.close", Builtins::Fs::close, StaticType::NIL);
+    registerFunction("fs.stat", Builtins::Fs::stat, StaticType::UNKNOWN);
 }
\ No newline at end of file
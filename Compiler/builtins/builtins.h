@@ -2,21 +2,35 @@
 
 #include "../Common.h"
 #include "../runtime/Value.h"
+#include "../parser/AST.h"
 #include <functional>
 
 using BuiltinFunction = std::function<Value(const Vec<Value>&)>;
 
+// The registry is populated once, on first use, and is read-only afterwards,
+// so any number of interpreters on any number of threads may query it.
+// Builtins keep their mutable state in the calling Isolate.
 class BuiltinRegistry {
 public:
-    static BuiltinRegistry& instance();
+    static const BuiltinRegistry& instance();
 
-    void registerFunction(const String& name, BuiltinFunction func);
     bool hasFunction(const String& name) const;
+    const BuiltinFunction* findFunction(const String& name) const;
     Value callFunction(const String& name, const Vec<Value>& args) const;
 
-    void registerAll();
+    // What the TypeChecker may assume a call returns; UNKNOWN when that
+    // depends on the arguments or the data.
+    StaticType returnType(const String& name) const;
 
 private:
-    BuiltinRegistry() = default;
-    Map<String, BuiltinFunction> functions;
+    struct Builtin {
+        BuiltinFunction function;
+        StaticType returnType;
+    };
+
+    BuiltinRegistry();
+    Map<String, Builtin> functions;
+
+    void registerFunction(const String& name, BuiltinFunction func, StaticType returnType);
+    void registerAll();
 };
\ No newline at end of file
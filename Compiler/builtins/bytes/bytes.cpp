@@ -0,0 +1,201 @@
+#include "bytes.h"
+#include "../../utils/Error.h"
+#include "../../runtime/Heap.h"
+#include <cstring>
+#include <limits>
+
+namespace Builtins {
+    namespace Bytes {
+        namespace {
+            BytesObject* requireBytes(const Vec<Value>& args, size_t count, const char* name) {
+                if (args.size() < count || !args[0].isBytes()) {
+                    throw TypeError(::String("bytes.") + name + "() requires a byte buffer");
+                }
+                return args[0].asBytes();
+            }
+
+            // Checks that [offset, offset + width) lies inside the buffer.
+            size_t checkRange(const BytesObject* bytes, const Value& offset, uint64_t width, const char* name) {
+                if (!offset.isInt()) {
+                    throw TypeError(::String("bytes.") + name + "() requires an integer offset");
+                }
+                int64_t start = offset.asInt();
+                if (start < 0 || static_cast<uint64_t>(start) > bytes->length ||
+                    width > bytes->length - static_cast<uint64_t>(start)) {
+                    throw RuntimeError("Byte range " + std::to_string(start) + "+" + std::to_string(width) +
+                        " out of range (length " + std::to_string(bytes->length) + ")");
+                }
+                return static_cast<size_t>(start);
+            }
+
+            size_t intWidth(const Value& width, const char* name) {
+                if (!width.isInt() || (width.asInt() != 1 && width.asInt() != 2 &&
+                    width.asInt() != 4 && width.asInt() != 8)) {
+                    throw TypeError(::String("bytes.") + name + "() width must be 1, 2, 4 or 8");
+                }
+                return static_cast<size_t>(width.asInt());
+            }
+
+            size_t floatWidth(const Value& width, const char* name) {
+                if (!width.isInt() || (width.asInt() != 4 && width.asInt() != 8)) {
+                    throw TypeError(::String("bytes.") + name + "() width must be 4 or 8");
+                }
+                return static_cast<size_t>(width.asInt());
+            }
+
+            // The optional byte order argument: "le" (the default) or "be".
+            bool bigEndian(const Vec<Value>& args, size_t index, const char* name) {
+                if (args.size() <= index) {
+                    return false;
+                }
+                if (args.size() > index + 1 || !args[index].isString() ||
+                    (args[index].asStringView() != "le" && args[index].asStringView() != "be")) {
+                    throw TypeError(::String("bytes.") + name + "() byte order must be \"le\" or \"be\"");
+                }
+                return args[index].asStringView() == "be";
+            }
+
+            uint64_t load(const uint8_t* data, size_t width, bool big) {
+                uint64_t value = 0;
+                for (size_t i = 0; i < width; ++i) {
+                    size_t index = big ? i : width - 1 - i;
+                    value = (value << 8) | data[index];
+                }
+                return value;
+            }
+
+            void store(uint8_t* data, size_t width, bool big, uint64_t value) {
+                for (size_t i = 0; i < width; ++i) {
+                    size_t index = big ? width - 1 - i : i;
+                    data[index] = static_cast<uint8_t>(value);
+                    value >>= 8;
+                }
+            }
+        }
+
+        Value make(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isInt()) {
+                throw TypeError("bytes.make() requires an integer size");
+            }
+            if (args[0].asInt() < 0) {
+                throw RuntimeError("bytes.make() size cannot be negative");
+            }
+            return Value::makeBytes(static_cast<size_t>(args[0].asInt()));
+        }
+
+        Value length(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 1, "length");
+            return Value::makeInt(static_cast<int64_t>(bytes->length));
+        }
+
+        // A view of length bytes from offset; nothing is copied.
+        Value slice(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 3, "slice");
+            if (args.size() != 3 || !args[2].isInt() || args[2].asInt() < 0) {
+                throw TypeError("bytes.slice() requires a byte buffer, an offset and a length");
+            }
+            uint64_t count = static_cast<uint64_t>(args[2].asInt());
+            size_t offset = checkRange(bytes, args[1], count, "slice");
+            return Value::makeBytesSlice(args[0], offset, static_cast<size_t>(count));
+        }
+
+        Value getInt(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 3, "getInt");
+            size_t width = intWidth(args[2], "getInt");
+            size_t offset = checkRange(bytes, args[1], width, "getInt");
+            uint64_t raw = load(bytes->data + offset, width, bigEndian(args, 3, "getInt"));
+
+            // Sign-extend from the top bit of the field.
+            unsigned shift = static_cast<unsigned>(64 - 8 * width);
+            return Value::makeInt(static_cast<int64_t>(raw << shift) >> shift);
+        }
+
+        // An 8-byte value above the int range is an error rather than a
+        // negative number.
+        Value getUint(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 3, "getUint");
+            size_t width = intWidth(args[2], "getUint");
+            size_t offset = checkRange(bytes, args[1], width, "getUint");
+            uint64_t raw = load(bytes->data + offset, width, bigEndian(args, 3, "getUint"));
+            if (raw > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                throw RuntimeError("bytes.getUint() value " + std::to_string(raw) + " at offset " +
+                    std::to_string(offset) + " does not fit in an integer");
+            }
+            return Value::makeInt(static_cast<int64_t>(raw));
+        }
+
+        Value getFloat(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 3, "getFloat");
+            size_t width = floatWidth(args[2], "getFloat");
+            size_t offset = checkRange(bytes, args[1], width, "getFloat");
+            uint64_t raw = load(bytes->data + offset, width, bigEndian(args, 3, "getFloat"));
+
+            if (width == 4) {
+                uint32_t bits = static_cast<uint32_t>(raw);
+                float value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return Value::makeFloat(value);
+            }
+            double value;
+            std::memcpy(&value, &raw, sizeof(value));
+            return Value::makeFloat(value);
+        }
+
+        Value getString(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 3, "getString");
+            if (args.size() != 3 || !args[2].isInt() || args[2].asInt() < 0) {
+                throw TypeError("bytes.getString() requires a byte buffer, an offset and a length");
+            }
+            uint64_t count = static_cast<uint64_t>(args[2].asInt());
+            size_t offset = checkRange(bytes, args[1], count, "getString");
+            return Value::makeString(::String(reinterpret_cast<const char*>(bytes->data + offset),
+                static_cast<size_t>(count)));
+        }
+
+        // Integers are truncated to the field width.
+        Value putInt(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 4, "putInt");
+            size_t width = intWidth(args[2], "putInt");
+            if (!args[3].isInt()) {
+                throw TypeError("bytes.putInt() requires an integer value");
+            }
+            size_t offset = checkRange(bytes, args[1], width, "putInt");
+            store(bytes->data + offset, width, bigEndian(args, 4, "putInt"), static_cast<uint64_t>(args[3].asInt()));
+            return Value::makeNil();
+        }
+
+        Value putFloat(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 4, "putFloat");
+            size_t width = floatWidth(args[2], "putFloat");
+            if (!args[3].isFloat() && !args[3].isInt()) {
+                throw TypeError("bytes.putFloat() requires a numeric value");
+            }
+            size_t offset = checkRange(bytes, args[1], width, "putFloat");
+            double value = args[3].isInt() ? static_cast<double>(args[3].asInt()) : args[3].asFloat();
+
+            uint64_t raw;
+            if (width == 4) {
+                float narrow = static_cast<float>(value);
+                uint32_t bits;
+                std::memcpy(&bits, &narrow, sizeof(bits));
+                raw = bits;
+            }
+            else {
+                std::memcpy(&raw, &value, sizeof(raw));
+            }
+            store(bytes->data + offset, width, bigEndian(args, 4, "putFloat"), raw);
+            return Value::makeNil();
+        }
+
+        Value putString(const Vec<Value>& args) {
+            BytesObject* bytes = requireBytes(args, 3, "putString");
+            if (args.size() != 3 || !args[2].isString()) {
+                throw TypeError("bytes.putString() requires a byte buffer, an offset and a string");
+            }
+            std::string_view text = args[2].asStringView();
+            size_t offset = checkRange(bytes, args[1], text.size(), "putString");
+            std::memcpy(bytes->data + offset, text.data(), text.size());
+            return Value::makeNil();
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Bytes {
+		Value make(const Vec<Value>& args);
+		Value length(const Vec<Value>& args);
+		Value slice(const Vec<Value>& args);
+		Value getInt(const Vec<Value>& args);
+		Value getUint(const Vec<Value>& args);
+		Value getFloat(const Vec<Value>& args);
+		Value getString(const Vec<Value>& args);
+		Value putInt(const Vec<Value>& args);
+		Value putFloat(const Vec<Value>& args);
+		Value putString(const Vec<Value>& args);
+	}
+}
@@ -0,0 +1,63 @@
+#include "channel.h"
+#include "../../utils/Error.h"
+#include "../../runtime/Channel.h"
+
+namespace Builtins {
+    namespace Channel {
+        namespace {
+            ::Channel& channelArg(const Vec<Value>& args, const char* name) {
+                if (args.empty() || !args[0].isChannel()) {
+                    throw TypeError(::String("channel.") + name + "() requires a channel");
+                }
+                return *args[0].asChannel();
+            }
+        }
+
+        Value make(const Vec<Value>& args) {
+            size_t capacity = 0;
+
+            if (!args.empty()) {
+                if (!args[0].isInt() || args[0].asInt() < 1) {
+                    throw TypeError("channel.make() requires a positive integer capacity");
+                }
+                capacity = static_cast<size_t>(args[0].asInt());
+            }
+
+            return Value::makeChannel(MAKE_PTR(::Channel, capacity));
+        }
+
+        Value send(const Vec<Value>& args) {
+            ::Channel& channel = channelArg(args, "send");
+            if (args.size() != 2) {
+                throw TypeError("channel.send() requires a channel and a value");
+            }
+            if (args[1].isNil()) {
+                throw TypeError("Cannot send nil over a channel");
+            }
+
+            channel.send(Message::detach(args[1]));
+            return Value::makeNil();
+        }
+
+        Value recv(const Vec<Value>& args) {
+            Message message;
+            if (!channelArg(args, "recv").recv(message)) {
+                return Value::makeNil();
+            }
+            return message.attach();
+        }
+
+        Value tryRecv(const Vec<Value>& args) {
+            Message message;
+            if (!channelArg(args, "tryRecv").tryRecv(message)) {
+                return Value::makeNil();
+            }
+            return message.attach();
+        }
+
+        Value close(const Vec<Value>& args) {
+            channelArg(args, "close").close();
+            return Value::makeNil();
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Channel {
+		Value make(const Vec<Value>& args);
+		Value send(const Vec<Value>& args);
+		Value recv(const Vec<Value>& args);
+		Value tryRecv(const Vec<Value>& args);
+		Value close(const Vec<Value>& args);
+	}
+}
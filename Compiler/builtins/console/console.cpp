@@ -1,43 +1,123 @@
 #include "console.h"
 #include "../../utils/Error.h"
+#include "../../runtime/Isolate.h"
+#include "../../runtime/LineReader.h"
 #include <iostream>
+#include <mutex>
 
 namespace Builtins {
     namespace Console {
+        namespace {
+            // Above this a string is written by itself rather than copied
+            // into the line, so printing a mapped file does not copy it.
+            constexpr size_t DIRECT_WRITE_SIZE = 64 * 1024;
 
-        Value print(const Vec<Value>& args) {
-            if (args.empty()) {
-                std::cout << std::endl;
-                return Value::makeNil();
-            }
+            // Writes the arguments separated by spaces. Each line goes to
+            // the stream in one piece where possible, so lines printed by
+            // parallel workers do not interleave. Nothing is flushed here;
+            // that is up to the console buffer (see ConsoleOutput).
+            void writeValues(std::ostream& out, const Vec<Value>& args, const char* ending) {
+                ::String line;
+                for (size_t i = 0; i < args.size(); ++i) {
+                    if (i > 0) line += ' ';
+
+                    if (!args[i].isString()) {
+                        line += args[i].toString();
+                        continue;
+                    }
 
-            for (size_t i = 0; i < args.size(); ++i) {
-                if (i > 0) std::cout << " ";
-                std::cout << args[i].toString();
+                    std::string_view text = args[i].asStringView();
+                    if (text.size() < DIRECT_WRITE_SIZE) {
+                        line.append(text.data(), text.size());
+                    }
+                    else {
+                        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+                        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                        line.clear();
+                    }
+                }
+                line += ending;
+                out.write(line.data(), static_cast<std::streamsize>(line.size()));
             }
-            std::cout << std::endl;
 
+            // Tasks may read stdin from other threads; the reader is not
+            // safe to share without this.
+            std::mutex inputMutex;
+        }
+
+        Value print(const Vec<Value>& args) {
+            writeValues(Isolate::current().getOutput(), args, "\n");
             return Value::makeNil();
         }
 
         Value write(const Vec<Value>& args) {
-            for (size_t i = 0; i < args.size(); ++i) {
-                if (i > 0) std::cout << " ";
-                std::cout << args[i].toString();
+            writeValues(Isolate::current().getOutput(), args, "");
+            return Value::makeNil();
+        }
+
+        Value flush(const Vec<Value>& args) {
+            if (!args.empty()) {
+                throw RuntimeError("console.flush() expects no arguments");
             }
-            std::cout << std::flush;
 
+            Isolate::current().getOutput().flush();
             return Value::makeNil();
         }
 
         Value error(const Vec<Value>& args) {
-            for (size_t i = 0; i < args.size(); ++i) {
-                if (i > 0) std::cerr << " ";
-                std::cerr << args[i].toString();
+            writeValues(std::cerr, args, "\n");
+            return Value::makeNil();
+        }
+
+        // The next line of stdin without its line ending, or nil at the
+        // end of input. Output written so far is flushed first, so a
+        // prompt shows before the script waits.
+        Value readLine(const Vec<Value>& args) {
+            if (!args.empty()) {
+                throw RuntimeError("console.readLine() expects no arguments");
             }
-            std::cerr << std::endl;
 
-            return Value::makeNil();
+            std::lock_guard<std::mutex> lock(inputMutex);
+            std::string_view line;
+            if (!LineReader::standardInput()->nextLine(line)) {
+                return Value::makeNil();
+            }
+            return Value::makeString(::String(line));
+        }
+
+        // True once stdin has no line left to read. An empty line and the
+        // end both make console.readLine() falsy; this tells them apart.
+        // Like readLine(), it waits for input until it can tell.
+        Value eof(const Vec<Value>& args) {
+            if (!args.empty()) {
+                throw RuntimeError("console.eof() expects no arguments");
+            }
+
+            std::lock_guard<std::mutex> lock(inputMutex);
+            return Value::makeBool(LineReader::standardInput()->atEnd());
+        }
+
+        // The rest of stdin as one string; empty at the end of input.
+        Value readAll(const Vec<Value>& args) {
+            if (!args.empty()) {
+                throw RuntimeError("console.readAll() expects no arguments");
+            }
+
+            std::lock_guard<std::mutex> lock(inputMutex);
+            ::String text;
+            LineReader::standardInput()->readRest(text);
+            return Value::makeString(std::move(text));
+        }
+
+        // A reader over stdin for "for line: console.lines(), { ... }" or
+        // reader.nextLine(). It shares its buffer with console.readLine(),
+        // so the two can be mixed; closing it ends stdin for both.
+        Value lines(const Vec<Value>& args) {
+            if (!args.empty()) {
+                throw RuntimeError("console.lines() expects no arguments");
+            }
+
+            return Value::makeReader(LineReader::standardInput());
         }
 
     } 
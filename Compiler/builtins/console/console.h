@@ -7,7 +7,12 @@ namespace Builtins {
 	namespace Console {
 		Value print(const Vec<Value>& args);
 		Value write(const Vec<Value>& args);
+		Value flush(const Vec<Value>& args);
 		Value error(const Vec<Value>& args);
+		Value readLine(const Vec<Value>& args);
+		Value eof(const Vec<Value>& args);
+		Value readAll(const Vec<Value>& args);
+		Value lines(const Vec<Value>& args);
 
 	}
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "csv.h"
+#include "../../utils/Error.h"
+#include "../../runtime/CsvReader.h"
+
+namespace Builtins {
+    namespace Csv {
+        namespace {
+            // The column types, given as e.g. "int,string,float". Columns
+            // left out or left empty stay strings.
+            Vec<CsvReader::ColumnType> parseColumns(std::string_view spec, const char* name) {
+                Vec<CsvReader::ColumnType> columns;
+                if (spec.empty()) {
+                    return columns;
+                }
+
+                while (true) {
+                    size_t comma = spec.find(',');
+                    std::string_view type = spec.substr(0, comma);
+                    if (type == "int") {
+                        columns.push_back(CsvReader::ColumnType::INT);
+                    }
+                    else if (type == "float") {
+                        columns.push_back(CsvReader::ColumnType::FLOAT);
+                    }
+                    else if (type == "string" || type.empty()) {
+                        columns.push_back(CsvReader::ColumnType::STRING);
+                    }
+                    else {
+                        throw TypeError(::String("csv.") + name + "() column type must be \"int\", \"float\" or \"string\", got \"" +
+                            ::String(type) + "\"");
+                    }
+
+                    if (comma == std::string_view::npos) {
+                        return columns;
+                    }
+                    spec.remove_prefix(comma + 1);
+                }
+            }
+
+            // (path[, delimiter[, columns]]), for both open() and rows().
+            Value openReader(const Vec<Value>& args, const char* name) {
+                if (args.empty() || args.size() > 3) {
+                    throw RuntimeError(::String("csv.") + name + "() expects 1 to 3 arguments (filename, delimiter, column types)");
+                }
+
+                if (!args[0].isString()) {
+                    throw TypeError(::String("csv.") + name + "() requires string filename");
+                }
+
+                char delimiter = ',';
+                if (args.size() > 1) {
+                    if (!args[1].isString() || args[1].asStringView().size() != 1 ||
+                        args[1].asStringView()[0] == '"' || args[1].asStringView()[0] == '\n' ||
+                        args[1].asStringView()[0] == '\r') {
+                        throw TypeError(::String("csv.") + name + "() delimiter must be a single character other than a quote or line break");
+                    }
+                    delimiter = args[1].asStringView()[0];
+                }
+
+                Vec<CsvReader::ColumnType> columns;
+                if (args.size() > 2) {
+                    if (!args[2].isString()) {
+                        throw TypeError(::String("csv.") + name + "() column types must be a string");
+                    }
+                    columns = parseColumns(args[2].asStringView(), name);
+                }
+
+                return Value::makeCsvReader(CsvReader::open(args[0].asString(), delimiter, std::move(columns)));
+            }
+        }
+
+        // A reader for csv.nextRow().
+        Value open(const Vec<Value>& args) {
+            return openReader(args, "open");
+        }
+
+        // The same reader, for "for row: csv.rows(path), { ... }".
+        Value rows(const Vec<Value>& args) {
+            return openReader(args, "rows");
+        }
+
+        // The next row as an array of fields, or nil once the file is
+        // exhausted or the reader closed.
+        Value nextRow(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isCsvReader()) {
+                throw TypeError("csv.nextRow() requires a csv reader");
+            }
+
+            return args[0].asCsvReader()->nextRow();
+        }
+
+        // True once nextRow() has no row left to return.
+        Value eof(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isCsvReader()) {
+                throw TypeError("csv.eof() requires a csv reader");
+            }
+
+            return Value::makeBool(args[0].asCsvReader()->atEnd());
+        }
+
+        Value close(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isCsvReader()) {
+                throw TypeError("csv.close() requires a csv reader");
+            }
+
+            args[0].asCsvReader()->close();
+            return Value::makeNil();
+        }
+    }
+}
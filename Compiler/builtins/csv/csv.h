@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Csv {
+		Value open(const Vec<Value>& args);
+		Value rows(const Vec<Value>& args);
+		Value nextRow(const Vec<Value>& args);
+		Value eof(const Vec<Value>& args);
+		Value close(const Vec<Value>& args);
+	}
+}
@@ -1,7 +1,83 @@
 #include "file.h"
 #include "../../utils/Error.h"
+#include "../../runtime/Isolate.h"
+#include "../../runtime/MappedFile.h"
+#include "../../runtime/LineReader.h"
+#include "../../runtime/FileWriter.h"
+#include "../../runtime/BinaryFile.h"
+#include "../../runtime/FileSystem.h"
+#include "../../runtime/Heap.h"
 #include <fstream>
-#include <sstream>
+#include <iterator>
+
+namespace {
+    // Reads straight into a string of the file's size: one copy from the
+    // OS instead of going through a stringstream.
+    String readFile(const String& filename) {
+        std::ifstream file(filename);
+
+        if (!file.is_open()) {
+            throw RuntimeError("Failed to open file: " + filename);
+        }
+
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        file.seekg(0, std::ios::beg);
+
+        String content;
+        if (size > 0) {
+            content.resize(static_cast<size_t>(size));
+            file.read(&content[0], size);
+            // Text mode may shrink the content (CRLF on Windows).
+            content.resize(static_cast<size_t>(file.gcount()));
+        }
+        else {
+            // Not seekable (a pipe, say): fall back to reading it all.
+            content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        return content;
+    }
+
+    void writeFile(const String& filename, std::string_view content) {
+        std::ofstream file(filename);
+
+        if (!file.is_open()) {
+            throw RuntimeError("Failed to open file for writing: " + filename);
+        }
+
+        file << content;
+    }
+
+    // file.openWrite(path[, bufferSize[, sync]]) and file.append(...).
+    Value openWriter(const Vec<Value>& args, bool append, const char* name) {
+        if (args.empty() || args.size() > 3 || !args[0].isString() ||
+            (args.size() > 1 && !args[1].isInt()) || (args.size() > 2 && !args[2].isString())) {
+            throw TypeError(String("file.") + name +
+                "() requires a filename, an optional buffer size and an optional sync policy");
+        }
+
+        size_t bufferSize = FileWriter::DEFAULT_BUFFER_SIZE;
+        if (args.size() > 1) {
+            if (args[1].asInt() < 0) {
+                throw RuntimeError(String("file.") + name + "() buffer size cannot be negative");
+            }
+            bufferSize = static_cast<size_t>(args[1].asInt());
+        }
+
+        FileWriter::SyncPolicy sync = FileWriter::SyncPolicy::NONE;
+        if (args.size() > 2) {
+            const String& policy = args[2].asString();
+            if (policy == "flush") sync = FileWriter::SyncPolicy::FLUSH;
+            else if (policy == "close") sync = FileWriter::SyncPolicy::CLOSE;
+            else if (policy != "none") {
+                throw RuntimeError(String("file.") + name +
+                    "() sync policy must be \"none\", \"flush\" or \"close\", got \"" + policy + "\"");
+            }
+        }
+
+        return Value::makeWriter(FileWriter::open(args[0].asString(), append, bufferSize, sync));
+    }
+}
 
 namespace Builtins {
     namespace File {
@@ -15,21 +91,102 @@ namespace Builtins {
                 throw TypeError("file.read() requires string filename");
             }
 
-            String filename = args[0].asString();
-            std::ifstream file(filename);
+            return Value::makeString(readFile(args[0].asString()));
+        }
 
-            if (!file.is_open()) {
-                throw RuntimeError("Failed to open file: " + filename);
+        // The whole file as a string backed by a read-only mapping: no copy
+        // is made, and pages are read from disk as the script touches them.
+        Value map(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("file.map() expects 1 argument (filename)");
             }
 
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            file.close();
+            if (!args[0].isString()) {
+                throw TypeError("file.map() requires string filename");
+            }
+
+            return Value::makeMappedString(MappedFile::open(args[0].asString()));
+        }
+
+        // A reader for reader.nextLine(); the file is read through one
+        // buffer instead of being loaded whole.
+        Value open(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("file.open() expects 1 argument (filename)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("file.open() requires string filename");
+            }
+
+            return Value::makeReader(LineReader::open(args[0].asString()));
+        }
+
+        // The same reader, for "for line: file.lines(path), { ... }".
+        Value lines(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("file.lines() expects 1 argument (filename)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("file.lines() requires string filename");
+            }
+
+            return Value::makeReader(LineReader::open(args[0].asString()));
+        }
+
+        // Calls a function on every line, spread over the worker threads
+        // when the function is parallel-safe. The optional mode says how
+        // results are merged: "sum" (the default), "count" of truthy
+        // results, or "map" for an array of them in line order.
+        Value parallelLines(const Vec<Value>& args) {
+            if (args.size() < 2 || args.size() > 3 || !args[0].isString() ||
+                !(args[1].isString() || args[1].isFunction()) || (args.size() == 3 && !args[2].isString())) {
+                throw TypeError("file.parallelLines() requires a filename, a function name and an optional mode");
+            }
+
+            ScriptHost::Aggregate aggregate = ScriptHost::Aggregate::SUM;
+            if (args.size() == 3) {
+                const ::String& mode = args[2].asString();
+                if (mode == "count") aggregate = ScriptHost::Aggregate::COUNT;
+                else if (mode == "map") aggregate = ScriptHost::Aggregate::MAP;
+                else if (mode != "sum") {
+                    throw RuntimeError("file.parallelLines() mode must be \"sum\", \"count\" or \"map\", got \"" +
+                        mode + "\"");
+                }
+            }
+
+            ScriptHost* host = Isolate::current().getHost();
+            if (!host) {
+                throw RuntimeError("file.parallelLines() is not available here");
+            }
 
-            return Value::makeString(buffer.str());
+            const ::String& function = args[1].isString() ? args[1].asString() : args[1].asFunctionName();
+            return host->callOverLines(aggregate, function, args[0].asString());
         }
 
+        // Truncates the file; writes through the handle are buffered.
+        Value openWrite(const Vec<Value>& args) {
+            return openWriter(args, false, "openWrite");
+        }
+
+        // Every write goes to the end of the file, after anything other
+        // writers appended in the meantime.
+        Value append(const Vec<Value>& args) {
+            return openWriter(args, true, "append");
+        }
+
+        // file.write(writer, content) writes through a handle;
+        // file.write(filename, content) replaces the whole file.
         Value write(const Vec<Value>& args) {
+            if (args.size() == 2 && args[0].isWriter()) {
+                if (!args[1].isString()) {
+                    throw TypeError("file.write() requires string content");
+                }
+                args[0].asWriter()->write(args[1].asStringView());
+                return Value::makeBool(true);
+            }
+
             if (args.size() != 2) {
                 throw RuntimeError("file.write() expects 2 arguments (filename, content)");
             }
@@ -42,18 +199,81 @@ namespace Builtins {
                 throw TypeError("file.write() requires string content");
             }
 
-            String filename = args[0].asString();
-            String content = args[1].asString();
+            writeFile(args[0].asString(), args[1].asStringView());
+            return Value::makeBool(true);
+        }
 
-            std::ofstream file(filename);
+        Value flush(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isWriter()) {
+                throw TypeError("file.flush() requires a writer");
+            }
 
-            if (!file.is_open()) {
-                throw RuntimeError("Failed to open file for writing: " + filename);
+            args[0].asWriter()->flush();
+            return Value::makeNil();
+        }
+
+        // Closes a writer, writing out what it buffered, or a reader.
+        Value close(const Vec<Value>& args) {
+            if (args.size() != 1 || !(args[0].isWriter() || args[0].isReader())) {
+                throw TypeError("file.close() requires a writer or a reader");
             }
 
-            file << content;
-            file.close();
+            if (args[0].isWriter()) {
+                args[0].asWriter()->close();
+            }
+            else {
+                args[0].asReader()->discard();
+            }
+            return Value::makeNil();
+        }
+
+        // file.readBytes(path) reads the whole file into a new byte buffer.
+        // file.readBytes(path, buffer, offset) fills an existing buffer (or
+        // a slice of one) from that file offset and returns how many bytes
+        // it read, fewer than the buffer holds only at the end of the file.
+        Value readBytes(const Vec<Value>& args) {
+            if (args.size() == 1 && args[0].isString()) {
+                const ::String& path = args[0].asString();
+                uint64_t size = BinaryFile::size(path);
+                if (size > static_cast<uint64_t>(SIZE_MAX)) {
+                    throw RuntimeError("File too large to read: " + path);
+                }
+
+                Value bytes = Value::makeBytes(static_cast<size_t>(size), false);
+                size_t read = BinaryFile::readAt(path, bytes.asBytes()->data, bytes.asBytes()->length, 0);
+                return read == bytes.asBytes()->length ? bytes : Value::makeBytesSlice(bytes, 0, read);
+            }
+
+            if (args.size() != 3 || !args[0].isString() || !args[1].isBytes() || !args[2].isInt()) {
+                throw TypeError("file.readBytes() requires a filename, optionally followed by a byte buffer and an offset");
+            }
+            if (args[2].asInt() < 0) {
+                throw RuntimeError("file.readBytes() offset cannot be negative");
+            }
+
+            BytesObject* bytes = args[1].asBytes();
+            size_t read = BinaryFile::readAt(args[0].asString(), bytes->data, bytes->length,
+                static_cast<uint64_t>(args[2].asInt()));
+            return Value::makeInt(static_cast<int64_t>(read));
+        }
 
+        // file.writeBytes(path, buffer) replaces the file with the buffer's
+        // bytes; with an offset they are written there and the rest of the
+        // file is kept.
+        Value writeBytes(const Vec<Value>& args) {
+            if (args.size() < 2 || args.size() > 3 || !args[0].isString() || !args[1].isBytes() ||
+                (args.size() == 3 && !args[2].isInt())) {
+                throw TypeError("file.writeBytes() requires a filename, a byte buffer and an optional offset");
+            }
+
+            int64_t offset = args.size() == 3 ? args[2].asInt() : 0;
+            if (offset < 0) {
+                throw RuntimeError("file.writeBytes() offset cannot be negative");
+            }
+
+            BytesObject* bytes = args[1].asBytes();
+            BinaryFile::writeAt(args[0].asString(), bytes->data, bytes->length, static_cast<uint64_t>(offset),
+                args.size() == 2);
             return Value::makeBool(true);
         }
 
@@ -86,13 +306,51 @@ namespace Builtins {
                 throw TypeError("file.exists() requires string filename");
             }
 
-            String filename = args[0].asString();
-            std::ifstream file(filename);
-            bool fileExists = file.good();
-            file.close();
+            // One stat call rather than opening the file; true for
+            // directories and unreadable files too.
+            FileSystem::Status status;
+            return Value::makeBool(FileSystem::stat(args[0].asString(), status));
+        }
+
+        // The async variants do the file access on a background thread and
+        // return a task; the string (or error) is delivered on await.
+        Value readAsync(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("file.readAsync() expects 1 argument (filename)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("file.readAsync() requires string filename");
+            }
 
-            return Value::makeBool(fileExists);
+            String filename = args[0].asString();
+            TaskObject* task = Isolate::current().getEventLoop().submit([filename]() -> EventLoop::Completion {
+                auto content = std::make_shared<String>(readFile(filename));
+                return [content] { return Value::makeString(std::move(*content)); };
+            });
+            return Value::makeTask(task);
         }
 
+        Value writeAsync(const Vec<Value>& args) {
+            if (args.size() != 2) {
+                throw RuntimeError("file.writeAsync() expects 2 arguments (filename, content)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("file.writeAsync() requires string filename");
+            }
+
+            if (!args[1].isString()) {
+                throw TypeError("file.writeAsync() requires string content");
+            }
+
+            String filename = args[0].asString();
+            String content(args[1].asStringView());
+            TaskObject* task = Isolate::current().getEventLoop().submit([filename, content]() -> EventLoop::Completion {
+                writeFile(filename, content);
+                return [] { return Value::makeBool(true); };
+            });
+            return Value::makeTask(task);
+        }
     } 
 } 
\ No newline at end of file
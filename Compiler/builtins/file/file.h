@@ -6,8 +6,20 @@
 namespace Builtins {
 	namespace File {
 		Value read(const Vec<Value>& args);
+		Value map(const Vec<Value>& args);
+		Value open(const Vec<Value>& args);
+		Value lines(const Vec<Value>& args);
+		Value parallelLines(const Vec<Value>& args);
+		Value openWrite(const Vec<Value>& args);
+		Value append(const Vec<Value>& args);
 		Value write(const Vec<Value>& args);
+		Value flush(const Vec<Value>& args);
+		Value close(const Vec<Value>& args);
+		Value readBytes(const Vec<Value>& args);
+		Value writeBytes(const Vec<Value>& args);
 		Value create(const Vec<Value>& args);
 		Value exists(const Vec<Value>& args);
+		Value readAsync(const Vec<Value>& args);
+		Value writeAsync(const Vec<Value>& args);
 	} 
 }
\ No newline at end of file
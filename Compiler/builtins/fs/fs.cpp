@@ -0,0 +1,139 @@
+#include "fs.h"
+#include "../../utils/Error.h"
+#include "../../runtime/Heap.h"
+#include "../../runtime/FileSystem.h"
+#include "../../runtime/Json.h"
+#include "../../runtime/DirectoryWalker.h"
+#include <algorithm>
+
+namespace Builtins {
+    namespace Fs {
+        namespace {
+            Value makeStrings(Vec<::String>& strings) {
+                Value array = Value::makeArray(strings.size());
+                Vec<Value>& elements = array.asArray()->elements;
+                for (size_t i = 0; i < strings.size(); ++i) {
+                    elements[i] = Value::makeString(std::move(strings[i]));
+                }
+                return array;
+            }
+
+            // (root[, pattern]), for both walk() and walker().
+            Ptr<DirectoryWalker> openWalker(const Vec<Value>& args, const char* name) {
+                if (args.empty() || args.size() > 2) {
+                    throw RuntimeError(::String("fs.") + name + "() expects 1 or 2 arguments (directory, pattern)");
+                }
+
+                if (!args[0].isString() || (args.size() == 2 && !args[1].isString())) {
+                    throw TypeError(::String("fs.") + name + "() requires string directory and pattern");
+                }
+
+                return DirectoryWalker::open(args[0].asString(), args.size() == 2 ? args[1].asString() : ::String());
+            }
+        }
+
+        // The names in a directory, sorted, without "." and "..".
+        Value list(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("fs.list() expects 1 argument (directory)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("fs.list() requires string directory");
+            }
+
+            const ::String& path = args[0].asString();
+            Ptr<FileSystem::Directory> directory = FileSystem::Directory::open(path);
+            if (!directory) {
+                throw RuntimeError("Failed to open directory: " + path);
+            }
+
+            Vec<::String> names;
+            directory->read([&](std::string_view name, FileSystem::EntryType) {
+                names.emplace_back(name);
+            });
+            std::sort(names.begin(), names.end());
+            return makeStrings(names);
+        }
+
+        // Every path under a directory whose name matches the pattern
+        // ("*.txt"; all of them if it is left out), sorted. For trees too
+        // big to hold at once, fs.walker() hands them over in batches.
+        Value walk(const Vec<Value>& args) {
+            Ptr<DirectoryWalker> walker = openWalker(args, "walk");
+
+            Vec<::String> paths;
+            Vec<::String> batch;
+            while (walker->nextBatch(batch)) {
+                if (paths.empty()) {
+                    paths = std::move(batch);
+                }
+                else {
+                    paths.insert(paths.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+                }
+            }
+            std::sort(paths.begin(), paths.end());
+            return makeStrings(paths);
+        }
+
+        // A walker for fs.nextBatch() or "for paths: fs.walker(root), { ... }",
+        // which yields arrays of up to 1024 paths in no particular order.
+        Value walker(const Vec<Value>& args) {
+            return Value::makeDirectoryWalker(openWalker(args, "walker"));
+        }
+
+        // The next batch of paths, or nil once the walk is over or the
+        // walker closed.
+        Value nextBatch(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isDirectoryWalker()) {
+                throw TypeError("fs.nextBatch() requires a walker");
+            }
+
+            return args[0].asDirectoryWalker()->nextBatch();
+        }
+
+        // True once nextBatch() has no batch left to return; waits for the
+        // walk to produce one or finish.
+        Value done(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isDirectoryWalker()) {
+                throw TypeError("fs.done() requires a walker");
+            }
+
+            return Value::makeBool(args[0].asDirectoryWalker()->done());
+        }
+
+        Value close(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isDirectoryWalker()) {
+                throw TypeError("fs.close() requires a walker");
+            }
+
+            args[0].asDirectoryWalker()->close();
+            return Value::makeNil();
+        }
+
+        // An object with the fields size (bytes), mtime (seconds since the
+        // epoch) and type ("file", "directory", "symlink" or "other"),
+        // read with json.get(); nil if nothing is there.
+        Value stat(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("fs.stat() expects 1 argument (path)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("fs.stat() requires string path");
+            }
+
+            FileSystem::Status status;
+            if (!FileSystem::stat(args[0].asString(), status)) {
+                return Value::makeNil();
+            }
+
+            Value result = Value::makeStruct(::Json::OBJECT_TYPE);
+            Map<::String, Value>& fields = result.asStruct()->fields;
+            fields["size"] = Value::makeInt(static_cast<int64_t>(status.size));
+            fields["mtime"] = Value::makeFloat(status.modified);
+            fields["type"] = Value::makeString(FileSystem::typeName(status.type));
+            return result;
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Fs {
+		Value list(const Vec<Value>& args);
+		Value walk(const Vec<Value>& args);
+		Value walker(const Vec<Value>& args);
+		Value nextBatch(const Vec<Value>& args);
+		Value done(const Vec<Value>& args);
+		Value close(const Vec<Value>& args);
+		Value stat(const Vec<Value>& args);
+	}
+}
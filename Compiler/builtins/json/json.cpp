@@ -0,0 +1,139 @@
+#include "json.h"
+#include "../../utils/Error.h"
+#include "../../runtime/Heap.h"
+#include "../../runtime/Json.h"
+
+namespace Builtins {
+    namespace Json {
+        Value parse(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isString()) {
+                throw TypeError("json.parse() requires a string");
+            }
+
+            return ::Json::parse(args[0].asStringView());
+        }
+
+        // (value[, indent]); compact unless indent is above zero.
+        Value stringify(const Vec<Value>& args) {
+            if (args.empty() || args.size() > 2) {
+                throw RuntimeError("json.stringify() expects 1 or 2 arguments (value, indent)");
+            }
+
+            int64_t indent = 0;
+            if (args.size() == 2) {
+                if (!args[1].isInt() || args[1].asInt() < 0 || args[1].asInt() > 16) {
+                    throw TypeError("json.stringify() indent must be an integer from 0 to 16");
+                }
+                indent = args[1].asInt();
+            }
+
+            return Value::makeString(::Json::stringify(args[0], static_cast<int>(indent)));
+        }
+
+        // An empty object for json.set().
+        Value object(const Vec<Value>& args) {
+            if (!args.empty()) {
+                throw RuntimeError("json.object() expects no arguments");
+            }
+
+            return Value::makeStruct(::Json::OBJECT_TYPE);
+        }
+
+        // A member of an object by name, or an element of an array by
+        // index; nil when there is no such member or element.
+        Value get(const Vec<Value>& args) {
+            if (args.size() != 2) {
+                throw RuntimeError("json.get() expects 2 arguments (object or array, key or index)");
+            }
+
+            if (args[0].isStruct() && args[1].isString()) {
+                const Map<::String, Value>& fields = args[0].asStruct()->fields;
+                auto it = fields.find(::String(args[1].asStringView()));
+                return it != fields.end() ? it->second : Value::makeNil();
+            }
+
+            if (args[0].isArray() && args[1].isInt()) {
+                const Vec<Value>& elements = args[0].asArray()->elements;
+                int64_t index = args[1].asInt();
+                return index >= 0 && static_cast<uint64_t>(index) < elements.size()
+                    ? elements[static_cast<size_t>(index)] : Value::makeNil();
+            }
+
+            throw TypeError("json.get() requires an object and a string key, or an array and an integer index");
+        }
+
+        // Only objects take new members; other structs keep the fields
+        // their definition declares.
+        Value set(const Vec<Value>& args) {
+            if (args.size() != 3 || !args[0].isStruct() || !args[1].isString()) {
+                throw TypeError("json.set() requires an object, a string key and a value");
+            }
+            if (args[0].asStruct()->typeName != ::Json::OBJECT_TYPE) {
+                throw TypeError("json.set() requires an object, got struct '" + args[0].asStruct()->typeName + "'");
+            }
+
+            args[0].asStruct()->fields.insert_or_assign(::String(args[1].asStringView()), args[2]);
+            return Value::makeNil();
+        }
+
+        // The member names of an object, in sorted order.
+        Value keys(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isStruct()) {
+                throw TypeError("json.keys() requires an object");
+            }
+
+            const Map<::String, Value>& fields = args[0].asStruct()->fields;
+            Value array = Value::makeArray(fields.size());
+            size_t i = 0;
+            for (auto& field : fields) {
+                array.asArray()->elements[i++] = Value::makeString(field.first);
+            }
+            return array;
+        }
+
+        // A reader of newline-delimited JSON, for json.next() or
+        // "for value: json.lines(path), { ... }".
+        Value lines(const Vec<Value>& args) {
+            if (args.size() != 1) {
+                throw RuntimeError("json.lines() expects 1 argument (filename)");
+            }
+
+            if (!args[0].isString()) {
+                throw TypeError("json.lines() requires string filename");
+            }
+
+            return Value::makeNdjsonReader(MAKE_PTR(NdjsonReader, LineReader::open(args[0].asString())));
+        }
+
+        // The value on the next non-blank line, or nil once the file is
+        // exhausted or the reader closed. A line holding null reads as nil
+        // too; json.eof() or a for loop over the reader tells the two apart.
+        Value next(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isNdjsonReader()) {
+                throw TypeError("json.next() requires an ndjson reader");
+            }
+
+            Value value;
+            return args[0].asNdjsonReader()->next(value) ? value : Value::makeNil();
+        }
+
+        // True once next() has no value left to return, which a null line
+        // read as nil cannot show.
+        Value eof(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isNdjsonReader()) {
+                throw TypeError("json.eof() requires an ndjson reader");
+            }
+
+            return Value::makeBool(args[0].asNdjsonReader()->atEnd());
+        }
+
+        Value close(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isNdjsonReader()) {
+                throw TypeError("json.close() requires an ndjson reader");
+            }
+
+            args[0].asNdjsonReader()->close();
+            return Value::makeNil();
+        }
+    }
+}
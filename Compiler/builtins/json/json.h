@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Json {
+		Value parse(const Vec<Value>& args);
+		Value stringify(const Vec<Value>& args);
+		Value object(const Vec<Value>& args);
+		Value get(const Vec<Value>& args);
+		Value set(const Vec<Value>& args);
+		Value keys(const Vec<Value>& args);
+		Value lines(const Vec<Value>& args);
+		Value next(const Vec<Value>& args);
+		Value eof(const Vec<Value>& args);
+		Value close(const Vec<Value>& args);
+	}
+}
@@ -1,36 +1,68 @@
 #include "Math.h"
 #include "../../utils/Error.h"
+#include "../../utils/CheckedMath.h"
 #include <cmath>
 #include <algorithm>
 
 namespace Builtins {
     namespace Math {
 
+        namespace {
+            bool isNumber(const Value& value) {
+                return value.isInt() || value.isFloat();
+            }
+
+            double toDouble(const Value& value) {
+                return value.isInt() ? static_cast<double>(value.asInt()) : value.asFloat();
+            }
+
+            // floor() and ceil() of a float give an int, so the result must
+            // be finite and in range.
+            Value roundedToInt(double value, const char* name) {
+                if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0)) {
+                    throw RuntimeError(::String("math.") + name + "() result does not fit in an integer");
+                }
+                return Value::makeInt(static_cast<int64_t>(value));
+            }
+        }
+
         Value abs(const Vec<Value>& args) {
             if (args.size() != 1) {
                 throw RuntimeError("math.abs() expects 1 argument");
             }
 
+            if (args[0].isFloat()) {
+                return Value::makeFloat(std::fabs(args[0].asFloat()));
+            }
+
             if (!args[0].isInt()) {
-                throw TypeError("math.abs() requires integer argument");
+                throw TypeError("math.abs() requires numeric argument");
             }
 
-            int value = args[0].asInt();
+            int64_t value = args[0].asInt();
+            int64_t result;
+            if (value < 0 && CheckedMath::subOverflow(0, value, result)) {
+                throw RuntimeError("Integer overflow in math.abs()");
+            }
             return Value::makeInt(value < 0 ? -value : value);
         }
 
+        // Two ints give an int; a float on either side gives a float.
         Value min(const Vec<Value>& args) {
             if (args.size() != 2) {
                 throw RuntimeError("math.min() expects 2 arguments");
             }
 
-            if (!args[0].isInt() || !args[1].isInt()) {
-                throw TypeError("math.min() requires integer arguments");
+            if (!isNumber(args[0]) || !isNumber(args[1])) {
+                throw TypeError("math.min() requires numeric arguments");
             }
 
-            int a = args[0].asInt();
-            int b = args[1].asInt();
-            return Value::makeInt(a < b ? a : b);
+            if (args[0].isInt() && args[1].isInt()) {
+                int64_t a = args[0].asInt();
+                int64_t b = args[1].asInt();
+                return Value::makeInt(a < b ? a : b);
+            }
+            return Value::makeFloat(std::fmin(toDouble(args[0]), toDouble(args[1])));
         }
 
         Value max(const Vec<Value>& args) {
@@ -38,58 +70,98 @@ namespace Builtins {
                 throw RuntimeError("math.max() expects 2 arguments");
             }
 
-            if (!args[0].isInt() || !args[1].isInt()) {
-                throw TypeError("math.max() requires integer arguments");
+            if (!isNumber(args[0]) || !isNumber(args[1])) {
+                throw TypeError("math.max() requires numeric arguments");
             }
 
-            int a = args[0].asInt();
-            int b = args[1].asInt();
-            return Value::makeInt(a > b ? a : b);
+            if (args[0].isInt() && args[1].isInt()) {
+                int64_t a = args[0].asInt();
+                int64_t b = args[1].asInt();
+                return Value::makeInt(a > b ? a : b);
+            }
+            return Value::makeFloat(std::fmax(toDouble(args[0]), toDouble(args[1])));
         }
 
+        // Exact with two ints; std::pow once either is a float.
         Value pow(const Vec<Value>& args) {
             if (args.size() != 2) {
                 throw RuntimeError("math.pow() expects 2 arguments (base, exponent)");
             }
 
-            if (!args[0].isInt() || !args[1].isInt()) {
-                throw TypeError("math.pow() requires integer arguments");
+            if (!isNumber(args[0]) || !isNumber(args[1])) {
+                throw TypeError("math.pow() requires numeric arguments");
             }
 
-            int base = args[0].asInt();
-            int exp = args[1].asInt();
+            if (args[0].isFloat() || args[1].isFloat()) {
+                return Value::makeFloat(std::pow(toDouble(args[0]), toDouble(args[1])));
+            }
+
+            int64_t base = args[0].asInt();
+            int64_t exp = args[1].asInt();
+
+            if (exp < 0) {
+                if (base == 1) return Value::makeInt(1);
+                if (base == -1) return Value::makeInt(exp % 2 == 0 ? 1 : -1);
+                if (base == 0) throw RuntimeError("Division by zero in math.pow()");
+                return Value::makeInt(0);
+            }
 
-            double result = std::pow(static_cast<double>(base), static_cast<double>(exp));
-            return Value::makeInt(static_cast<int>(result));
+            int64_t result = 1;
+            while (exp > 0) {
+                if ((exp & 1) && CheckedMath::mulOverflow(result, base, result)) {
+                    throw RuntimeError("Integer overflow in math.pow()");
+                }
+                exp >>= 1;
+                if (exp > 0 && CheckedMath::mulOverflow(base, base, base)) {
+                    throw RuntimeError("Integer overflow in math.pow()");
+                }
+            }
+            return Value::makeInt(result);
         }
 
+        // The exact integer square root of an int; the float square root of
+        // a float.
         Value sqrt(const Vec<Value>& args) {
             if (args.size() != 1) {
                 throw RuntimeError("math.sqrt() expects 1 argument");
             }
 
+            if (args[0].isFloat()) {
+                if (args[0].asFloat() < 0) {
+                    throw RuntimeError("math.sqrt() requires non-negative argument");
+                }
+                return Value::makeFloat(std::sqrt(args[0].asFloat()));
+            }
+
             if (!args[0].isInt()) {
-                throw TypeError("math.sqrt() requires integer argument");
+                throw TypeError("math.sqrt() requires numeric argument");
             }
 
-            int value = args[0].asInt();
+            int64_t value = args[0].asInt();
             if (value < 0) {
                 throw RuntimeError("math.sqrt() requires non-negative argument");
             }
 
-            double result = std::sqrt(static_cast<double>(value));
-            return Value::makeInt(static_cast<int>(result));
+            int64_t result = static_cast<int64_t>(std::sqrt(static_cast<double>(value)));
+            while (result > 0 && result > value / result) result--;
+            while ((result + 1) <= value / (result + 1)) result++;
+            return Value::makeInt(result);
         }
 
+        // An int either way; an int argument is already whole.
         Value floor(const Vec<Value>& args) {
             if (args.size() != 1) {
                 throw RuntimeError("math.floor() expects 1 argument");
             }
 
+            if (args[0].isFloat()) {
+                return roundedToInt(std::floor(args[0].asFloat()), "floor");
+            }
+
             if (!args[0].isInt()) {
-                throw TypeError("math.floor() requires integer argument");
+                throw TypeError("math.floor() requires numeric argument");
             }
-     
+
             return args[0];
         }
 
@@ -98,8 +170,12 @@ namespace Builtins {
                 throw RuntimeError("math.ceil() expects 1 argument");
             }
 
+            if (args[0].isFloat()) {
+                return roundedToInt(std::ceil(args[0].asFloat()), "ceil");
+            }
+
             if (!args[0].isInt()) {
-                throw TypeError("math.ceil() requires integer argument");
+                throw TypeError("math.ceil() requires numeric argument");
             }
 
             return args[0];
@@ -0,0 +1,37 @@
+#include "parallel.h"
+#include "../../utils/Error.h"
+#include "../../runtime/Heap.h"
+#include "../../runtime/Isolate.h"
+
+namespace Builtins {
+    namespace Parallel {
+        namespace {
+            Value callOverRange(ScriptHost::Aggregate aggregate, const Vec<Value>& args, const char* name) {
+                if (args.size() != 3 || !(args[0].isString() || args[0].isFunction()) ||
+                    !args[1].isInt() || !args[2].isInt()) {
+                    throw TypeError(::String("parallel.") + name + "() requires a function name and two integers");
+                }
+
+                ScriptHost* host = Isolate::current().getHost();
+                if (!host) {
+                    throw RuntimeError(::String("parallel.") + name + "() is not available here");
+                }
+
+                const ::String& function = args[0].isString() ? args[0].asString() : args[0].asFunctionName();
+                return host->callOverRange(aggregate, function, args[1].asInt(), args[2].asInt());
+            }
+        }
+
+        Value sum(const Vec<Value>& args) {
+            return callOverRange(ScriptHost::Aggregate::SUM, args, "sum");
+        }
+
+        Value count(const Vec<Value>& args) {
+            return callOverRange(ScriptHost::Aggregate::COUNT, args, "count");
+        }
+
+        Value map(const Vec<Value>& args) {
+            return callOverRange(ScriptHost::Aggregate::MAP, args, "map");
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Parallel {
+		Value sum(const Vec<Value>& args);
+		Value count(const Vec<Value>& args);
+		Value map(const Vec<Value>& args);
+	}
+}
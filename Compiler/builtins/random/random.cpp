@@ -1,62 +1,252 @@
 #include "Random.h"
 #include "../../utils/Error.h"
-#include <random>
+#include "../../runtime/Isolate.h"
+#include "../../runtime/Heap.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Builtins {
     namespace Random {
+        namespace {
+            // Every function takes an optional trailing generator name; without
+            // one it uses the isolate's default generator.
+            Xoshiro256& generatorArg(const Vec<Value>& args, size_t index, const char* function) {
+                Isolate& isolate = Isolate::current();
+                if (args.size() <= index) {
+                    return isolate.getRandom();
+                }
 
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
+                if (!args[index].isString()) {
+                    throw TypeError(::String("random.") + function + "() generator name must be a string");
+                }
+
+                const ::String& name = args[index].asString();
+                auto it = isolate.getGenerators().find(name);
+                if (it == isolate.getGenerators().end()) {
+                    throw RuntimeError("Unknown random generator '" + name + "', create it with random.seed(name, seed)");
+                }
+                return it->second;
+            }
+
+            // The count, min and max arguments shared by the bulk functions;
+            // min and max are swapped if given the wrong way round.
+            size_t countArg(const Vec<Value>& args, const char* function) {
+                if (!args[0].isInt() || args[0].asInt() < 0) {
+                    throw TypeError(::String("random.") + function + "() requires a non-negative integer count");
+                }
+                if (static_cast<uint64_t>(args[0].asInt()) > Constants::MAX_ARRAY_LENGTH) {
+                    throw RuntimeError(::String("random.") + function + "() count too large for an array: " +
+                        std::to_string(args[0].asInt()));
+                }
+                return static_cast<size_t>(args[0].asInt());
+            }
+
+            void intBounds(const Value& minArg, const Value& maxArg, const char* function, int64_t& min, int64_t& max) {
+                if (!minArg.isInt() || !maxArg.isInt()) {
+                    throw TypeError(::String("random.") + function + "() requires integer bounds");
+                }
+                min = std::min(minArg.asInt(), maxArg.asInt());
+                max = std::max(minArg.asInt(), maxArg.asInt());
+            }
+
+            void floatBounds(const Value& minArg, const Value& maxArg, const char* function, double& min, double& max) {
+                if (!minArg.isFloat() || !maxArg.isFloat()) {
+                    throw TypeError(::String("random.") + function + "() requires decimal bounds");
+                }
+                min = std::min(minArg.asFloat(), maxArg.asFloat());
+                max = std::max(minArg.asFloat(), maxArg.asFloat());
+            }
+
+            // The buffer the fill functions write, whose length must be a
+            // whole number of 8-byte values.
+            BytesObject* bufferArg(const Vec<Value>& args, const char* function) {
+                if (args.size() != 3 && args.size() != 4) {
+                    throw RuntimeError(::String("random.") + function +
+                        "() expects a byte buffer, min and max, and an optional generator");
+                }
+                if (!args[0].isBytes()) {
+                    throw TypeError(::String("random.") + function + "() requires a byte buffer");
+                }
+                BytesObject* bytes = args[0].asBytes();
+                if (bytes->length % 8 != 0) {
+                    throw RuntimeError(::String("random.") + function + "() buffer length must be a multiple of 8, got " +
+                        std::to_string(bytes->length));
+                }
+                return bytes;
+            }
+
+            // Little-endian, like the bytes.* functions by default.
+            void storeWord(uint8_t* data, uint64_t word) {
+                for (size_t i = 0; i < 8; ++i) {
+                    data[i] = static_cast<uint8_t>(word >> (8 * i));
+                }
+            }
+        }
 
         Value randomInt(const Vec<Value>& args) {
-            if (args.size() != 2) {
-                throw RuntimeError("random.int() expects 2 arguments (min, max)");
+            if (args.size() != 2 && args.size() != 3) {
+                throw RuntimeError("random.int() expects 2 arguments (min, max) and an optional generator");
             }
 
             if (!args[0].isInt() || !args[1].isInt()) {
                 throw TypeError("random.int() requires integer arguments");
             }
 
-            int min = args[0].asInt();
-            int max = args[1].asInt();
+            int64_t min = args[0].asInt();
+            int64_t max = args[1].asInt();
 
             if (min > max) {
                 std::swap(min, max);
             }
 
-            std::uniform_int_distribution<int> dist(min, max);
-            return Value::makeInt(dist(gen));
+            return Value::makeInt(generatorArg(args, 2, "int").between(min, max));
         }
 
         Value randomFloat(const Vec<Value>& args) {
-            if (args.size() != 2) {
-                throw RuntimeError("random.float() expects 2 arguments (min, max)");
+            if (args.size() != 2 && args.size() != 3) {
+                throw RuntimeError("random.float() expects 2 arguments (min, max) and an optional generator");
             }
 
-            double min = 0.0, max = 0.0;
+            if (!args[0].isFloat() || !args[1].isFloat()) {
+                throw TypeError("random.float() requires decimal arguments");
+            }
+
+            double min = args[0].asFloat();
+            double max = args[1].asFloat();
 
-            if (args[0].isFloat()) {
-                min = static_cast<double>(args[0].asFloat());  
+            if (min > max) {
+                std::swap(min, max);
+            }
+
+            return Value::makeFloat(min + generatorArg(args, 2, "float").unit() * (max - min));
+        }
+
+        // random.seed(seed) reseeds the default generator; random.seed(name,
+        // seed) creates or reseeds a named one.
+        Value seed(const Vec<Value>& args) {
+            Isolate& isolate = Isolate::current();
+
+            if (args.size() == 1 && args[0].isInt()) {
+                isolate.getRandom().reseed(static_cast<uint64_t>(args[0].asInt()));
+            }
+            else if (args.size() == 2 && args[0].isString() && args[1].isInt()) {
+                isolate.getGenerators()[args[0].asString()].reseed(static_cast<uint64_t>(args[1].asInt()));
             }
             else {
-                throw TypeError("random.float() requires decimal arguments");
+                throw TypeError("random.seed() expects an integer seed, optionally after a generator name");
+            }
+
+            return Value::makeNil();
+        }
+
+        // Skips 2^128 values, e.g. to give each of several runs its own
+        // stream from one seed.
+        Value jump(const Vec<Value>& args) {
+            if (args.size() > 1) {
+                throw RuntimeError("random.jump() expects an optional generator");
             }
 
-            if (args[1].isFloat()) {
-                max = static_cast<double>(args[1].asFloat());  
+            generatorArg(args, 0, "jump").jump();
+            return Value::makeNil();
+        }
+
+        Value bytes(const Vec<Value>& args) {
+            if (args.empty() || args.size() > 2 || !args[0].isInt() || args[0].asInt() < 0) {
+                throw TypeError("random.bytes() requires a non-negative integer count");
             }
-            else {
-                throw TypeError("random.float() requires decimal arguments");
+
+            Xoshiro256& generator = generatorArg(args, 1, "bytes");
+            size_t count = static_cast<size_t>(args[0].asInt());
+            ::String result(count, '\0');
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                uint64_t word = generator.next();
+                std::memcpy(&result[i], &word, 8);
+            }
+            if (i < count) {
+                uint64_t word = generator.next();
+                std::memcpy(&result[i], &word, count - i);
             }
 
-            if (min > max) {
-                std::swap(min, max);
+            return Value::makeString(std::move(result));
+        }
+
+        // random.ints(count, min, max) and random.floats(count, min, max)
+        // draw the same values, in the same order, as that many calls to
+        // random.int() or random.float(), into a new array.
+        Value ints(const Vec<Value>& args) {
+            if (args.size() != 3 && args.size() != 4) {
+                throw RuntimeError("random.ints() expects 3 arguments (count, min, max) and an optional generator");
             }
 
-            std::uniform_real_distribution<double> dist(min, max);
+            size_t count = countArg(args, "ints");
+            int64_t min;
+            int64_t max;
+            intBounds(args[1], args[2], "ints", min, max);
+            Xoshiro256& generator = generatorArg(args, 3, "ints");
 
-            return Value::makeFloat(static_cast<float>(dist(gen))); 
+            Value array = Value::makeArray(count);
+            Vec<Value>& elements = array.asArray()->elements;
+            for (size_t i = 0; i < count; ++i) {
+                elements[i] = Value::makeInt(generator.between(min, max));
+            }
+            return array;
         }
 
-    } 
-} 
\ No newline at end of file
+        Value floats(const Vec<Value>& args) {
+            if (args.size() != 3 && args.size() != 4) {
+                throw RuntimeError("random.floats() expects 3 arguments (count, min, max) and an optional generator");
+            }
+
+            size_t count = countArg(args, "floats");
+            double min;
+            double max;
+            floatBounds(args[1], args[2], "floats", min, max);
+            Xoshiro256& generator = generatorArg(args, 3, "floats");
+
+            Value array = Value::makeArray(count);
+            Vec<Value>& elements = array.asArray()->elements;
+            for (size_t i = 0; i < count; ++i) {
+                elements[i] = Value::makeFloat(min + generator.unit() * (max - min));
+            }
+            return array;
+        }
+
+        // random.fillInts(buffer, min, max) and random.fillFloats(buffer,
+        // min, max) fill a byte buffer with 8-byte values, read back with
+        // bytes.getInt(buffer, offset, 8) or bytes.getFloat(buffer, offset,
+        // 8), and return how many they wrote. Nothing is allocated, so a
+        // buffer can be refilled as often as needed.
+        Value fillInts(const Vec<Value>& args) {
+            BytesObject* bytes = bufferArg(args, "fillInts");
+            int64_t min;
+            int64_t max;
+            intBounds(args[1], args[2], "fillInts", min, max);
+            Xoshiro256& generator = generatorArg(args, 3, "fillInts");
+
+            size_t count = bytes->length / 8;
+            for (size_t i = 0; i < count; ++i) {
+                storeWord(bytes->data + i * 8, static_cast<uint64_t>(generator.between(min, max)));
+            }
+            return Value::makeInt(static_cast<int64_t>(count));
+        }
+
+        Value fillFloats(const Vec<Value>& args) {
+            BytesObject* bytes = bufferArg(args, "fillFloats");
+            double min;
+            double max;
+            floatBounds(args[1], args[2], "fillFloats", min, max);
+            Xoshiro256& generator = generatorArg(args, 3, "fillFloats");
+
+            size_t count = bytes->length / 8;
+            for (size_t i = 0; i < count; ++i) {
+                double value = min + generator.unit() * (max - min);
+                uint64_t word;
+                std::memcpy(&word, &value, sizeof(word));
+                storeWord(bytes->data + i * 8, word);
+            }
+            return Value::makeInt(static_cast<int64_t>(count));
+        }
+    }
+}
@@ -7,5 +7,12 @@ namespace Builtins {
 	namespace Random {
 		Value randomInt(const Vec<Value>& args);
 		Value randomFloat(const Vec<Value>& args);
+		Value seed(const Vec<Value>& args);
+		Value jump(const Vec<Value>& args);
+		Value bytes(const Vec<Value>& args);
+		Value ints(const Vec<Value>& args);
+		Value floats(const Vec<Value>& args);
+		Value fillInts(const Vec<Value>& args);
+		Value fillFloats(const Vec<Value>& args);
 	}
 } 
\ No newline at end of file
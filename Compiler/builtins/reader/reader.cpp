@@ -0,0 +1,40 @@
+#include "reader.h"
+#include "../../utils/Error.h"
+#include "../../runtime/LineReader.h"
+
+namespace Builtins {
+    namespace Reader {
+        // The next line without its line ending, or nil once the file is
+        // exhausted or the reader closed.
+        Value nextLine(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isReader()) {
+                throw TypeError("reader.nextLine() requires a reader");
+            }
+
+            std::string_view line;
+            if (!args[0].asReader()->nextLine(line)) {
+                return Value::makeNil();
+            }
+            return Value::makeString(::String(line));
+        }
+
+        // True once nextLine() has nothing left to return, so a loop can
+        // stop at the end rather than at the first empty line.
+        Value eof(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isReader()) {
+                throw TypeError("reader.eof() requires a reader");
+            }
+
+            return Value::makeBool(args[0].asReader()->atEnd());
+        }
+
+        Value close(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isReader()) {
+                throw TypeError("reader.close() requires a reader");
+            }
+
+            args[0].asReader()->discard();
+            return Value::makeNil();
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../../Common.h"
+#include "../../runtime/Value.h"
+
+namespace Builtins {
+	namespace Reader {
+		Value nextLine(const Vec<Value>& args);
+		Value eof(const Vec<Value>& args);
+		Value close(const Vec<Value>& args);
+	}
+}
@@ -15,7 +15,7 @@ namespace Builtins {
                 throw TypeError("string.length() requires string argument");
             }
 
-            return Value::makeInt(static_cast<int>(args[0].asString().length()));
+            return Value::makeInt(static_cast<int64_t>(args[0].asStringView().length()));
         }
 
         Value substring(const Vec<Value>& args) {
@@ -31,15 +31,15 @@ namespace Builtins {
                 throw TypeError("string.substring() requires integer indices");
             }
 
-            ::String str = args[0].asString();
-            int start = args[1].asInt();
-            int end = args[2].asInt();
+            std::string_view str = args[0].asStringView();
+            int64_t start = args[1].asInt();
+            int64_t end = args[2].asInt();
 
             if (start < 0) start = 0;
-            if (end > static_cast<int>(str.length())) end = static_cast<int>(str.length());
+            if (end > static_cast<int64_t>(str.length())) end = static_cast<int64_t>(str.length());
             if (start >= end) return Value::makeString("");
 
-            return Value::makeString(str.substr(start, end - start));
+            return Value::makeString(::String(str.substr(start, end - start)));
         }
 
         Value toupper(const Vec<Value>& args) {
@@ -51,7 +51,7 @@ namespace Builtins {
                 throw TypeError("string.toupper() requires string argument");
             }
 
-            ::String str = args[0].asString();
+            ::String str(args[0].asStringView());
             std::transform(str.begin(), str.end(), str.begin(),
                 [](unsigned char c) { return std::toupper(c); });
 
@@ -67,7 +67,7 @@ namespace Builtins {
                 throw TypeError("string.tolower() requires string argument");
             }
 
-            ::String str = args[0].asString();
+            ::String str(args[0].asStringView());
             std::transform(str.begin(), str.end(), str.begin(),
                 [](unsigned char c) { return std::tolower(c); });
 
@@ -83,10 +83,10 @@ namespace Builtins {
                 throw TypeError("string.contains() requires string arguments");
             }
 
-            ::String str = args[0].asString();
-            ::String substr = args[1].asString();
+            std::string_view str = args[0].asStringView();
+            std::string_view substr = args[1].asStringView();
 
-            return Value::makeBool(str.find(substr) != ::String::npos);
+            return Value::makeBool(str.find(substr) != std::string_view::npos);
         }
 
         Value replace(const Vec<Value>& args) {
@@ -98,9 +98,9 @@ namespace Builtins {
                 throw TypeError("string.replace() requires string arguments");
             }
 
-            ::String str = args[0].asString();
-            ::String oldStr = args[1].asString();
-            ::String newStr = args[2].asString();
+            ::String str(args[0].asStringView());
+            std::string_view oldStr = args[1].asStringView();
+            std::string_view newStr = args[2].asStringView();
 
             size_t pos = 0;
             while ((pos = str.find(oldStr, pos)) != ::String::npos) {
@@ -120,13 +120,13 @@ namespace Builtins {
                 throw TypeError("string.split() requires string arguments");
             }
 
-            ::String str = args[0].asString();
-            ::String delim = args[1].asString();
+            std::string_view str = args[0].asStringView();
+            std::string_view delim = args[1].asStringView();
 
             // Since we don't have arrays yet, return count of splits as int
             int count = 0;
             size_t pos = 0;
-            while ((pos = str.find(delim, pos)) != ::String::npos) {
+            while ((pos = str.find(delim, pos)) != std::string_view::npos) {
                 count++;
                 pos += delim.length();
             }
@@ -143,16 +143,16 @@ namespace Builtins {
                 throw TypeError("string.trim() requires string argument");
             }
 
-            ::String str = args[0].asString();
+            std::string_view str = args[0].asStringView();
            
             size_t start = str.find_first_not_of(" \t\n\r");
-            if (start == ::String::npos) {
+            if (start == std::string_view::npos) {
                 return Value::makeString("");
             }
 
             size_t end = str.find_last_not_of(" \t\n\r");
 
-            return Value::makeString(str.substr(start, end - start + 1));
+            return Value::makeString(::String(str.substr(start, end - start + 1)));
         }
 
     }
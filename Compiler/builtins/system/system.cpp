@@ -1,5 +1,9 @@
 #include "system.h"
 #include "../../utils/Error.h"
+#include "../../utils/AllocationCounter.h"
+#include "../../runtime/Heap.h"
+#include "../../runtime/Isolate.h"
+#include "../../runtime/LineReader.h"
 #include <iostream>
 #include <cstdlib>
 
@@ -12,7 +16,7 @@ namespace Builtins {
                 if (!args[0].isInt()) {
                     throw TypeError("system.exit() requires integer argument");
                 }
-                code = args[0].asInt();
+                code = static_cast<int>(args[0].asInt());
             }
 
             std::exit(code);
@@ -20,14 +24,51 @@ namespace Builtins {
         }
 
         Value pause(const Vec<Value>& args) {
+            // Waits on the same stdin buffer as console.readLine(), so
+            // input it has already taken in is not skipped; reading
+            // flushes the prompt.
             std::cout << "Press Enter to continue...";
-            std::cout.flush();
-            std::cin.get();
+            std::string_view line;
+            LineReader::standardInput()->nextLine(line);
             return Value::makeNil();
         }
 
         Value version(const Vec<Value>& args) {
             return Value::makeString(Constants::VERSION);
         }
+
+        Value allocations(const Vec<Value>& /*args*/) {
+            return Value::makeInt(static_cast<int64_t>(AllocationCounter::count()));
+        }
+
+        Value gc(const Vec<Value>& /*args*/) {
+            Heap::current().collect();
+            return Value::makeNil();
+        }
+
+        Value sleepAsync(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isInt()) {
+                throw TypeError("system.sleepAsync() requires integer milliseconds");
+            }
+
+            return Value::makeTask(Isolate::current().getEventLoop().sleep(args[0].asInt()));
+        }
+
+        Value argc(const Vec<Value>& /*args*/) {
+            return Value::makeInt(static_cast<int64_t>(Isolate::current().getArguments().size()));
+        }
+
+        Value arg(const Vec<Value>& args) {
+            if (args.size() != 1 || !args[0].isInt()) {
+                throw TypeError("system.arg() requires integer index");
+            }
+
+            const Vec<::String>& arguments = Isolate::current().getArguments();
+            int64_t index = args[0].asInt();
+            if (index < 0 || index >= static_cast<int64_t>(arguments.size())) {
+                throw RuntimeError("system.arg() index " + std::to_string(index) + " out of range");
+            }
+            return Value::makeString(arguments[static_cast<size_t>(index)]);
+        }
     } 
 } 
\ No newline at end of file
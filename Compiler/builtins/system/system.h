@@ -8,5 +8,10 @@ namespace Builtins {
 		Value exit(const Vec<Value>& args);
 		Value pause(const Vec<Value>& args);
 		Value version(const Vec<Value>& agrs);
+		Value allocations(const Vec<Value>& args);
+		Value gc(const Vec<Value>& args);
+		Value sleepAsync(const Vec<Value>& args);
+		Value argc(const Vec<Value>& args);
+		Value arg(const Vec<Value>& args);
 	} 
 } 
\ No newline at end of file
@@ -14,11 +14,15 @@ void Lexer::initKeywords() {
     keywords["bool"] = TokenType::BOOL;
     keywords["struct"] = TokenType::STRUCT;
     keywords["float"] = TokenType::FLOAT;
+    keywords["task"] = TokenType::TASK;
     keywords["func"] = TokenType::FUNC;
     keywords["return"] = TokenType::RETURN;
     keywords["if"] = TokenType::IF;
     keywords["elseif"] = TokenType::ELSEIF; 
     keywords["for"] = TokenType::FOR;
+    keywords["parallel"] = TokenType::PARALLEL;
+    keywords["spawn"] = TokenType::SPAWN;
+    keywords["await"] = TokenType::AWAIT;
     keywords["else"] = TokenType::ELSE;
     keywords["true"] = TokenType::TRUE;
     keywords["false"] = TokenType::FALSE;
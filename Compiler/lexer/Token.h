@@ -17,6 +17,7 @@ enum class TokenType {
     STRING_TYPE,
     BOOL,
     STRUCT,
+    TASK,
     FUNC,
     RETURN,
 
@@ -24,6 +25,9 @@ enum class TokenType {
     ELSEIF,     
     ELSE,
     FOR,
+    PARALLEL,
+    SPAWN,
+    AWAIT,
 
     PLUS,
     MINUS,
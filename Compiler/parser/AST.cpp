@@ -18,6 +18,8 @@ namespace ASTUtil {
         case ASTNodeType::LITERAL: return "LITERAL";
         case ASTNodeType::IDENTIFIER: return "IDENTIFIER";
         case ASTNodeType::MEMBER_ACCESS: return "MEMBER_ACCESS";
+        case ASTNodeType::SPAWN_EXPR: return "SPAWN_EXPR";
+        case ASTNodeType::AWAIT_EXPR: return "AWAIT_EXPR";
         default: return "UNKNOWN";
         }
     }
@@ -1,5 +1,6 @@
 #pragma once
 #include "../Common.h"
+#include <cstdint>
 
 class ASTVisitor;
 
@@ -19,25 +20,107 @@ enum class ASTNodeType {
     CALL_EXPR,
     LITERAL,
     IDENTIFIER,
-    MEMBER_ACCESS
+    MEMBER_ACCESS,
+    SPAWN_EXPR,
+    AWAIT_EXPR
 };
 
+// Types proven by the TypeChecker. UNKNOWN means the value has to be
+// inspected at runtime; NEVER marks expressions that cannot complete.
+enum class StaticType {
+    UNKNOWN,
+    NEVER,
+    INT,
+    FLOAT,
+    STRING,
+    BOOL,
+    NIL,
+    STRUCT,
+    TASK,
+    CHANNEL,
+    ARRAY,
+    READER,
+    WRITER,
+    BYTES,
+    CSV_READER,
+    NDJSON_READER,
+    DIR_WALKER
+};
+
+enum class BinaryOp {
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    EQUAL,
+    NOT_EQUAL,
+    AND,
+    OR,
+    COUNT
+};
+
+inline BinaryOp toBinaryOp(const String& op) {
+    if (op == "+") return BinaryOp::ADD;
+    if (op == "-") return BinaryOp::SUB;
+    if (op == "*") return BinaryOp::MUL;
+    if (op == "/") return BinaryOp::DIV;
+    if (op == "%") return BinaryOp::MOD;
+    if (op == "<") return BinaryOp::LESS;
+    if (op == "<=") return BinaryOp::LESS_EQUAL;
+    if (op == ">") return BinaryOp::GREATER;
+    if (op == ">=") return BinaryOp::GREATER_EQUAL;
+    if (op == "==") return BinaryOp::EQUAL;
+    if (op == "!=") return BinaryOp::NOT_EQUAL;
+    if (op == "&&") return BinaryOp::AND;
+    if (op == "||") return BinaryOp::OR;
+    return BinaryOp::COUNT;
+}
+
 class ASTNode {
 public:
     ASTNodeType nodeType;
     int line;
-    ASTNode(ASTNodeType type, int ln = 0) : nodeType(type), line(ln) {}
+    StaticType staticType;
+    ASTNode(ASTNodeType type, int ln = 0) : nodeType(type), line(ln), staticType(StaticType::UNKNOWN) {}
     virtual ~ASTNode() = default;
 };
 
+enum class ReductionKind {
+    SUM,
+    MIN,
+    MAX,
+    COUNT
+};
+
+// `sum[total]` in a parallel for header: each worker accumulates into a
+// private copy of `total` that starts at the identity of the reduction,
+// and the copies are folded into the outer variable when the loop ends.
+struct Reduction {
+    ReductionKind kind;
+    String variable;
+    StaticType staticType = StaticType::UNKNOWN;
+};
+
 class ForNode : public ASTNode {
 public:
     String iterator;   
     Ptr<ASTNode> start;    
     Ptr<ASTNode> end;              
+    // Set instead of start/end when the loop reads lines from a reader.
+    Ptr<ASTNode> source;
     Vec<Ptr<ASTNode>> body;        
+    bool parallel;
+    bool autoParallel;
+    // The body only calls pure functions, so running it again is harmless.
+    bool pureBody;
+    Vec<Reduction> reductions;
 
-    ForNode() : ASTNode(ASTNodeType::FOR_STMT) {}
+    ForNode() : ASTNode(ASTNodeType::FOR_STMT), parallel(false), autoParallel(false), pureBody(false) {}
 };
 
 class ProgramNode : public ASTNode {
@@ -51,7 +134,8 @@ public:
     String type;
     Vec<String> names;
     Vec<Ptr<ASTNode>> values;
-    VarDefinitionNode() : ASTNode(ASTNodeType::VAR_DEFINITION) {}
+    StaticType guardType;
+    VarDefinitionNode() : ASTNode(ASTNodeType::VAR_DEFINITION), guardType(StaticType::UNKNOWN) {}
 };
 
 struct StructField {
@@ -69,6 +153,7 @@ public:
 struct Parameter {
     String type;
     String name;
+    StaticType staticType = StaticType::UNKNOWN;
 };
 
 class FuncDefinitionNode : public ASTNode {
@@ -76,14 +161,17 @@ public:
     String name;
     Vec<Parameter> parameters;
     Vec<Ptr<ASTNode>> body;
-    FuncDefinitionNode() : ASTNode(ASTNodeType::FUNC_DEFINITION) {}
+    bool pure;
+    bool parallelSafe;
+    FuncDefinitionNode() : ASTNode(ASTNodeType::FUNC_DEFINITION), pure(false), parallelSafe(false) {}
 };
 
 class AssignmentNode : public ASTNode {
 public:
     String identifier;
     Ptr<ASTNode> value;
-    AssignmentNode() : ASTNode(ASTNodeType::ASSIGNMENT) {}
+    StaticType guardType;
+    AssignmentNode() : ASTNode(ASTNodeType::ASSIGNMENT), guardType(StaticType::UNKNOWN) {}
 };
 
 class ReturnNode : public ASTNode {
@@ -110,9 +198,10 @@ public:
 class BinaryExprNode : public ASTNode {
 public:
     String op;
+    BinaryOp opCode;
     Ptr<ASTNode> left;
     Ptr<ASTNode> right;
-    BinaryExprNode() : ASTNode(ASTNodeType::BINARY_EXPR) {}
+    BinaryExprNode() : ASTNode(ASTNodeType::BINARY_EXPR), opCode(BinaryOp::COUNT) {}
 };
 
 class UnaryExprNode : public ASTNode {
@@ -134,7 +223,23 @@ class CallExprNode : public ASTNode {
 public:
     String callee;
     Vec<Ptr<ASTNode>> arguments;
-    CallExprNode() : ASTNode(ASTNodeType::CALL_EXPR) {}
+    FuncDefinitionNode* target;
+    bool checkArguments;
+    CallExprNode() : ASTNode(ASTNodeType::CALL_EXPR), target(nullptr), checkArguments(true) {}
+};
+
+// `spawn f(args)`: evaluates the arguments now and runs the call later as a
+// task, yielding a handle for `await`.
+class SpawnExprNode : public ASTNode {
+public:
+    Ptr<CallExprNode> call;
+    SpawnExprNode() : ASTNode(ASTNodeType::SPAWN_EXPR) {}
+};
+
+class AwaitExprNode : public ASTNode {
+public:
+    Ptr<ASTNode> task;
+    AwaitExprNode() : ASTNode(ASTNodeType::AWAIT_EXPR) {}
 };
 
 class MemberAccessNode : public ASTNode {
@@ -149,7 +254,9 @@ public:
     enum class LiteralType { INTEGER, STRING, BOOLEAN, FLOAT };
     LiteralType litType;
     String value;
-    LiteralNode() : ASTNode(ASTNodeType::LITERAL) {}
+    int64_t intValue;
+    double floatValue;
+    LiteralNode() : ASTNode(ASTNodeType::LITERAL), litType(LiteralType::INTEGER), intValue(0), floatValue(0.0) {}
 };
 
 class IdentifierNode : public ASTNode {
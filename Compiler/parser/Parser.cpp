@@ -78,7 +78,8 @@ Ptr<ASTNode> Parser::parseDefinition() {
     else if (match(TokenType::FUNC)) {
         return parseFuncDefinition();
     }
-    else if (match(TokenType::INT, TokenType::STRING_TYPE) || match(TokenType::BOOL) || match(TokenType::FLOAT)) {
+    else if (match(TokenType::INT, TokenType::STRING_TYPE) || match(TokenType::BOOL, TokenType::FLOAT) ||
+        match(TokenType::TASK, TokenType::IDENTIFIER)) {
         current--;
         return parseVarDefinition();
     }
@@ -171,6 +172,13 @@ Ptr<ASTNode> Parser::parseStatement() {
         return parseForStatement();
     }
 
+    // `parallel.sum(...)` is a call on the parallel module, not a loop.
+    if (check(TokenType::PARALLEL) && tokens[current + 1].type != TokenType::DOT) {
+        advance();
+        consume(TokenType::FOR, "Expected 'for' after 'parallel'");
+        return parseForStatement(true);
+    }
+
     if (match(TokenType::RETURN)) {
         return parseReturn();
     }
@@ -187,23 +195,38 @@ Ptr<ASTNode> Parser::parseStatement() {
     return expr;
 }
 
-Ptr<ForNode> Parser::parseForStatement() {
+Ptr<ForNode> Parser::parseForStatement(bool parallel) {
     auto node = MAKE_PTR(ForNode);
     node->line = previous().line;
+    node->parallel = parallel;
 
     Token iteratorToken = consume(TokenType::IDENTIFIER, "Expected iterator variable name after 'for'");
     node->iterator = iteratorToken.lexeme;
 
     consume(TokenType::COLON, "Expected ':' after iterator variable");
 
-    consume(TokenType::LEFT_BRACKET, "Expected '[' before range");
-    node->start = parseExpression();
-    consume(TokenType::COMMA, "Expected ',' between range values");
-    node->end = parseExpression();
-    consume(TokenType::RIGHT_BRACKET, "Expected ']' after range");
+    if (check(TokenType::LEFT_BRACKET)) {
+        advance();
+        node->start = parseExpression();
+        consume(TokenType::COMMA, "Expected ',' between range values");
+        node->end = parseExpression();
+        consume(TokenType::RIGHT_BRACKET, "Expected ']' after range");
+    }
+    else {
+        // `for line: file.lines(path), { ... }` runs once per line.
+        if (parallel) {
+            throw ParserError("parallel for needs a range", peek().line, peek().column);
+        }
+        node->source = parseExpression();
+    }
 
     consume(TokenType::COMMA, "Expected ',' after range");
 
+    while (parallel && check(TokenType::IDENTIFIER)) {
+        node->reductions.push_back(parseReduction());
+        consume(TokenType::COMMA, "Expected ',' after reduction");
+    }
+
     consume(TokenType::LEFT_BRACE, "Expected '{' to start loop body");
     while (!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
         node->body.push_back(parseStatement());
@@ -213,6 +236,26 @@ Ptr<ForNode> Parser::parseForStatement() {
     return node;
 }
 
+Reduction Parser::parseReduction() {
+    Token kind = consume(TokenType::IDENTIFIER, "Expected reduction");
+
+    Reduction reduction;
+    if (kind.lexeme == "sum") reduction.kind = ReductionKind::SUM;
+    else if (kind.lexeme == "min") reduction.kind = ReductionKind::MIN;
+    else if (kind.lexeme == "max") reduction.kind = ReductionKind::MAX;
+    else if (kind.lexeme == "count") reduction.kind = ReductionKind::COUNT;
+    else {
+        throw ParserError("Unknown reduction '" + kind.lexeme + "', expected sum, min, max or count",
+            kind.line, kind.column);
+    }
+
+    consume(TokenType::LEFT_BRACKET, "Expected '[' after reduction");
+    reduction.variable = consume(TokenType::IDENTIFIER, "Expected reduction variable").lexeme;
+    consume(TokenType::RIGHT_BRACKET, "Expected ']' after reduction variable");
+
+    return reduction;
+}
+
 Ptr<AssignmentNode> Parser::parseAssignment() {
     auto node = MAKE_PTR(AssignmentNode);
     node->line = peek().line;
@@ -267,6 +310,8 @@ Ptr<ASTNode> Parser::parseLogicalOr() {
     while (match(TokenType::OR)) {
         auto node = MAKE_PTR(BinaryExprNode);
         node->op = "||";
+        node->opCode = toBinaryOp(node->op);
+        node->line = previous().line;
         node->left = expr;
         node->right = parseLogicalAnd();
         expr = node;
@@ -281,6 +326,8 @@ Ptr<ASTNode> Parser::parseLogicalAnd() {
     while (match(TokenType::AND)) {
         auto node = MAKE_PTR(BinaryExprNode);
         node->op = "&&";
+        node->opCode = toBinaryOp(node->op);
+        node->line = previous().line;
         node->left = expr;
         node->right = parseEquality();
         expr = node;
@@ -295,6 +342,8 @@ Ptr<ASTNode> Parser::parseEquality() {
     while (match(TokenType::EQUAL_EQUAL, TokenType::NOT_EQUAL)) {
         auto node = MAKE_PTR(BinaryExprNode);
         node->op = previous().lexeme;
+        node->opCode = toBinaryOp(node->op);
+        node->line = previous().line;
         node->left = expr;
         node->right = parseComparison();
         expr = node;
@@ -310,6 +359,8 @@ Ptr<ASTNode> Parser::parseComparison() {
         match(TokenType::LESS_EQUAL, TokenType::GREATER_EQUAL)) {
         auto node = MAKE_PTR(BinaryExprNode);
         node->op = previous().lexeme;
+        node->opCode = toBinaryOp(node->op);
+        node->line = previous().line;
         node->left = expr;
         node->right = parseTerm();
         expr = node;
@@ -324,6 +375,8 @@ Ptr<ASTNode> Parser::parseTerm() {
     while (match(TokenType::PLUS, TokenType::MINUS)) {
         auto node = MAKE_PTR(BinaryExprNode);
         node->op = previous().lexeme;
+        node->opCode = toBinaryOp(node->op);
+        node->line = previous().line;
         node->left = expr;
         node->right = parseFactor();
         expr = node;
@@ -338,6 +391,8 @@ Ptr<ASTNode> Parser::parseFactor() {
     while (match(TokenType::STAR, TokenType::SLASH) || match(TokenType::PERCENT)) {
         auto node = MAKE_PTR(BinaryExprNode);
         node->op = previous().lexeme;
+        node->opCode = toBinaryOp(node->op);
+        node->line = previous().line;
         node->left = expr;
         node->right = parseUnary();
         expr = node;
@@ -354,6 +409,27 @@ Ptr<ASTNode> Parser::parseUnary() {
         return node;
     }
 
+    if (match(TokenType::SPAWN)) {
+        Token keyword = previous();
+        auto node = MAKE_PTR(SpawnExprNode);
+        node->line = keyword.line;
+
+        auto call = parsePrimary();
+        if (call->nodeType != ASTNodeType::CALL_EXPR) {
+            throw ParserError("Expected a function call after 'spawn'", keyword.line, keyword.column);
+        }
+        node->call = std::static_pointer_cast<CallExprNode>(call);
+        node->call->line = keyword.line;
+        return node;
+    }
+
+    if (match(TokenType::AWAIT)) {
+        auto node = MAKE_PTR(AwaitExprNode);
+        node->line = previous().line;
+        node->task = parseUnary();
+        return node;
+    }
+
     return parsePrimary();
 }
 
@@ -401,7 +477,8 @@ Ptr<ASTNode> Parser::parsePrimary() {
 
     if (check(TokenType::STRING_TYPE) || check(TokenType::INT) ||
         check(TokenType::BOOL) || check(TokenType::FLOAT) ||
-        check(TokenType::STRUCT) || check(TokenType::FUNC)) {
+        check(TokenType::STRUCT) || check(TokenType::FUNC) ||
+        check(TokenType::PARALLEL)) {
         Token name = advance();
 
         if (match(TokenType::DOT)) {
@@ -424,6 +501,7 @@ Ptr<ASTNode> Parser::parsePrimary() {
             if (match(TokenType::LEFT_PAREN)) {
                 auto callNode = MAKE_PTR(CallExprNode);
                 callNode->callee = fullName;
+                callNode->line = name.line;
 
                 if (!check(TokenType::RIGHT_PAREN)) {
                     do {
@@ -438,6 +516,7 @@ Ptr<ASTNode> Parser::parsePrimary() {
             auto memberNode = MAKE_PTR(MemberAccessNode);
             memberNode->object = name.lexeme;
             memberNode->member = member.lexeme;
+            memberNode->line = name.line;
             return memberNode;
         }
 
@@ -468,6 +547,7 @@ Ptr<ASTNode> Parser::parsePrimary() {
             if (match(TokenType::LEFT_PAREN)) {
                 auto callNode = MAKE_PTR(CallExprNode);
                 callNode->callee = fullName;
+                callNode->line = name.line;
 
                 if (!check(TokenType::RIGHT_PAREN)) {
                     do {
@@ -482,12 +562,14 @@ Ptr<ASTNode> Parser::parsePrimary() {
             auto memberNode = MAKE_PTR(MemberAccessNode);
             memberNode->object = name.lexeme;
             memberNode->member = member.lexeme;
+            memberNode->line = name.line;
             return memberNode;
         }
 
         if (match(TokenType::LEFT_PAREN)) {
             auto callNode = MAKE_PTR(CallExprNode);
             callNode->callee = name.lexeme;
+            callNode->line = name.line;
 
             if (!check(TokenType::RIGHT_PAREN)) {
                 do {
@@ -499,7 +581,9 @@ Ptr<ASTNode> Parser::parsePrimary() {
             return callNode;
         }
 
-        return MAKE_PTR(IdentifierNode, name.lexeme);
+        auto identifier = MAKE_PTR(IdentifierNode, name.lexeme);
+        identifier->line = name.line;
+        return identifier;
     }
 
     Token tok = peek();
@@ -512,6 +596,7 @@ String Parser::parseType() {
     if (match(TokenType::FLOAT)) return "float";
     if (match(TokenType::STRING_TYPE)) return "string";
     if (match(TokenType::BOOL)) return "bool";
+    if (match(TokenType::TASK)) return "task";
     if (match(TokenType::IDENTIFIER)) return previous().lexeme; 
 
     Token tok = peek();
@@ -28,7 +28,8 @@ private:
     Ptr<StructDefinitionNode> parseStructDefinition();
     Ptr<FuncDefinitionNode> parseFuncDefinition();
 
-    Ptr<ForNode> parseForStatement();
+    Ptr<ForNode> parseForStatement(bool parallel = false);
+    Reduction parseReduction();
     Ptr<ASTNode> parseStatement();
     Ptr<AssignmentNode> parseAssignment();
     Ptr<ReturnNode> parseReturn();
@@ -0,0 +1,133 @@
+#include "BinaryFile.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Closes the descriptor however the read or write ends.
+    class Descriptor {
+    public:
+        Descriptor(const String& path, int flags) {
+#ifdef _WIN32
+            fd = _open(path.c_str(), flags | _O_BINARY | _O_NOINHERIT, _S_IREAD | _S_IWRITE);
+#else
+            fd = ::open(path.c_str(), flags | O_CLOEXEC, 0666);
+#endif
+        }
+
+        ~Descriptor() {
+            if (fd >= 0) {
+#ifdef _WIN32
+                _close(fd);
+#else
+                ::close(fd);
+#endif
+            }
+        }
+
+        Descriptor(const Descriptor&) = delete;
+        Descriptor& operator=(const Descriptor&) = delete;
+
+        int fd;
+    };
+
+    // Single calls are capped so the count fits every platform's types.
+    constexpr size_t MAX_CHUNK = size_t(1) << 30;
+}
+
+namespace BinaryFile {
+    uint64_t size(const String& path) {
+#ifdef _WIN32
+        struct _stat64 info;
+        if (_stat64(path.c_str(), &info) != 0) {
+#else
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0) {
+#endif
+            throw RuntimeError("Failed to open file: " + path);
+        }
+        return static_cast<uint64_t>(info.st_size);
+    }
+
+    size_t readAt(const String& path, uint8_t* data, size_t length, uint64_t offset) {
+#ifdef _WIN32
+        Descriptor file(path, _O_RDONLY);
+#else
+        Descriptor file(path, O_RDONLY);
+#endif
+        if (file.fd < 0) {
+            throw RuntimeError("Failed to open file: " + path);
+        }
+
+#ifdef _WIN32
+        if (_lseeki64(file.fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+            throw RuntimeError("Failed to read file: " + path);
+        }
+#endif
+
+        size_t total = 0;
+        while (total < length) {
+            size_t chunk = std::min(length - total, MAX_CHUNK);
+#ifdef _WIN32
+            int count = _read(file.fd, data + total, static_cast<unsigned int>(chunk));
+#else
+            ssize_t count = ::pread(file.fd, data + total, chunk, static_cast<off_t>(offset + total));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            if (count < 0) {
+                throw RuntimeError("Failed to read file: " + path);
+            }
+            if (count == 0) {
+                break;
+            }
+            total += static_cast<size_t>(count);
+        }
+        return total;
+    }
+
+    void writeAt(const String& path, const uint8_t* data, size_t length, uint64_t offset, bool truncate) {
+#ifdef _WIN32
+        Descriptor file(path, _O_WRONLY | _O_CREAT | (truncate ? _O_TRUNC : 0));
+#else
+        Descriptor file(path, O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0));
+#endif
+        if (file.fd < 0) {
+            throw RuntimeError("Failed to open file for writing: " + path);
+        }
+
+#ifdef _WIN32
+        if (_lseeki64(file.fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+            throw RuntimeError("Failed to write file: " + path);
+        }
+#endif
+
+        size_t total = 0;
+        while (total < length) {
+            size_t chunk = std::min(length - total, MAX_CHUNK);
+#ifdef _WIN32
+            int count = _write(file.fd, data + total, static_cast<unsigned int>(chunk));
+#else
+            ssize_t count = ::pwrite(file.fd, data + total, chunk, static_cast<off_t>(offset + total));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            if (count <= 0) {
+                throw RuntimeError("Failed to write file: " + path);
+            }
+            total += static_cast<size_t>(count);
+        }
+    }
+}
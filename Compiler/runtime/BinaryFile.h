@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../Common.h"
+#include <cstdint>
+
+// Positioned reads and writes of raw bytes for file.readBytes() and
+// file.writeBytes(). They use pread/pwrite, so the data moves between the
+// file and a byte buffer with no intermediate copy and no shared file
+// position.
+namespace BinaryFile {
+    uint64_t size(const String& path);
+
+    // Reads up to length bytes at offset; fewer only at the end of the file.
+    size_t readAt(const String& path, uint8_t* data, size_t length, uint64_t offset);
+
+    // Writes all length bytes at offset, creating the file if needed. With
+    // truncate set the file is emptied first.
+    void writeAt(const String& path, const uint8_t* data, size_t length, uint64_t offset, bool truncate);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../Common.h"
+#include "../utils/Error.h"
+#include <atomic>
+#include <chrono>
+
+// Execution limits for one script run and what it has used so far. A step
+// is a loop iteration or a function call. Interpreters charge steps in
+// batches from their safe points, and worker interpreters of a parallel
+// loop charge their parent's budget, so the counter is atomic. Once a
+// limit is passed every later charge throws again, which stops the tasks
+// and workers of the run as well. The heap limit is enforced by the Heap.
+class Budget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Zero means unlimited.
+    struct Limits {
+        uint64_t maxSteps = 0;
+        int64_t maxMilliseconds = 0;
+    };
+
+    explicit Budget(const Limits& budgetLimits)
+        : limits(budgetLimits), started(Clock::now()), steps(0) {
+        if (limits.maxMilliseconds > 0) {
+            deadline = started + std::chrono::milliseconds(limits.maxMilliseconds);
+        }
+    }
+
+    Budget(const Budget&) = delete;
+    Budget& operator=(const Budget&) = delete;
+
+    void add(uint64_t count) { steps.fetch_add(count, std::memory_order_relaxed); }
+
+    void charge(uint64_t count) {
+        uint64_t total = steps.fetch_add(count, std::memory_order_relaxed) + count;
+
+        if (limits.maxSteps > 0 && total > limits.maxSteps) {
+            throw BudgetExceededError("steps", "Step budget exceeded: limit is " +
+                std::to_string(limits.maxSteps) + " steps");
+        }
+        if (limits.maxMilliseconds > 0 && Clock::now() >= deadline) {
+            throw BudgetExceededError("time", "Time budget exceeded: limit is " +
+                std::to_string(limits.maxMilliseconds) + " ms");
+        }
+    }
+
+    const Limits& getLimits() const { return limits; }
+    uint64_t getSteps() const { return steps.load(std::memory_order_relaxed); }
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    }
+
+private:
+    Limits limits;
+    Clock::time_point started;
+    Clock::time_point deadline;
+    std::atomic<uint64_t> steps;
+};
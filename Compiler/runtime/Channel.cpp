@@ -0,0 +1,347 @@
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Heap.h"
+#include "Isolate.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+Message Message::detach(const Value& value, size_t depth) {
+    if (depth > MAX_DEPTH) {
+        throw RuntimeError("Value is nested too deeply to send, or contains itself");
+    }
+
+    Message message;
+    message.type = value.type;
+
+    switch (value.type) {
+    case ValueType::INTEGER:
+        message.intValue = value.asInt();
+        break;
+    case ValueType::FLOAT:
+        message.floatValue = value.asFloat();
+        break;
+    case ValueType::BOOLEAN:
+        message.boolValue = value.asBool();
+        break;
+    case ValueType::STRING:
+        message.text.assign(value.asStringView());
+        break;
+    case ValueType::FUNCTION:
+        message.text = value.asFunctionName();
+        break;
+    case ValueType::STRUCT_INSTANCE: {
+        StructObject* instance = value.asStruct();
+        message.text = instance->typeName;
+        message.fields.reserve(instance->fields.size());
+        for (auto& field : instance->fields) {
+            message.fields.push_back({ field.first, detach(field.second, depth + 1) });
+        }
+        break;
+    }
+    case ValueType::ARRAY:
+        message.elements.reserve(value.asArray()->elements.size());
+        for (auto& element : value.asArray()->elements) {
+            message.elements.push_back(detach(element, depth + 1));
+        }
+        break;
+    case ValueType::CHANNEL:
+        message.channel = value.asChannel();
+        break;
+    case ValueType::BYTES:
+        message.text.assign(reinterpret_cast<const char*>(value.asBytes()->data), value.asBytes()->length);
+        break;
+    case ValueType::TASK:
+        throw RuntimeError("Cannot send a task over a channel");
+    case ValueType::READER:
+        throw RuntimeError("Cannot send a reader over a channel");
+    case ValueType::WRITER:
+        throw RuntimeError("Cannot send a writer over a channel");
+    case ValueType::CSV_READER:
+        throw RuntimeError("Cannot send a csv reader over a channel");
+    case ValueType::NDJSON_READER:
+        throw RuntimeError("Cannot send an ndjson reader over a channel");
+    case ValueType::DIR_WALKER:
+        throw RuntimeError("Cannot send a walker over a channel");
+    default:
+        break;
+    }
+
+    return message;
+}
+
+Value Message::attach() const {
+    switch (type) {
+    case ValueType::INTEGER:
+        return Value::makeInt(intValue);
+    case ValueType::FLOAT:
+        return Value::makeFloat(floatValue);
+    case ValueType::BOOLEAN:
+        return Value::makeBool(boolValue);
+    case ValueType::STRING:
+        return Value::makeString(text);
+    case ValueType::FUNCTION:
+        return Value::makeFunction(text);
+    case ValueType::STRUCT_INSTANCE: {
+        Value instance = Value::makeStruct(text);
+        for (auto& field : fields) {
+            instance.asStruct()->fields[field.name] = field.value.attach();
+        }
+        return instance;
+    }
+    case ValueType::ARRAY: {
+        Value array = Value::makeArray(elements.size());
+        for (size_t i = 0; i < elements.size(); ++i) {
+            array.asArray()->elements[i] = elements[i].attach();
+        }
+        return array;
+    }
+    case ValueType::CHANNEL:
+        return Value::makeChannel(channel);
+    case ValueType::BYTES: {
+        Value bytes = Value::makeBytes(text.size(), false);
+        std::memcpy(bytes.asBytes()->data, text.data(), text.size());
+        return bytes;
+    }
+    default:
+        return Value::makeNil();
+    }
+}
+
+Channel::Channel(size_t size)
+    : capacity(size), sendPosition(0), recvPosition(0), closed(false),
+      waitingSenders(0), waitingReceivers(0) {
+    if (capacity > 0) {
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+}
+
+// A cell is free for the sender at position p when its sequence is p, and
+// holds a message for the receiver at p when its sequence is p + 1. Taking
+// a message hands the cell on to the sender one lap later.
+bool Channel::trySend(Message& message) {
+    if (capacity == 0) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(std::move(message));
+        }
+    }
+    else {
+        size_t position = sendPosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position % capacity];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t distance = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (distance == 0) {
+                if (sendPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.message = std::move(message);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    break;
+                }
+            }
+            else if (distance < 0) {
+                return false;
+            }
+            else {
+                position = sendPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Pairs with the fence in park(): either this sees the receiver that is
+    // about to sleep, or that receiver's retry sees the message.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waitingReceivers.load(std::memory_order_relaxed) > 0) {
+        wakeOne(receivers, waitingReceivers);
+    }
+    return true;
+}
+
+bool Channel::tryRecv(Message& message) {
+    if (capacity == 0) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queue.empty()) {
+            return false;
+        }
+        message = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+    size_t position = recvPosition.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[position % capacity];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t distance = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+        if (distance == 0) {
+            if (recvPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                message = std::move(cell.message);
+                cell.sequence.store(position + capacity, std::memory_order_release);
+                break;
+            }
+        }
+        else if (distance < 0) {
+            return false;
+        }
+        else {
+            position = recvPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waitingSenders.load(std::memory_order_relaxed) > 0) {
+        wakeOne(senders, waitingSenders);
+    }
+    return true;
+}
+
+void Channel::send(Message message) {
+    bool sent = false;
+    block(senders, waitingSenders, [&] {
+        if (isClosed()) {
+            return true;
+        }
+        sent = trySend(message);
+        return sent;
+    });
+
+    if (!sent) {
+        throw RuntimeError("Cannot send on a closed channel");
+    }
+}
+
+bool Channel::recv(Message& message) {
+    bool received = false;
+    block(receivers, waitingReceivers, [&] {
+        received = tryRecv(message);
+        if (!received && isClosed()) {
+            // Messages sent before the close are still delivered.
+            received = tryRecv(message);
+            return true;
+        }
+        return received;
+    });
+    return received;
+}
+
+void Channel::close() {
+    if (closed.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeAll(senders, waitingSenders);
+    wakeAll(receivers, waitingReceivers);
+}
+
+// Runs attempt until it reports that the operation is over, parking the
+// caller on waiters between tries.
+template<typename Attempt>
+bool Channel::block(Vec<Waiter>& waiters, std::atomic<size_t>& waiting, Attempt attempt) {
+    if (attempt()) {
+        return true;
+    }
+
+    EventLoop& loop = Isolate::current().getEventLoop();
+
+    while (true) {
+        TaskObject* wakeup = park(waiters, waiting);
+
+        // The peer that would have woken us may have finished between the
+        // first attempt and the registration.
+        bool done = false;
+        try {
+            done = attempt();
+            if (!done) {
+                loop.await(wakeup);
+            }
+        }
+        catch (...) {
+            if (!withdraw(waiters, waiting, wakeup)) {
+                wakeOne(waiters, waiting);
+            }
+            throw;
+        }
+
+        if (done) {
+            // A wake-up meant for us that we no longer need goes to the next
+            // waiter, otherwise it could sleep next to a ready message.
+            if (!withdraw(waiters, waiting, wakeup)) {
+                wakeOne(waiters, waiting);
+            }
+            return true;
+        }
+
+        if (attempt()) {
+            return true;
+        }
+    }
+}
+
+TaskObject* Channel::park(Vec<Waiter>& waiters, std::atomic<size_t>& waiting) {
+    EventLoop& loop = Isolate::current().getEventLoop();
+    TaskObject* wakeup = loop.createWakeup();
+
+    {
+        std::lock_guard<std::mutex> lock(waiterMutex);
+        waiters.push_back({ &loop, wakeup });
+        waiting.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return wakeup;
+}
+
+// False when a peer already took the waiter off the list; its wake-up is
+// then on the way and the loop delivers it to nobody.
+bool Channel::withdraw(Vec<Waiter>& waiters, std::atomic<size_t>& waiting, TaskObject* wakeup) {
+    EventLoop* loop = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(waiterMutex);
+        auto it = std::find_if(waiters.begin(), waiters.end(),
+            [wakeup](const Waiter& waiter) { return waiter.wakeup == wakeup; });
+        if (it == waiters.end()) {
+            return false;
+        }
+        loop = it->loop;
+        waiters.erase(it);
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    loop->withdrawWakeup(wakeup);
+    return true;
+}
+
+void Channel::wakeOne(Vec<Waiter>& waiters, std::atomic<size_t>& waiting) {
+    Waiter waiter;
+    {
+        std::lock_guard<std::mutex> lock(waiterMutex);
+        if (waiters.empty()) {
+            return;
+        }
+        waiter = waiters.front();
+        waiters.erase(waiters.begin());
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    waiter.loop->wakeup(waiter.wakeup);
+}
+
+void Channel::wakeAll(Vec<Waiter>& waiters, std::atomic<size_t>& waiting) {
+    Vec<Waiter> woken;
+    {
+        std::lock_guard<std::mutex> lock(waiterMutex);
+        woken.swap(waiters);
+        waiting.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& waiter : woken) {
+        waiter.loop->wakeup(waiter.wakeup);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../Common.h"
+#include "Value.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+class Channel;
+class EventLoop;
+class TaskObject;
+
+// A Value detached from any heap. Sending deep-copies the value into a
+// message and receiving rebuilds it on the receiver's heap, so isolates
+// never share objects. Channels themselves are shared by reference.
+struct Message {
+    struct Field;
+
+    ValueType type = ValueType::NIL;
+    union {
+        int64_t intValue;
+        double floatValue;
+        bool boolValue;
+    };
+    String text;
+    Vec<Field> fields;
+    Vec<Message> elements;
+    Ptr<Channel> channel;
+
+    // Arrays and structs may nest this deep; deeper, or a value that
+    // contains itself, cannot be sent.
+    static constexpr size_t MAX_DEPTH = 1024;
+
+    Message() : intValue(0) {}
+
+    static Message detach(const Value& value, size_t depth = 0);
+    Value attach() const;
+};
+
+struct Message::Field {
+    String name;
+    Message value;
+};
+
+// Multi-producer, multi-consumer channel shared between isolates. Bounded
+// channels are a fixed ring of sequenced cells (Vyukov's MPMC queue), so
+// senders and receivers on different threads only contend on an atomic
+// index; unbounded channels fall back to a locked deque. Nil is never
+// sent, which leaves it free to mean "closed" or "empty" to receivers.
+//
+// Blocking operations park the caller on the channel as a wake-up task of
+// its own event loop, so a task waiting in recv() lets the other tasks of
+// its isolate run, and a thread with no tasks simply sleeps.
+class Channel {
+public:
+    // capacity 0 makes an unbounded channel.
+    explicit Channel(size_t capacity);
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    bool trySend(Message& message);
+    bool tryRecv(Message& message);
+
+    void send(Message message);
+    bool recv(Message& message);
+
+    void close();
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    size_t getCapacity() const { return capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Message message;
+    };
+
+    struct Waiter {
+        EventLoop* loop;
+        TaskObject* wakeup;
+    };
+
+    size_t capacity;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> sendPosition;
+    alignas(64) std::atomic<size_t> recvPosition;
+
+    std::mutex queueMutex;
+    std::deque<Message> queue;
+
+    std::atomic<bool> closed;
+
+    std::mutex waiterMutex;
+    Vec<Waiter> senders;
+    Vec<Waiter> receivers;
+    std::atomic<size_t> waitingSenders;
+    std::atomic<size_t> waitingReceivers;
+
+    TaskObject* park(Vec<Waiter>& waiters, std::atomic<size_t>& waiting);
+    bool withdraw(Vec<Waiter>& waiters, std::atomic<size_t>& waiting, TaskObject* wakeup);
+    void wakeOne(Vec<Waiter>& waiters, std::atomic<size_t>& waiting);
+    void wakeAll(Vec<Waiter>& waiters, std::atomic<size_t>& waiting);
+
+    template<typename Attempt>
+    bool block(Vec<Waiter>& waiters, std::atomic<size_t>& waiting, Attempt attempt);
+};
@@ -0,0 +1,135 @@
+#include "ConsoleOutput.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+void ConsoleOutput::install(Mode mode) {
+    std::ios::sync_with_stdio(false);
+
+    // Never destroyed: std::cout is flushed during static destruction, and
+    // the writer thread may still be draining then.
+    static ConsoleOutput* output = new ConsoleOutput(mode);
+    std::cout.rdbuf(output);
+}
+
+ConsoleOutput::ConsoleOutput(Mode outputMode)
+    : mode(outputMode), terminal(Terminal::UNKNOWN), writing(false), writer(nullptr) {
+    pending.reserve(BUFFER_SIZE);
+}
+
+ConsoleOutput::int_type ConsoleOutput::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        char c = traits_type::to_char_type(ch);
+        std::lock_guard<std::mutex> lock(mutex);
+        append(&c, 1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize ConsoleOutput::xsputn(const char* data, std::streamsize count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    append(data, static_cast<size_t>(count));
+    return count;
+}
+
+int ConsoleOutput::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flushPending(true);
+    return 0;
+}
+
+void ConsoleOutput::append(const char* data, size_t count) {
+    if (terminal == Terminal::UNKNOWN) {
+#ifdef _WIN32
+        terminal = _isatty(1) ? Terminal::YES : Terminal::NO;
+#else
+        terminal = isatty(STDOUT_FILENO) ? Terminal::YES : Terminal::NO;
+#endif
+    }
+
+    if (pending.size() + count > BUFFER_SIZE) {
+        flushPending(false);
+    }
+
+    // Large writes skip the buffer, unless the writer thread is still
+    // busy with earlier output that must go first.
+    if (count >= BUFFER_SIZE && mode == Mode::BUFFERED) {
+        writeAll(data, count);
+    }
+    else {
+        pending.append(data, count);
+    }
+
+    if (terminal == Terminal::YES && std::memchr(data, '\n', count)) {
+        flushPending(true);
+    }
+}
+
+// Writes out or hands over everything buffered. With wait set, returns
+// only once it has all reached stdout.
+void ConsoleOutput::flushPending(bool wait) {
+    if (mode == Mode::BUFFERED) {
+        writeAll(pending.data(), pending.size());
+        pending.clear();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(writerMutex);
+    if (!pending.empty()) {
+        writerDone.wait(lock, [this] { return !writing && handedOver.empty(); });
+        // The swap keeps both buffers' capacity, so the two alternate.
+        handedOver.swap(pending);
+        if (!writer) {
+            writer = new std::thread(&ConsoleOutput::writerLoop, this);
+            writer->detach();
+        }
+        writerWake.notify_one();
+    }
+    if (wait) {
+        writerDone.wait(lock, [this] { return !writing && handedOver.empty(); });
+    }
+}
+
+void ConsoleOutput::writerLoop() {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (true) {
+        writerWake.wait(lock, [this] { return !handedOver.empty(); });
+        writing = true;
+        lock.unlock();
+
+        writeAll(handedOver.data(), handedOver.size());
+
+        lock.lock();
+        handedOver.clear();
+        writing = false;
+        writerDone.notify_all();
+    }
+}
+
+// Output that cannot be written (a closed pipe, a full disk) is dropped,
+// as std::cout would after its first failure.
+void ConsoleOutput::writeAll(const char* data, size_t count) {
+    while (count > 0) {
+#ifdef _WIN32
+        int chunk = static_cast<int>(std::min<size_t>(count, 1 << 30));
+        int written = _write(1, data, static_cast<unsigned int>(chunk));
+#else
+        ssize_t written = ::write(STDOUT_FILENO, data, count);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        count -= static_cast<size_t>(written);
+    }
+}
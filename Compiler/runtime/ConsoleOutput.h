@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../Common.h"
+#include <condition_variable>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+// The stream buffer behind std::cout. Output collects in a user-space
+// buffer and goes to the process's stdout in large writes: when the buffer
+// fills, on flush (console.flush(), std::flush, before anything is written
+// to stderr or read from stdin, since both are tied to std::cout) and at
+// exit. When stdout is a terminal every completed line is written at once,
+// as C stdio does, so interactive output is not held back.
+//
+// In ASYNC mode a full buffer is handed to a background writer thread and
+// the script carries on filling a second one; flushes still wait until
+// everything handed over has been written. The writer starts with the
+// first handover, so a zygote server that never prints does not start a
+// thread before it forks.
+//
+// Writes are serialized by a mutex, since parallel for workers and task
+// threads may print at the same time.
+class ConsoleOutput : public std::streambuf {
+public:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    enum class Mode { BUFFERED, ASYNC };
+
+    // Points std::cout at a ConsoleOutput for the rest of the process.
+    // Call once from main, before any output.
+    static void install(Mode mode);
+
+    ConsoleOutput(const ConsoleOutput&) = delete;
+    ConsoleOutput& operator=(const ConsoleOutput&) = delete;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    explicit ConsoleOutput(Mode mode);
+
+    // Whether stdout is a terminal is only known once something is written,
+    // since a zygote child gets its stdout after the buffer is installed.
+    enum class Terminal { UNKNOWN, YES, NO };
+
+    Mode mode;
+    Terminal terminal;
+    String pending;
+    std::mutex mutex;
+
+    // ASYNC mode: the buffer the writer is working on, if any.
+    String handedOver;
+    bool writing;
+    std::mutex writerMutex;
+    std::condition_variable writerWake;
+    std::condition_variable writerDone;
+    std::thread* writer;
+
+    void append(const char* data, size_t count);
+    void flushPending(bool wait);
+    void writerLoop();
+
+    static void writeAll(const char* data, size_t count);
+};
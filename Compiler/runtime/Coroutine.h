@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../Common.h"
+#include "Environment.h"
+#include "Fiber.h"
+#include "Heap.h"
+#include <deque>
+
+// Interpreter state that belongs to one thread of control rather than to
+// the interpreter as a whole. The Interpreter swaps it with a task's copy
+// when it switches into or out of that task, so call frames, argument
+// buffers and temporary roots of suspended tasks never interleave.
+struct ExecutionState {
+    Environment* currentEnv = nullptr;
+    int recursionDepth = 0;
+    std::deque<Environment> frames;
+    std::deque<Vec<Value>> argumentBuffers;
+    size_t argumentDepth = 0;
+    bool returning = false;
+    Value returnValue;
+    Vec<Value> tempRoots;
+
+    void markValues(Heap& heap) const {
+        for (int i = 0; i < recursionDepth; ++i) {
+            frames[i].markValues(heap);
+        }
+        for (size_t i = 0; i < argumentDepth; ++i) {
+            for (auto& arg : argumentBuffers[i]) {
+                heap.mark(arg);
+            }
+        }
+        for (auto& root : tempRoots) {
+            heap.mark(root);
+        }
+        heap.mark(returnValue);
+    }
+};
+
+// A spawned call together with the stack and state it runs on. The fiber is
+// only created when the task first runs, so queued tasks stay small, and
+// finished coroutines are pooled by the Interpreter for the next spawn.
+class Coroutine {
+public:
+    String callee;
+    FuncDefinitionNode* target = nullptr;
+    bool checkArguments = true;
+    Vec<Value> arguments;
+
+    ExecutionState state;
+    std::unique_ptr<Fiber> fiber;
+    bool started = false;
+
+    void markValues(Heap& heap) const {
+        for (auto& arg : arguments) {
+            heap.mark(arg);
+        }
+        state.markValues(heap);
+    }
+};
@@ -0,0 +1,227 @@
+#include "CsvReader.h"
+#include "Heap.h"
+#include "../utils/Error.h"
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CSV_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+#ifdef CSV_USE_SSE2
+    int lowestBit(int mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, static_cast<unsigned long>(mask));
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(static_cast<unsigned int>(mask));
+#endif
+    }
+#endif
+
+    // The first delimiter, "\n" or "\r" in [p, end), or end. The vector
+    // loop never reads past end; the last few bytes are checked one by one.
+    const char* findFieldEnd(const char* p, const char* end, char delimiter) {
+#ifdef CSV_USE_SSE2
+        const __m128i delimiters = _mm_set1_epi8(delimiter);
+        const __m128i newlines = _mm_set1_epi8('\n');
+        const __m128i returns = _mm_set1_epi8('\r');
+
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, delimiters),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, newlines), _mm_cmpeq_epi8(chunk, returns)));
+            int mask = _mm_movemask_epi8(hits);
+            if (mask != 0) {
+                return p + lowestBit(mask);
+            }
+            p += 16;
+        }
+#endif
+        while (p < end && *p != delimiter && *p != '\n' && *p != '\r') {
+            ++p;
+        }
+        return p;
+    }
+
+    bool parseInt(std::string_view text, Value& out) {
+        int64_t number;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+            return false;
+        }
+        out = Value::makeInt(number);
+        return true;
+    }
+
+    bool parseFloat(std::string_view text, Value& out) {
+        double number;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+            return false;
+        }
+        out = Value::makeFloat(number);
+        return true;
+    }
+}
+
+Ptr<CsvReader> CsvReader::open(const String& path, char delimiter, Vec<ColumnType> columns) {
+    return Ptr<CsvReader>(new CsvReader(MappedFile::open(path), delimiter, std::move(columns)));
+}
+
+CsvReader::CsvReader(Ptr<MappedFile> mapped, char separator, Vec<ColumnType> columnTypes)
+    : file(std::move(mapped)), delimiter(separator), columns(std::move(columnTypes)), position(0), row(0) {}
+
+// Strings already handed out keep the mapping alive on their own.
+void CsvReader::close() {
+    file.reset();
+    fields.clear();
+    scratch.clear();
+    scratch.shrink_to_fit();
+}
+
+Value CsvReader::nextRow() {
+    if (!file || !parseRow()) {
+        close();
+        return Value::makeNil();
+    }
+
+    Value array = Value::makeArray(fields.size());
+    Vec<Value>& elements = array.asArray()->elements;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        elements[i] = fieldValue(fields[i], i);
+    }
+    return array;
+}
+
+bool CsvReader::atEnd() {
+    if (!file) {
+        return true;
+    }
+
+    const char* data = file->data();
+    size_t length = file->size();
+    while (position < length && (data[position] == '\n' || data[position] == '\r')) {
+        position++;
+    }
+    return position >= length;
+}
+
+// Splits the row starting at position into fields and moves position past
+// its line ending. Blank lines are skipped. False once the file is
+// exhausted.
+bool CsvReader::parseRow() {
+    const char* data = file->data();
+    size_t length = file->size();
+    while (position < length && (data[position] == '\n' || data[position] == '\r')) {
+        position++;
+    }
+    if (position >= length) {
+        return false;
+    }
+
+    fields.clear();
+    scratch.clear();
+    row++;
+
+    while (true) {
+        size_t end;
+        if (data[position] == '"') {
+            end = parseQuoted(position);
+        }
+        else {
+            end = static_cast<size_t>(findFieldEnd(data + position, data + length, delimiter) - data);
+            fields.push_back({ position, end - position, false });
+        }
+
+        if (end < length && data[end] == delimiter) {
+            position = end + 1;
+            // A delimiter at the very end still starts one last, empty field.
+            if (position == length) {
+                fields.push_back({ position, 0, false });
+                return true;
+            }
+            continue;
+        }
+
+        position = end < length ? end + 1 : end;
+        return true;
+    }
+}
+
+// Adds the quoted field starting at start and returns the offset just past
+// its closing quote. Fields without "" escapes stay in the mapping.
+size_t CsvReader::parseQuoted(size_t start) {
+    const char* data = file->data();
+    size_t length = file->size();
+    size_t begin = start + 1;
+    size_t copiedFrom = begin;
+    bool escaped = false;
+
+    while (true) {
+        const void* found = begin < length ? std::memchr(data + begin, '"', length - begin) : nullptr;
+        if (!found) {
+            throw RuntimeError("Unterminated quoted field in CSV row " + std::to_string(row));
+        }
+
+        size_t quote = static_cast<size_t>(static_cast<const char*>(found) - data);
+        if (quote + 1 < length && data[quote + 1] == '"') {
+            if (!escaped) {
+                escaped = true;
+                copiedFrom = scratch.size();
+                scratch.append(data + start + 1, quote + 1 - (start + 1));
+            }
+            else {
+                scratch.append(data + begin, quote + 1 - begin);
+            }
+            begin = quote + 2;
+            continue;
+        }
+
+        if (escaped) {
+            scratch.append(data + begin, quote - begin);
+            fields.push_back({ copiedFrom, scratch.size() - copiedFrom, true });
+        }
+        else {
+            fields.push_back({ start + 1, quote - (start + 1), false });
+        }
+
+        size_t after = quote + 1;
+        if (after < length && data[after] != delimiter && data[after] != '\n' && data[after] != '\r') {
+            throw RuntimeError("Unexpected character after quoted field in CSV row " + std::to_string(row));
+        }
+        return after;
+    }
+}
+
+Value CsvReader::fieldValue(const Field& field, size_t column) const {
+    std::string_view text = field.unescaped
+        ? std::string_view(scratch.data() + field.offset, field.length)
+        : std::string_view(file->data() + field.offset, field.length);
+
+    ColumnType type = column < columns.size() ? columns[column] : ColumnType::STRING;
+    if (type != ColumnType::STRING) {
+        if (text.empty()) {
+            return Value::makeNil();
+        }
+        Value number;
+        if (type == ColumnType::INT ? parseInt(text, number) : parseFloat(text, number)) {
+            return number;
+        }
+        if (row > 1) {
+            throw RuntimeError("CSV row " + std::to_string(row) + ", column " + std::to_string(column + 1) +
+                ": \"" + String(text) + "\" is not " + (type == ColumnType::INT ? "an int" : "a float"));
+        }
+    }
+
+    if (!field.unescaped && text.size() >= MIN_SLICE_LENGTH) {
+        return Value::makeMappedString(file, text);
+    }
+    return Value::makeString(String(text));
+}
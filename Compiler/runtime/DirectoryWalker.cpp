@@ -0,0 +1,166 @@
+#include "DirectoryWalker.h"
+#include "Heap.h"
+#include "../utils/Error.h"
+#include <algorithm>
+
+Ptr<DirectoryWalker> DirectoryWalker::open(const String& root, const String& pattern) {
+    FileSystem::Status status;
+    if (!FileSystem::stat(root, status) || status.type != FileSystem::EntryType::DIRECTORY) {
+        throw RuntimeError("Not a directory: " + root);
+    }
+    return Ptr<DirectoryWalker>(new DirectoryWalker(root, pattern));
+}
+
+DirectoryWalker::DirectoryWalker(const String& root, const String& pattern)
+    : pattern(pattern), reading(0), running(0), stopping(false) {
+    pending.push_back(Pending{nullptr, String(), root});
+
+    size_t count = std::min(std::max<size_t>(std::thread::hardware_concurrency(), 4), MAX_THREADS);
+    running = count;
+    for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([this] { work(); });
+    }
+}
+
+DirectoryWalker::~DirectoryWalker() {
+    close();
+}
+
+void DirectoryWalker::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        batches.clear();
+    }
+    workReady.notify_all();
+    spaceReady.notify_all();
+    batchReady.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+bool DirectoryWalker::nextBatch(Vec<String>& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    batchReady.wait(lock, [this] { return !batches.empty() || running == 0 || stopping; });
+    if (batches.empty()) {
+        return false;
+    }
+
+    batch = std::move(batches.front());
+    batches.pop_front();
+    spaceReady.notify_one();
+    return true;
+}
+
+Value DirectoryWalker::nextBatch() {
+    Vec<String> batch;
+    if (!nextBatch(batch)) {
+        return Value::makeNil();
+    }
+
+    Value array = Value::makeArray(batch.size());
+    Vec<Value>& elements = array.asArray()->elements;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        elements[i] = Value::makeString(std::move(batch[i]));
+    }
+    return array;
+}
+
+bool DirectoryWalker::done() {
+    std::unique_lock<std::mutex> lock(mutex);
+    batchReady.wait(lock, [this] { return !batches.empty() || running == 0 || stopping; });
+    return batches.empty();
+}
+
+void DirectoryWalker::work() {
+    Vec<String> batch;
+    Vec<Pending> found;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // With nothing pending and nothing being read, no more directories
+        // can turn up: the walk is over.
+        workReady.wait(lock, [this] { return stopping || !pending.empty() || reading == 0; });
+        if (stopping || pending.empty()) {
+            break;
+        }
+
+        Pending directory = std::move(pending.back());
+        pending.pop_back();
+        reading++;
+        lock.unlock();
+
+        readDirectory(directory, batch, found);
+
+        lock.lock();
+        reading--;
+        for (auto& child : found) {
+            pending.push_back(std::move(child));
+        }
+        if (found.size() > 1 || (reading == 0 && pending.empty())) {
+            workReady.notify_all();
+        }
+        else if (!found.empty()) {
+            workReady.notify_one();
+        }
+        found.clear();
+
+        // Small directories share a batch, but a thread about to go idle
+        // hands over what it has rather than sit on it.
+        if (!batch.empty() && pending.empty()) {
+            publish(lock, batch);
+        }
+    }
+
+    if (!batch.empty()) {
+        publish(lock, batch);
+    }
+    if (--running == 0) {
+        batchReady.notify_all();
+    }
+}
+
+void DirectoryWalker::readDirectory(const Pending& directory, Vec<String>& batch, Vec<Pending>& found) {
+    Ptr<FileSystem::Directory> opened = directory.parent
+        ? directory.parent->openChild(directory.name, directory.path)
+        : FileSystem::Directory::open(directory.path);
+    if (!opened) {
+        return;
+    }
+
+    bool separated = !directory.path.empty() && directory.path.back() == '/';
+    opened->read([&](std::string_view name, FileSystem::EntryType type) {
+        String path;
+        path.reserve(directory.path.size() + 1 + name.size());
+        path += directory.path;
+        if (!separated) {
+            path += '/';
+        }
+        path += name;
+
+        if (type == FileSystem::EntryType::DIRECTORY) {
+            found.push_back(Pending{opened, String(name), path});
+        }
+
+        if (pattern.empty() || FileSystem::matchGlob(pattern, name)) {
+            batch.push_back(std::move(path));
+            if (batch.size() >= BATCH_SIZE) {
+                std::unique_lock<std::mutex> lock(mutex);
+                publish(lock, batch);
+            }
+        }
+    });
+}
+
+void DirectoryWalker::publish(std::unique_lock<std::mutex>& lock, Vec<String>& batch) {
+    spaceReady.wait(lock, [this] { return stopping || batches.size() < MAX_QUEUED_BATCHES; });
+    if (!stopping) {
+        batches.push_back(std::move(batch));
+        batchReady.notify_one();
+    }
+    batch.clear();
+    batch.reserve(BATCH_SIZE);
+}
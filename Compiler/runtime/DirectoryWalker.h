@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../Common.h"
+#include "FileSystem.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Walks a directory tree on several threads for fs.walk() and fs.walker().
+// Each thread takes a directory from a shared stack, reads it and pushes
+// the subdirectories it finds, so a deep or bushy tree keeps every thread
+// busy; subdirectories are opened relative to their parent's descriptor.
+// Paths whose names match the pattern are handed to the reader in batches,
+// which keeps the locking per path small. Symlinks are reported but not
+// followed, and directories that cannot be read are skipped.
+//
+// Batches come in no particular order. At most MAX_QUEUED_BATCHES wait to
+// be read; past that the threads block, so a slow reader holds the walk
+// back instead of buffering the whole tree.
+class DirectoryWalker {
+public:
+    static constexpr size_t BATCH_SIZE = 1024;
+    static constexpr size_t MAX_QUEUED_BATCHES = 64;
+    // Reading directories waits on the file system more than the CPU, so
+    // this is not limited to the core count, but more threads than this
+    // just contend for the same disk.
+    static constexpr size_t MAX_THREADS = 16;
+
+    // An empty pattern matches every name. Throws if root is not a
+    // directory.
+    static Ptr<DirectoryWalker> open(const String& root, const String& pattern);
+
+    ~DirectoryWalker();
+
+    DirectoryWalker(const DirectoryWalker&) = delete;
+    DirectoryWalker& operator=(const DirectoryWalker&) = delete;
+
+    // Blocks for the next batch of paths; false once the walk is over or
+    // the walker closed.
+    bool nextBatch(Vec<String>& batch);
+
+    // The next batch as an array of strings, or nil.
+    Value nextBatch();
+
+    // Blocks until a batch is ready or the walk is over; true if it is
+    // over and every batch has been read.
+    bool done();
+
+    // Stops the threads; batches not yet read are dropped.
+    void close();
+
+private:
+    DirectoryWalker(const String& root, const String& pattern);
+
+    // A directory still to read: the root, or a child of an open directory.
+    struct Pending {
+        Ptr<FileSystem::Directory> parent;
+        String name;
+        String path;
+    };
+
+    String pattern;
+
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable batchReady;
+    std::condition_variable spaceReady;
+    Vec<Pending> pending;
+    std::deque<Vec<String>> batches;
+    size_t reading;
+    size_t running;
+    bool stopping;
+    Vec<std::thread> threads;
+
+    void work();
+    void readDirectory(const Pending& directory, Vec<String>& batch, Vec<Pending>& found);
+    // Called with the lock held; waits while the queue is full.
+    void publish(std::unique_lock<std::mutex>& lock, Vec<String>& batch);
+};
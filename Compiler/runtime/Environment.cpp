@@ -1,49 +1,89 @@
 #include "Environment.h"
+#include "Heap.h"
 
-Environment::Environment(Ptr<Environment> enc) : enclosing(enc) {}
+Environment::Environment(Environment* par) : count(0), parent(par) {}
 
 void Environment::define(const String& name, const Value& value) {
-    variables[name] = value;
-    variableCache[name] = &variables[name];
+    Binding* binding = find(name);
+    if (binding) {
+        binding->value = value;
+        return;
+    }
+
+    if (count < bindings.size()) {
+        bindings[count].name = name;
+        bindings[count].value = value;
+    }
+    else {
+        bindings.push_back({ name, value });
+    }
+    count++;
 }
 
-Value Environment::get(const String& name) const {
-    auto it = values.find(name);
-    if (it != values.end()) {
-        return it->second;
+const Value& Environment::get(const String& name) const {
+    const Binding* binding = find(name);
+    if (binding) {
+        return binding->value;
     }
 
-    if (enclosing) {
-        return enclosing->get(name);
+    if (parent) {
+        return parent->get(name);
     }
 
-    throw NameError("Undefined variable '" + name + "'");
+    throw NameError("Undefined variable: " + name);
 }
 
-void Environment::set(const String& name, const Value& value) {
-    auto it = variables.find(name);
-    if (it != variables.end()) {
-        it->second = value;
-        auto cacheIt = variableCache.find(name);
-        if (cacheIt != variableCache.end()) {
-            cacheIt->second = &(it->second);
-        }
-        return;
+Value& Environment::lookup(const String& name) {
+    Binding* binding = find(name);
+    if (binding) {
+        return binding->value;
     }
 
     if (parent) {
-        parent->set(name, value);
-        return;
+        return parent->lookup(name);
     }
 
     throw NameError("Undefined variable: " + name);
 }
 
+void Environment::set(const String& name, const Value& value) {
+    lookup(name) = value;
+}
+
 bool Environment::exists(const String& name) const {
-    if (values.find(name) != values.end()) {
+    if (find(name)) {
         return true;
     }
-    return enclosing && enclosing->exists(name);
+    return parent && parent->exists(name);
+}
+
+void Environment::reset(Environment* newParent) {
+    count = 0;
+    parent = newParent;
+}
+
+void Environment::markValues(Heap& heap) const {
+    for (size_t i = 0; i < count; ++i) {
+        heap.mark(bindings[i].value);
+    }
+}
+
+Environment::Binding* Environment::find(const String& name) {
+    for (size_t i = 0; i < count; ++i) {
+        if (bindings[i].name == name) {
+            return &bindings[i];
+        }
+    }
+    return nullptr;
+}
+
+const Environment::Binding* Environment::find(const String& name) const {
+    for (size_t i = 0; i < count; ++i) {
+        if (bindings[i].name == name) {
+            return &bindings[i];
+        }
+    }
+    return nullptr;
 }
 
 void Environment::defineFunction(const String& name, Ptr<FuncDefinitionNode> func) {
@@ -56,8 +96,8 @@ Ptr<FuncDefinitionNode> Environment::getFunction(const String& name) const {
         return it->second;
     }
 
-    if (enclosing) {
-        return enclosing->getFunction(name);
+    if (parent) {
+        return parent->getFunction(name);
     }
 
     return nullptr;
@@ -67,7 +107,7 @@ bool Environment::hasFunction(const String& name) const {
     if (functions.find(name) != functions.end()) {
         return true;
     }
-    return enclosing && enclosing->hasFunction(name);
+    return parent && parent->hasFunction(name);
 }
 
 void Environment::defineStruct(const String& name, Ptr<StructDefinitionNode> structDef) {
@@ -80,8 +120,8 @@ Ptr<StructDefinitionNode> Environment::getStruct(const String& name) const {
         return it->second;
     }
 
-    if (enclosing) {
-        return enclosing->getStruct(name);
+    if (parent) {
+        return parent->getStruct(name);
     }
 
     return nullptr;
@@ -91,5 +131,5 @@ bool Environment::hasStruct(const String& name) const {
     if (structs.find(name) != structs.end()) {
         return true;
     }
-    return enclosing && enclosing->hasStruct(name);
-}
\ No newline at end of file
+    return parent && parent->hasStruct(name);
+}
@@ -1,19 +1,30 @@
 #pragma once
-#pragma once
 
 #include "../Common.h"
 #include "Value.h"
 #include "../parser/AST.h"
 #include "../utils/Error.h"
+#include <deque>
+
+class Heap;
 
+// Variables live in a flat binding list that is searched linearly; scopes
+// are small and a reset() keeps the storage around, so call frames can be
+// pooled and reused without touching the heap. Bindings are held in a deque
+// so references returned by lookup() survive later definitions.
 class Environment {
 public:
-    explicit Environment(Ptr<Environment> enclosing = nullptr);
+    explicit Environment(Environment* parent = nullptr);
 
     void define(const String& name, const Value& value);
-    Value get(const String& name) const;
+    const Value& get(const String& name) const;
+    Value& lookup(const String& name);
     void set(const String& name, const Value& value);
     bool exists(const String& name) const;
+    bool definesLocally(const String& name) const { return find(name) != nullptr; }
+
+    void reset(Environment* newParent);
+    void markValues(Heap& heap) const;
 
     void defineFunction(const String& name, Ptr<FuncDefinitionNode> func);
     Ptr<FuncDefinitionNode> getFunction(const String& name) const;
@@ -23,39 +34,21 @@ public:
     Ptr<StructDefinitionNode> getStruct(const String& name) const;
     bool hasStruct(const String& name) const;
 
-    Ptr<Environment> getEnclosing() const { return enclosing; }
-
-    Value get(const String& name) {
-        auto cacheIt = variableCache.find(name);
-        if (cacheIt != variableCache.end()) {
-            return *(cacheIt->second);
-        }
-
-        auto it = variables.find(name);
-        if (it != variables.end()) {
-            variableCache[name] = &(it->second);
-            return it->second;
-        }
-
-        if (parent) {
-            return parent->get(name);
-        }
-
-        throw NameError("Undefined variable: " + name);
-    }
-
-    void clearCache() {
-        variableCache.clear();
-    }
+    Environment* getParent() const { return parent; }
 
 private:
-    Map<String, Value> variables;
-    Ptr<Environment> parent;
+    struct Binding {
+        String name;
+        Value value;
+    };
 
-    mutable Map<String, Value*> variableCache;
+    std::deque<Binding> bindings;
+    size_t count;
+    Environment* parent;
 
-    Map<String, Value> values;
     Map<String, Ptr<FuncDefinitionNode>> functions;
     Map<String, Ptr<StructDefinitionNode>> structs;
-    Ptr<Environment> enclosing;
-};
\ No newline at end of file
+
+    Binding* find(const String& name);
+    const Binding* find(const String& name) const;
+};
@@ -0,0 +1,273 @@
+#include "EventLoop.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+    // Threads that run blocking calls (file I/O) for every isolate in the
+    // process. Unlike ThreadPool, jobs are independent and nobody joins on
+    // a batch; each job reports back to the loop that submitted it.
+    class BackgroundThreads {
+    public:
+        static BackgroundThreads& instance() {
+            static BackgroundThreads threads;
+            return threads;
+        }
+
+        void post(std::function<void()> job) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+            }
+            wake.notify_one();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::function<void()>> jobs;
+        Vec<std::thread> threads;
+        bool stopping = false;
+
+        BackgroundThreads() {
+            size_t count = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+            for (size_t i = 0; i < count; ++i) {
+                threads.emplace_back([this] { work(); });
+            }
+        }
+
+        ~BackgroundThreads() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        void work() {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                    if (jobs.empty()) {
+                        return;
+                    }
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+            }
+        }
+    };
+}
+
+EventLoop::EventLoop() : outstanding(0), parked(0), running(0) {}
+
+EventLoop::~EventLoop() {
+    // Background jobs post into this loop, so it has to outlive them even if
+    // the program stopped waiting for their results.
+    std::unique_lock<std::mutex> lock(mutex);
+    signal.wait(lock, [this] { return running == 0; });
+}
+
+TaskObject* EventLoop::createTask() {
+    TaskObject* task = Heap::current().allocateTask();
+    live.insert(task);
+    return task;
+}
+
+void EventLoop::schedule(TaskObject* task) {
+    ready.push_back(task);
+}
+
+TaskObject* EventLoop::nextReady() {
+    while (!ready.empty()) {
+        TaskObject* task = ready.front();
+        ready.pop_front();
+
+        // A task can be queued by a wake-up that raced with its cancellation.
+        if (!task->isFinished()) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+TaskObject* EventLoop::submit(BlockingWork work) {
+    TaskObject* task = createTask();
+    outstanding++;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running++;
+    }
+
+    BackgroundThreads::instance().post([this, task, work = std::move(work)] {
+        Finished result{ task, nullptr, nullptr };
+        try {
+            result.completion = work();
+        }
+        catch (...) {
+            result.error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(std::move(result));
+        running--;
+        signal.notify_one();
+    });
+
+    return task;
+}
+
+TaskObject* EventLoop::sleep(int64_t milliseconds) {
+    TaskObject* task = createTask();
+    timers.push({ Clock::now() + std::chrono::milliseconds(std::max<int64_t>(milliseconds, 0)), task });
+    return task;
+}
+
+TaskObject* EventLoop::createWakeup() {
+    TaskObject* task = createTask();
+    outstanding++;
+    parked++;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    running++;
+    return task;
+}
+
+void EventLoop::wakeup(TaskObject* task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished.push_back({ task, nullptr, nullptr });
+    running--;
+    signal.notify_one();
+}
+
+void EventLoop::withdrawWakeup(TaskObject* task) {
+    outstanding--;
+    parked--;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running--;
+    }
+    complete(task, Value::makeNil());
+}
+
+void EventLoop::await(TaskObject* task) {
+    if (awaitHook) {
+        awaitHook(task);
+        return;
+    }
+
+    while (!task->isFinished()) {
+        poll();
+        if (task->isFinished()) {
+            break;
+        }
+        if (!hasPendingWork()) {
+            throw RuntimeError("Deadlock: the awaited task can never finish");
+        }
+        wait();
+    }
+}
+
+void EventLoop::complete(TaskObject* task, const Value& result) {
+    task->state = TaskObject::State::DONE;
+    task->result = result;
+
+    for (auto* waiter : task->waiters) {
+        schedule(waiter);
+    }
+    task->waiters.clear();
+    live.erase(task);
+}
+
+void EventLoop::fail(TaskObject* task, std::exception_ptr error) {
+    task->state = TaskObject::State::FAILED;
+    task->error = error;
+
+    for (auto* waiter : task->waiters) {
+        schedule(waiter);
+    }
+    task->waiters.clear();
+    live.erase(task);
+}
+
+void EventLoop::poll() {
+    if (outstanding > 0) {
+        Vec<Finished> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.swap(finished);
+        }
+        drain(batch);
+    }
+
+    fireTimers();
+}
+
+void EventLoop::wait() {
+    Vec<Finished> batch;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto hasFinished = [this] { return !finished.empty(); };
+
+        if (timers.empty()) {
+            signal.wait(lock, hasFinished);
+        }
+        else {
+            signal.wait_until(lock, timers.top().deadline, hasFinished);
+        }
+        batch.swap(finished);
+    }
+
+    drain(batch);
+    fireTimers();
+}
+
+void EventLoop::drain(Vec<Finished>& batch) {
+    for (auto& item : batch) {
+        outstanding--;
+
+        if (!item.completion && !item.error) {
+            parked--;
+            complete(item.task, Value::makeNil());
+            continue;
+        }
+
+        if (item.error) {
+            fail(item.task, item.error);
+            continue;
+        }
+
+        try {
+            complete(item.task, item.completion());
+        }
+        catch (...) {
+            fail(item.task, std::current_exception());
+        }
+    }
+}
+
+void EventLoop::fireTimers() {
+    auto now = Clock::now();
+    while (!timers.empty() && timers.top().deadline <= now) {
+        TaskObject* task = timers.top().task;
+        timers.pop();
+        complete(task, Value::makeNil());
+    }
+}
+
+Vec<TaskObject*> EventLoop::pendingTasks() const {
+    return Vec<TaskObject*>(live.begin(), live.end());
+}
+
+void EventLoop::markRoots(Heap& heap) const {
+    for (auto* task : live) {
+        heap.mark(task);
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../Common.h"
+#include "Heap.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <unordered_set>
+
+// Per-isolate task bookkeeping: the queue of tasks ready to run, timers,
+// and blocking work handed to background threads. Tasks and Values are only
+// touched on the isolate's own thread; background threads run plain C++
+// work and return a completion that the loop later turns into the task's
+// result, so heaps never see another thread.
+//
+// The loop does not run tasks itself. The Interpreter pulls ready tasks
+// from it and resumes their fibers, and blocks in wait() when every task is
+// waiting on I/O or a timer.
+class EventLoop {
+public:
+    using Completion = std::function<Value()>;
+    using BlockingWork = std::function<Completion()>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // New pending task on the current heap. It stays rooted until it
+    // finishes, whether or not the script keeps its handle.
+    TaskObject* createTask();
+
+    void schedule(TaskObject* task);
+    TaskObject* nextReady();
+
+    // Runs work on a background thread; the returned task finishes with the
+    // value its completion produces, or with the exception either throws.
+    TaskObject* submit(BlockingWork work);
+    TaskObject* sleep(int64_t milliseconds);
+
+    // A wake-up is a pending task that any thread may finish with wakeup(),
+    // e.g. a channel sender releasing a parked receiver. The loop outlives
+    // every wake-up that was neither delivered nor withdrawn.
+    TaskObject* createWakeup();
+    void wakeup(TaskObject* task);
+    void withdrawWakeup(TaskObject* task);
+
+    void complete(TaskObject* task, const Value& result);
+    void fail(TaskObject* task, std::exception_ptr error);
+
+    // Blocks the caller until task finishes, through the hook installed by
+    // the owning Interpreter so that other tasks keep running meanwhile.
+    using AwaitHook = std::function<void(TaskObject*)>;
+    void setAwaitHook(AwaitHook hook) { awaitHook = std::move(hook); }
+    void await(TaskObject* task);
+
+    bool hasPendingWork() const { return !timers.empty() || outstanding > 0; }
+
+    // Timers and background jobs only. Parked wake-ups are left out: once
+    // the program is over nobody can deliver them.
+    bool hasBackgroundWork() const { return !timers.empty() || outstanding > parked; }
+
+    void poll();
+    void wait();
+
+    Vec<TaskObject*> pendingTasks() const;
+    void markRoots(Heap& heap) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Timer {
+        Clock::time_point deadline;
+        TaskObject* task;
+
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    struct Finished {
+        TaskObject* task;
+        Completion completion;
+        std::exception_ptr error;
+    };
+
+    std::deque<TaskObject*> ready;
+    std::priority_queue<Timer, Vec<Timer>, std::greater<Timer>> timers;
+    std::unordered_set<TaskObject*> live;
+    size_t outstanding;
+    size_t parked;
+    AwaitHook awaitHook;
+
+    // Shared with background threads.
+    std::mutex mutex;
+    std::condition_variable signal;
+    Vec<Finished> finished;
+    size_t running;
+
+    void drain(Vec<Finished>& batch);
+    void fireTimers();
+};
@@ -0,0 +1,167 @@
+#include "Fiber.h"
+#include "../utils/Error.h"
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define FIBER_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define FIBER_ASAN 1
+#endif
+#endif
+
+#ifdef FIBER_ASAN
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+namespace {
+    thread_local Fiber* currentFiber = nullptr;
+
+    // AddressSanitizer has to be told about every stack switch, otherwise
+    // unwinding an exception on a fiber looks like a wild stack access.
+    inline void beginSwitch(void** fakeStack, const void* bottom, size_t size) {
+#ifdef FIBER_ASAN
+        __sanitizer_start_switch_fiber(fakeStack, bottom, size);
+#else
+        (void)fakeStack;
+        (void)bottom;
+        (void)size;
+#endif
+    }
+
+    inline void endSwitch(void* fakeStack, const void** previousBottom, size_t* previousSize) {
+#ifdef FIBER_ASAN
+        __sanitizer_finish_switch_fiber(fakeStack, previousBottom, previousSize);
+#else
+        (void)fakeStack;
+        (void)previousBottom;
+        (void)previousSize;
+#endif
+    }
+}
+
+Fiber* Fiber::current() {
+    return currentFiber;
+}
+
+void Fiber::start(Entry fn, void* data) {
+    entry = fn;
+    arg = data;
+}
+
+void Fiber::loop() {
+    while (true) {
+        entry(arg);
+        suspend();
+    }
+}
+
+#ifdef _WIN32
+
+Fiber::Fiber(size_t size)
+    : entry(nullptr), arg(nullptr), stackSize(size), previous(nullptr), caller(nullptr) {
+    handle = CreateFiberEx(0, stackSize, FIBER_FLAG_FLOAT_SWITCH, &Fiber::trampoline, this);
+    if (!handle) {
+        throw RuntimeError("Failed to allocate a task stack");
+    }
+}
+
+Fiber::~Fiber() {
+    DeleteFiber(handle);
+}
+
+void CALLBACK Fiber::trampoline(LPVOID self) {
+    static_cast<Fiber*>(self)->loop();
+}
+
+void Fiber::resume() {
+    if (!IsThreadAFiber()) {
+        ConvertThreadToFiber(nullptr);
+    }
+
+    caller = GetCurrentFiber();
+    previous = currentFiber;
+    currentFiber = this;
+    SwitchToFiber(handle);
+    currentFiber = previous;
+}
+
+void Fiber::suspend() {
+    SwitchToFiber(caller);
+}
+
+size_t Fiber::stackRemaining() const {
+    ULONG_PTR low;
+    ULONG_PTR high;
+    GetCurrentThreadStackLimits(&low, &high);
+
+    char marker;
+    return static_cast<size_t>(reinterpret_cast<uintptr_t>(&marker) - low);
+}
+
+#else
+
+Fiber::Fiber(size_t size)
+    : entry(nullptr), arg(nullptr), stackSize(size), previous(nullptr), callerBottom(nullptr), callerSize(0) {
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    stackSize = (stackSize + pageSize - 1) / pageSize * pageSize;
+    mappedSize = stackSize + pageSize;
+
+    // The lowest page stays inaccessible so an overflow faults instead of
+    // silently running into a neighbouring mapping.
+    void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw RuntimeError("Failed to allocate a task stack");
+    }
+    stack = static_cast<char*>(memory);
+    mprotect(stack, pageSize, PROT_NONE);
+
+    getcontext(&context);
+    context.uc_stack.ss_sp = stack + pageSize;
+    context.uc_stack.ss_size = stackSize;
+    context.uc_link = nullptr;
+    makecontext(&context, &Fiber::trampoline, 0);
+}
+
+Fiber::~Fiber() {
+    munmap(stack, mappedSize);
+}
+
+void Fiber::trampoline() {
+    Fiber* self = currentFiber;
+    endSwitch(nullptr, &self->callerBottom, &self->callerSize);
+    self->loop();
+}
+
+void Fiber::resume() {
+    previous = currentFiber;
+    currentFiber = this;
+
+    void* fakeStack = nullptr;
+    beginSwitch(&fakeStack, stack + (mappedSize - stackSize), stackSize);
+    swapcontext(&callerContext, &context);
+    endSwitch(fakeStack, nullptr, nullptr);
+
+    currentFiber = previous;
+}
+
+void Fiber::suspend() {
+    void* fakeStack = nullptr;
+    beginSwitch(&fakeStack, callerBottom, callerSize);
+    swapcontext(&context, &callerContext);
+    endSwitch(fakeStack, &callerBottom, &callerSize);
+}
+
+size_t Fiber::stackRemaining() const {
+    char marker;
+    uintptr_t low = reinterpret_cast<uintptr_t>(stack + (mappedSize - stackSize));
+    return static_cast<size_t>(reinterpret_cast<uintptr_t>(&marker) - low);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../Common.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <ucontext.h>
+#endif
+
+// A stackful coroutine: a separate machine stack that the scheduler can
+// switch into with resume() and that switches back with suspend(). Stacks
+// are reserved up front but only committed as they are touched, so a
+// suspended fiber costs the pages it actually used.
+//
+// A fiber is reusable: start() installs a new entry function, which runs
+// from the top of the stack on the next resume(). When the entry function
+// returns the fiber suspends itself and may be started again.
+class Fiber {
+public:
+    using Entry = void(*)(void* arg);
+
+    static constexpr size_t DEFAULT_STACK_SIZE = 1024 * 1024;
+
+    explicit Fiber(size_t stackSize = DEFAULT_STACK_SIZE);
+    ~Fiber();
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    void start(Entry entry, void* arg);
+
+    // Runs the fiber until it suspends. Fibers may nest one level: task
+    // fibers are resumed from the thread's own stack or from the fiber of
+    // a Scheduler job, which is the interpreter's own stack in that case.
+    void resume();
+
+    // Returns control to the resume() that is running this fiber.
+    void suspend();
+
+    // The fiber running on this thread, or null on the thread's own stack.
+    static Fiber* current();
+
+    // Bytes left between the caller's stack pointer and the end of the
+    // current fiber's stack.
+    size_t stackRemaining() const;
+
+private:
+    Entry entry;
+    void* arg;
+    size_t stackSize;
+    Fiber* previous;
+
+#ifdef _WIN32
+    LPVOID handle;
+    LPVOID caller;
+
+    static void CALLBACK trampoline(LPVOID self);
+#else
+    char* stack;
+    size_t mappedSize;
+    ucontext_t context;
+    ucontext_t callerContext;
+    const void* callerBottom;
+    size_t callerSize;
+
+    static void trampoline();
+#endif
+
+    [[noreturn]] void loop();
+};
@@ -0,0 +1,335 @@
+#include "FileSystem.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace FileSystem {
+
+#ifdef _WIN32
+
+    namespace {
+        EntryType entryType(DWORD attributes) {
+            if (attributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+                return EntryType::SYMLINK;
+            }
+            return attributes & FILE_ATTRIBUTE_DIRECTORY ? EntryType::DIRECTORY : EntryType::FILE;
+        }
+
+        // FILETIME counts 100 ns intervals from 1601.
+        double toEpochSeconds(FILETIME time) {
+            uint64_t ticks = (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+            return static_cast<double>(ticks) / 1e7 - 11644473600.0;
+        }
+    }
+
+    Directory::Directory(int fd, const String& path) : fd(fd), location(path) {}
+
+    Directory::~Directory() {}
+
+    Ptr<Directory> Directory::open(const String& path) {
+        DWORD attributes = GetFileAttributesA(path.c_str());
+        if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            return nullptr;
+        }
+        return Ptr<Directory>(new Directory(-1, path));
+    }
+
+    Ptr<Directory> Directory::openChild(std::string_view, const String& childPath) const {
+        DWORD attributes = GetFileAttributesA(childPath.c_str());
+        if (attributes == INVALID_FILE_ATTRIBUTES || entryType(attributes) != EntryType::DIRECTORY) {
+            return nullptr;
+        }
+        return Ptr<Directory>(new Directory(-1, childPath));
+    }
+
+    void Directory::read(const Visitor& visit) {
+        WIN32_FIND_DATAA entry;
+        HANDLE find = FindFirstFileExA((location + "\\*").c_str(), FindExInfoBasic, &entry,
+            FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (find == INVALID_HANDLE_VALUE) {
+            return;
+        }
+
+        do {
+            std::string_view name(entry.cFileName);
+            if (name != "." && name != "..") {
+                visit(name, entryType(entry.dwFileAttributes));
+            }
+        } while (FindNextFileA(find, &entry));
+        FindClose(find);
+    }
+
+    bool stat(const String& path, Status& status) {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+            return false;
+        }
+
+        status.type = data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ? EntryType::DIRECTORY : EntryType::FILE;
+        status.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        status.modified = toEpochSeconds(data.ftLastWriteTime);
+        return true;
+    }
+
+#else
+
+    namespace {
+        EntryType modeType(mode_t mode) {
+            if (S_ISREG(mode)) {
+                return EntryType::FILE;
+            }
+            if (S_ISDIR(mode)) {
+                return EntryType::DIRECTORY;
+            }
+            return S_ISLNK(mode) ? EntryType::SYMLINK : EntryType::OTHER;
+        }
+
+        // Some file systems leave d_type unset; ask for the mode then.
+        EntryType entryType(int fd, const char* name, unsigned char type) {
+            switch (type) {
+                case DT_REG: return EntryType::FILE;
+                case DT_DIR: return EntryType::DIRECTORY;
+                case DT_LNK: return EntryType::SYMLINK;
+                case DT_UNKNOWN: {
+                    struct stat info;
+                    if (fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                        return EntryType::OTHER;
+                    }
+                    return modeType(info.st_mode);
+                }
+                default: return EntryType::OTHER;
+            }
+        }
+
+        bool isDotOrDotDot(const char* name) {
+            return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+        }
+
+        // Directories are opened for reading entries only. O_NOFOLLOW makes
+        // a symlink fail to open rather than lead out of the tree or round
+        // in a cycle.
+        constexpr int DIRECTORY_FLAGS = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+    }
+
+    Directory::Directory(int fd, const String& path) : fd(fd), location(path) {}
+
+    Directory::~Directory() {
+        ::close(fd);
+    }
+
+    Ptr<Directory> Directory::open(const String& path) {
+        // The root itself may be a link to a directory; only links below
+        // it are refused.
+        int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        return Ptr<Directory>(new Directory(fd, path));
+    }
+
+    Ptr<Directory> Directory::openChild(std::string_view name, const String& childPath) const {
+        int child = openat(fd, String(name).c_str(), DIRECTORY_FLAGS);
+        if (child < 0) {
+            return nullptr;
+        }
+        return Ptr<Directory>(new Directory(child, childPath));
+    }
+
+#ifdef __linux__
+
+    void Directory::read(const Visitor& visit) {
+        // The record getdents64() fills; glibc only declares it since 2.30.
+        struct Record {
+            uint64_t inode;
+            int64_t offset;
+            unsigned short length;
+            unsigned char type;
+            char name[1];
+        };
+
+        alignas(8) static thread_local char buffer[64 * 1024];
+        while (true) {
+            long filled = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+            if (filled <= 0) {
+                return;
+            }
+
+            for (long position = 0; position < filled;) {
+                const Record* record = reinterpret_cast<const Record*>(buffer + position);
+                position += record->length;
+                if (!isDotOrDotDot(record->name)) {
+                    visit(std::string_view(record->name), entryType(fd, record->name, record->type));
+                }
+            }
+        }
+    }
+
+#else
+
+    void Directory::read(const Visitor& visit) {
+        // closedir() closes the descriptor it was given, so give it a copy.
+        int copy = dup(fd);
+        DIR* stream = copy >= 0 ? fdopendir(copy) : nullptr;
+        if (!stream) {
+            if (copy >= 0) {
+                ::close(copy);
+            }
+            return;
+        }
+
+        while (struct dirent* entry = readdir(stream)) {
+            if (!isDotOrDotDot(entry->d_name)) {
+                visit(std::string_view(entry->d_name), entryType(fd, entry->d_name, entry->d_type));
+            }
+        }
+        closedir(stream);
+    }
+
+#endif
+
+    bool stat(const String& path, Status& status) {
+#if defined(__linux__) && defined(STATX_SIZE)
+        // Only the fields used are asked for, which spares network file
+        // systems from fetching the rest.
+        struct statx info;
+        if (statx(AT_FDCWD, path.c_str(), 0, STATX_TYPE | STATX_SIZE | STATX_MTIME, &info) != 0) {
+            return false;
+        }
+        status.type = modeType(info.stx_mode);
+        status.size = info.stx_size;
+        status.modified = static_cast<double>(info.stx_mtime.tv_sec) + info.stx_mtime.tv_nsec / 1e9;
+#else
+        struct ::stat info;
+        if (::stat(path.c_str(), &info) != 0) {
+            return false;
+        }
+        status.type = modeType(info.st_mode);
+        status.size = static_cast<uint64_t>(info.st_size);
+#if defined(__APPLE__)
+        status.modified = static_cast<double>(info.st_mtimespec.tv_sec) + info.st_mtimespec.tv_nsec / 1e9;
+#else
+        status.modified = static_cast<double>(info.st_mtim.tv_sec) + info.st_mtim.tv_nsec / 1e9;
+#endif
+#endif
+        return true;
+    }
+
+#endif
+
+    namespace {
+        // Matches name[0] against the class at pattern[0] ('['), setting
+        // length to the class's length; false with length 0 if the class
+        // is never closed, so the '[' is taken literally.
+        bool matchClass(std::string_view pattern, char c, size_t& length) {
+            size_t i = 1;
+            bool negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+            if (negated) {
+                i++;
+            }
+
+            bool matched = false;
+            // A ']' first in the class is a member, not the end.
+            for (bool first = true; i < pattern.size() && (first || pattern[i] != ']'); first = false) {
+                char low = pattern[i];
+                char high = low;
+                if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+                    high = pattern[i + 2];
+                    i += 3;
+                }
+                else {
+                    i++;
+                }
+                if (low <= c && c <= high) {
+                    matched = true;
+                }
+            }
+
+            if (i >= pattern.size()) {
+                length = 0;
+                return false;
+            }
+            length = i + 1;
+            return matched != negated;
+        }
+    }
+
+    bool matchGlob(std::string_view pattern, std::string_view name) {
+        // Backtracking only to the last '*' keeps this linear in practice.
+        size_t p = 0;
+        size_t n = 0;
+        size_t starPattern = std::string_view::npos;
+        size_t starName = 0;
+
+        while (n < name.size()) {
+            if (p < pattern.size()) {
+                char c = pattern[p];
+                if (c == '*') {
+                    starPattern = ++p;
+                    starName = n;
+                    continue;
+                }
+                if (c == '?') {
+                    p++;
+                    n++;
+                    continue;
+                }
+                if (c == '[') {
+                    size_t length;
+                    bool matched = matchClass(pattern.substr(p), name[n], length);
+                    if (length > 0) {
+                        if (matched) {
+                            p += length;
+                            n++;
+                            continue;
+                        }
+                    }
+                    else if (name[n] == '[') {
+                        p++;
+                        n++;
+                        continue;
+                    }
+                }
+                else if (c == name[n]) {
+                    p++;
+                    n++;
+                    continue;
+                }
+            }
+
+            if (starPattern == std::string_view::npos) {
+                return false;
+            }
+            p = starPattern;
+            n = ++starName;
+        }
+
+        while (p < pattern.size() && pattern[p] == '*') {
+            p++;
+        }
+        return p == pattern.size();
+    }
+
+    const char* typeName(EntryType type) {
+        switch (type) {
+            case EntryType::FILE: return "file";
+            case EntryType::DIRECTORY: return "directory";
+            case EntryType::SYMLINK: return "symlink";
+            default: return "other";
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../Common.h"
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+// Directory listing and file metadata for the fs builtins. On Linux a
+// directory is read with getdents64() into a 64 KB buffer, hundreds of
+// entries per system call, and metadata comes from statx(), asking only
+// for the fields used. Other POSIX systems use readdir() and stat();
+// Windows uses FindFirstFileEx() with large fetches.
+namespace FileSystem {
+    enum class EntryType { FILE, DIRECTORY, SYMLINK, OTHER };
+
+    struct Status {
+        EntryType type;
+        uint64_t size;
+        // Seconds since the epoch, with the fraction the file system keeps.
+        double modified;
+    };
+
+    // An open directory. On POSIX it holds a descriptor, so subdirectories
+    // are opened relative to it with openat() and the kernel resolves one
+    // name rather than the whole path again; Windows opens by path.
+    class Directory {
+    public:
+        using Visitor = std::function<void(std::string_view name, EntryType type)>;
+
+        // Null if path cannot be opened as a directory.
+        static Ptr<Directory> open(const String& path);
+
+        ~Directory();
+
+        Directory(const Directory&) = delete;
+        Directory& operator=(const Directory&) = delete;
+
+        // Null if the entry is gone, is not a directory, or is a symlink:
+        // links are never followed.
+        Ptr<Directory> openChild(std::string_view name, const String& childPath) const;
+
+        // Calls visit for every entry but "." and "..", in the order the
+        // file system returns them. Only one thread may read a directory,
+        // though any may open children of it, and visit must not read
+        // another directory: the entry buffer is kept per thread.
+        void read(const Visitor& visit);
+
+        const String& path() const { return location; }
+
+    private:
+        Directory(int fd, const String& path);
+
+        int fd;
+        String location;
+    };
+
+    // False if nothing exists at path. Symlinks are followed, so a link
+    // reports what it points to.
+    bool stat(const String& path, Status& status);
+
+    // Shell-style match of a whole name: "*" matches any run of characters,
+    // "?" any one, and "[a-z]" or "[!abc]" one from (or not from) a set.
+    bool matchGlob(std::string_view pattern, std::string_view name);
+
+    const char* typeName(EntryType type);
+}
@@ -0,0 +1,217 @@
+#include "FileWriter.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <set>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    struct Registry {
+        std::mutex mutex;
+        std::set<FileWriter*> writers;
+    };
+
+    // Never destroyed, so it outlives the exit handler and any writer
+    // collected during static destruction.
+    Registry& registry() {
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    void flushAtExit() {
+        FileWriter::flushAll();
+    }
+}
+
+Ptr<FileWriter> FileWriter::open(const String& path, bool append, size_t bufferSize, SyncPolicy sync) {
+#ifdef _WIN32
+    int flags = _O_WRONLY | _O_CREAT | _O_BINARY | _O_NOINHERIT | (append ? _O_APPEND : _O_TRUNC);
+    int fd = _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0666);
+#endif
+    if (fd < 0) {
+        throw RuntimeError("Failed to open file for writing: " + path);
+    }
+
+    static bool exitHandler = (std::atexit(flushAtExit), true);
+    (void)exitHandler;
+
+    Ptr<FileWriter> writer(new FileWriter(fd, path, bufferSize, sync));
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    registry().writers.insert(writer.get());
+    return writer;
+}
+
+FileWriter::FileWriter(int file, const String& filePath, size_t bufferSize, SyncPolicy syncPolicy)
+    : fd(file), path(filePath), capacity(bufferSize), sync(syncPolicy) {
+    buffer.reserve(capacity);
+}
+
+// Errors closing a writer nobody holds any more have no one to go to.
+FileWriter::~FileWriter() {
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().writers.erase(this);
+    }
+    try {
+        close();
+    }
+    catch (const std::exception&) {
+    }
+}
+
+void FileWriter::write(std::string_view data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        throw RuntimeError("Cannot write to closed file: " + path);
+    }
+
+    if (buffer.size() + data.size() <= capacity) {
+        buffer.append(data.data(), data.size());
+        return;
+    }
+
+    writeOut(data);
+    if (sync == SyncPolicy::FLUSH) {
+        syncToDisk();
+    }
+}
+
+void FileWriter::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0 || buffer.empty()) {
+        return;
+    }
+
+    writeOut(std::string_view());
+    if (sync == SyncPolicy::FLUSH) {
+        syncToDisk();
+    }
+}
+
+void FileWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closeLocked();
+}
+
+bool FileWriter::isClosed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fd < 0;
+}
+
+void FileWriter::flushAll() {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    for (FileWriter* writer : registry().writers) {
+        try {
+            writer->close();
+        }
+        catch (const std::exception&) {
+        }
+    }
+}
+
+// The file is closed even when the last write fails; the error is still
+// reported.
+void FileWriter::closeLocked() {
+    if (fd < 0) {
+        return;
+    }
+
+    bool failed = false;
+    try {
+        writeOut(std::string_view());
+        if (sync != SyncPolicy::NONE) {
+            syncToDisk();
+        }
+    }
+    catch (const RuntimeError&) {
+        failed = true;
+    }
+
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    fd = -1;
+    buffer.clear();
+    buffer.shrink_to_fit();
+
+    if (failed) {
+        throw RuntimeError("Failed to write file: " + path);
+    }
+}
+
+// Writes the buffered bytes followed by data, then empties the buffer.
+void FileWriter::writeOut(std::string_view data) {
+    std::string_view parts[2] = { buffer, data };
+
+#ifdef _WIN32
+    for (auto& part : parts) {
+        while (!part.empty()) {
+            unsigned int chunk = static_cast<unsigned int>(std::min<size_t>(part.size(), 1u << 30));
+            int written = _write(fd, part.data(), chunk);
+            if (written <= 0) {
+                throw RuntimeError("Failed to write file: " + path);
+            }
+            part.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+#else
+    size_t first = 0;
+    while (first < 2 && parts[first].empty()) {
+        first++;
+    }
+    while (first < 2) {
+        struct iovec vectors[2];
+        int count = 0;
+        for (size_t i = first; i < 2; ++i) {
+            vectors[count].iov_base = const_cast<char*>(parts[i].data());
+            vectors[count].iov_len = parts[i].size();
+            count++;
+        }
+
+        ssize_t written = ::writev(fd, vectors, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw RuntimeError("Failed to write file: " + path);
+        }
+
+        size_t remaining = static_cast<size_t>(written);
+        while (first < 2 && remaining >= parts[first].size()) {
+            remaining -= parts[first].size();
+            first++;
+        }
+        if (first < 2) {
+            parts[first].remove_prefix(remaining);
+        }
+    }
+#endif
+
+    buffer.clear();
+}
+
+void FileWriter::syncToDisk() {
+#ifdef _WIN32
+    int result = _commit(fd);
+#else
+    int result = ::fsync(fd);
+#endif
+    if (result != 0) {
+        throw RuntimeError("Failed to sync file: " + path);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../Common.h"
+#include <mutex>
+#include <string_view>
+
+// An open file that scripts write to through file.openWrite() or
+// file.append() handles. Small writes are copied into a buffer of the
+// chosen size; a write that does not fit goes out together with the
+// buffered bytes in one writev(), without copying it. Append mode opens
+// with O_APPEND, so every write lands at the current end of the file even
+// when other processes append too.
+//
+// Writers still open at exit are flushed, as C stdio does for FILE*, so
+// records are not lost when a script ends with system.exit(). A writer
+// may be shared by parallel workers; its writes are serialized.
+class FileWriter {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    // When to fsync: never, after every flush (explicit or because the
+    // buffer filled), or once when the file is closed.
+    enum class SyncPolicy { NONE, FLUSH, CLOSE };
+
+    static Ptr<FileWriter> open(const String& path, bool append, size_t bufferSize, SyncPolicy sync);
+
+    ~FileWriter();
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    void write(std::string_view data);
+    void flush();
+    void close();
+    bool isClosed();
+
+    static void flushAll();
+
+private:
+    FileWriter(int fd, const String& path, size_t bufferSize, SyncPolicy sync);
+
+    int fd;
+    String path;
+    String buffer;
+    size_t capacity;
+    SyncPolicy sync;
+    std::mutex mutex;
+
+    void writeOut(std::string_view data);
+    void syncToDisk();
+    void closeLocked();
+};
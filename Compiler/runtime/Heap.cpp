@@ -0,0 +1,240 @@
+#include "Heap.h"
+#include "Coroutine.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    thread_local Heap* currentHeap = nullptr;
+}
+
+void StructObject::trace(Heap& heap) {
+    for (auto& field : fields) {
+        heap.mark(field.second);
+    }
+}
+
+size_t StructObject::size() const {
+    size_t total = sizeof(StructObject) + typeName.capacity();
+    for (auto& field : fields) {
+        total += sizeof(field) + field.first.capacity() + 4 * sizeof(void*);
+    }
+    return total;
+}
+
+void ArrayObject::trace(Heap& heap) {
+    for (auto& element : elements) {
+        heap.mark(element);
+    }
+}
+
+const String& StringObject::str() {
+    if (!materialized) {
+        value.assign(mapped.data(), mapped.size());
+        materialized = true;
+    }
+    return value;
+}
+
+TaskObject::TaskObject() : Object(ObjectKind::TASK), state(State::PENDING), cancelled(false) {}
+
+TaskObject::~TaskObject() = default;
+
+void TaskObject::trace(Heap& heap) {
+    heap.mark(result);
+    for (auto* waiter : waiters) {
+        heap.mark(waiter);
+    }
+    if (coroutine) {
+        coroutine->markValues(heap);
+    }
+}
+
+Heap::Heap(size_t maxHeapBytes)
+    : objects(nullptr), bytesAllocated(0), nextCollection(INITIAL_THRESHOLD),
+      maxBytes(maxHeapBytes), objectCount(0) {}
+
+Heap::~Heap() {
+    Object* object = objects;
+    while (object) {
+        Object* next = object->next;
+        delete object;
+        object = next;
+    }
+
+    if (currentHeap == this) {
+        currentHeap = nullptr;
+    }
+}
+
+Heap& Heap::current() {
+    if (currentHeap) {
+        return *currentHeap;
+    }
+
+    // Values created outside any interpreter land in a per-thread heap that
+    // is simply never collected.
+    thread_local Heap fallback;
+    return fallback;
+}
+
+Heap* Heap::setCurrent(Heap* heap) {
+    Heap* previous = currentHeap;
+    currentHeap = heap;
+    return previous;
+}
+
+template<typename T>
+T* Heap::track(T* object) {
+    object->next = objects;
+    object->owner = this;
+    objects = object;
+    objectCount++;
+
+    bytesAllocated += object->size();
+    stats.heapBytes = bytesAllocated;
+    stats.liveObjects = objectCount;
+    stats.peakHeapBytes = std::max(stats.peakHeapBytes, bytesAllocated);
+
+    return object;
+}
+
+StringObject* Heap::allocateString(String value) {
+    return track(new StringObject(std::move(value)));
+}
+
+StringObject* Heap::allocateMappedString(Ptr<MappedFile> file, std::string_view range) {
+    return track(new StringObject(std::move(file), range));
+}
+
+StructObject* Heap::allocateStruct(String typeName) {
+    return track(new StructObject(std::move(typeName)));
+}
+
+TaskObject* Heap::allocateTask() {
+    return track(new TaskObject());
+}
+
+ChannelObject* Heap::allocateChannel(Ptr<Channel> channel) {
+    return track(new ChannelObject(std::move(channel)));
+}
+
+ArrayObject* Heap::allocateArray(size_t size) {
+    return track(new ArrayObject(size));
+}
+
+ReaderObject* Heap::allocateReader(Ptr<LineReader> reader) {
+    return track(new ReaderObject(std::move(reader)));
+}
+
+WriterObject* Heap::allocateWriter(Ptr<FileWriter> writer) {
+    return track(new WriterObject(std::move(writer)));
+}
+
+BytesObject* Heap::allocateBytes(size_t length, bool zeroed) {
+    return track(new BytesObject(length, zeroed));
+}
+
+BytesObject* Heap::allocateBytesSlice(const BytesObject& source, size_t offset, size_t length) {
+    return track(new BytesObject(source, offset, length));
+}
+
+CsvReaderObject* Heap::allocateCsvReader(Ptr<CsvReader> reader) {
+    return track(new CsvReaderObject(std::move(reader)));
+}
+
+NdjsonReaderObject* Heap::allocateNdjsonReader(Ptr<NdjsonReader> reader) {
+    return track(new NdjsonReaderObject(std::move(reader)));
+}
+
+DirectoryWalkerObject* Heap::allocateDirectoryWalker(Ptr<DirectoryWalker> walker) {
+    return track(new DirectoryWalkerObject(std::move(walker)));
+}
+
+void Heap::addRootSource(RootSource* source) {
+    rootSources.push_back(source);
+}
+
+void Heap::removeRootSource(RootSource* source) {
+    rootSources.erase(std::remove(rootSources.begin(), rootSources.end(), source), rootSources.end());
+}
+
+void Heap::mark(const Value& value) {
+    if (value.isHeapObject()) {
+        mark(value.object);
+    }
+}
+
+void Heap::mark(Object* object) {
+    // Parallel loop workers can see objects of their parent's heap through
+    // outer variables; those are kept alive by the parent and never touched.
+    if (!object || object->marked || object->owner != this) {
+        return;
+    }
+
+    object->marked = true;
+    grayStack.push_back(object);
+}
+
+void Heap::collect() {
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto* source : rootSources) {
+        source->markRoots(*this);
+    }
+
+    for (auto& root : tempRoots) {
+        mark(root);
+    }
+
+    traceReferences();
+    sweep();
+
+    double pauseMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    stats.collections++;
+    stats.totalPauseMs += pauseMs;
+    stats.maxPauseMs = std::max(stats.maxPauseMs, pauseMs);
+    stats.heapBytes = bytesAllocated;
+    stats.liveObjects = objectCount;
+
+    nextCollection = std::max(INITIAL_THRESHOLD, bytesAllocated * 2);
+
+    if (maxBytes > 0) {
+        if (bytesAllocated > maxBytes) {
+            throw BudgetExceededError("heap", "Heap limit exceeded: " + std::to_string(bytesAllocated) +
+                " bytes live, limit is " + std::to_string(maxBytes));
+        }
+        nextCollection = std::min(nextCollection, maxBytes);
+    }
+}
+
+void Heap::traceReferences() {
+    while (!grayStack.empty()) {
+        Object* object = grayStack.back();
+        grayStack.pop_back();
+        object->trace(*this);
+    }
+}
+
+void Heap::sweep() {
+    Object** link = &objects;
+
+    while (*link) {
+        Object* object = *link;
+        if (object->marked) {
+            object->marked = false;
+            link = &object->next;
+            continue;
+        }
+
+        *link = object->next;
+        size_t freed = object->size();
+        bytesAllocated -= std::min(bytesAllocated, freed);
+        stats.bytesFreed += freed;
+        stats.objectsFreed++;
+        objectCount--;
+        delete object;
+    }
+}
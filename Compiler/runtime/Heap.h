@@ -0,0 +1,305 @@
+#pragma once
+
+#include "../Common.h"
+#include "Value.h"
+#include "MappedFile.h"
+#include "LineReader.h"
+#include "FileWriter.h"
+#include "CsvReader.h"
+#include "Json.h"
+#include "DirectoryWalker.h"
+#include <exception>
+
+class Heap;
+class Coroutine;
+class Channel;
+
+enum class ObjectKind {
+    STRING,
+    STRUCT,
+    TASK,
+    CHANNEL,
+    ARRAY,
+    READER,
+    WRITER,
+    BYTES,
+    CSV_READER,
+    NDJSON_READER,
+    DIR_WALKER
+};
+
+class Object {
+public:
+    ObjectKind kind;
+    bool marked;
+    Object* next;
+    Heap* owner;
+
+    explicit Object(ObjectKind k) : kind(k), marked(false), next(nullptr), owner(nullptr) {}
+    virtual ~Object() = default;
+
+    virtual void trace(Heap& /*heap*/) {}
+    virtual size_t size() const = 0;
+};
+
+// A string either owns its bytes or views part of a mapped file: the whole
+// of it for file.map(), a single field for the csv reader. A mapped string
+// is only copied into `value` if something asks for it as a std::string;
+// that copy is not charged to the heap, whose accounting needs size() to
+// stay fixed.
+class StringObject : public Object {
+public:
+    String value;
+    Ptr<MappedFile> mapping;
+    std::string_view mapped;
+
+    explicit StringObject(String val) : Object(ObjectKind::STRING), value(std::move(val)) {}
+    StringObject(Ptr<MappedFile> file, std::string_view range)
+        : Object(ObjectKind::STRING), mapping(std::move(file)), mapped(range), materialized(false) {}
+
+    std::string_view view() const { return mapping ? mapped : std::string_view(value); }
+    const String& str();
+
+    size_t size() const override { return sizeof(StringObject) + (mapping ? 0 : value.capacity()); }
+
+private:
+    bool materialized = true;
+};
+
+class StructObject : public Object {
+public:
+    String typeName;
+    Map<String, Value> fields;
+
+    explicit StructObject(String name) : Object(ObjectKind::STRUCT), typeName(std::move(name)) {}
+
+    void trace(Heap& heap) override;
+    size_t size() const override;
+};
+
+class ArrayObject : public Object {
+public:
+    Vec<Value> elements;
+
+    explicit ArrayObject(size_t size) : Object(ObjectKind::ARRAY), elements(size) {}
+
+    void trace(Heap& heap) override;
+    size_t size() const override { return sizeof(ArrayObject) + elements.capacity() * sizeof(Value); }
+};
+
+// Handle returned by `spawn` and by asynchronous builtins. A task finishes
+// once, with a result or an error, and the tasks awaiting it are queued to
+// run again. Spawned tasks own their coroutine until they finish; tasks
+// completed by the event loop (file I/O, timers) never have one.
+class TaskObject : public Object {
+public:
+    enum class State { PENDING, DONE, FAILED };
+
+    State state;
+    Value result;
+    std::exception_ptr error;
+    Vec<TaskObject*> waiters;
+    std::unique_ptr<Coroutine> coroutine;
+    bool cancelled;
+
+    TaskObject();
+    ~TaskObject() override;
+
+    bool isFinished() const { return state != State::PENDING; }
+
+    void trace(Heap& heap) override;
+    size_t size() const override { return sizeof(TaskObject) + waiters.capacity() * sizeof(TaskObject*); }
+};
+
+// Handle to a channel. The channel itself is shared between isolates and
+// lives until the last handle on any heap is collected.
+class ChannelObject : public Object {
+public:
+    Ptr<Channel> channel;
+
+    explicit ChannelObject(Ptr<Channel> ch) : Object(ObjectKind::CHANNEL), channel(std::move(ch)) {}
+
+    size_t size() const override { return sizeof(ChannelObject); }
+};
+
+// A byte buffer, or a slice of one sharing its storage; writes through a
+// slice are seen by the buffer and its other slices. Only the buffer that
+// allocated the storage charges it to the heap, so size() stays fixed.
+class BytesObject : public Object {
+public:
+    std::shared_ptr<uint8_t[]> storage;
+    uint8_t* data;
+    size_t length;
+    bool ownsStorage;
+
+    BytesObject(size_t size, bool zeroed)
+        : Object(ObjectKind::BYTES), storage(zeroed ? new uint8_t[size]() : new uint8_t[size]),
+          data(storage.get()), length(size), ownsStorage(true) {}
+    BytesObject(const BytesObject& source, size_t offset, size_t size)
+        : Object(ObjectKind::BYTES), storage(source.storage),
+          data(source.data + offset), length(size), ownsStorage(false) {}
+
+    size_t size() const override { return sizeof(BytesObject) + (ownsStorage ? length : 0); }
+};
+
+// Handle to a line reader from file.open() or file.lines(). The file is
+// closed at its end, by reader.close(), or when the last handle goes.
+class ReaderObject : public Object {
+public:
+    Ptr<LineReader> reader;
+
+    explicit ReaderObject(Ptr<LineReader> r) : Object(ObjectKind::READER), reader(std::move(r)) {}
+
+    size_t size() const override { return sizeof(ReaderObject); }
+};
+
+// Handle from file.openWrite() or file.append(). Buffered output is written
+// when the handle is closed, including when it is collected.
+class WriterObject : public Object {
+public:
+    Ptr<FileWriter> writer;
+
+    explicit WriterObject(Ptr<FileWriter> w) : Object(ObjectKind::WRITER), writer(std::move(w)) {}
+
+    size_t size() const override { return sizeof(WriterObject); }
+};
+
+// Handle from csv.open() or csv.rows(). Its fields may view the reader's
+// mapping, which stays alive as long as any of them does.
+class CsvReaderObject : public Object {
+public:
+    Ptr<CsvReader> reader;
+
+    explicit CsvReaderObject(Ptr<CsvReader> r) : Object(ObjectKind::CSV_READER), reader(std::move(r)) {}
+
+    size_t size() const override { return sizeof(CsvReaderObject); }
+};
+
+// Handle from json.lines().
+class NdjsonReaderObject : public Object {
+public:
+    Ptr<NdjsonReader> reader;
+
+    explicit NdjsonReaderObject(Ptr<NdjsonReader> r) : Object(ObjectKind::NDJSON_READER), reader(std::move(r)) {}
+
+    size_t size() const override { return sizeof(NdjsonReaderObject); }
+};
+
+// Handle from fs.walker(). Collecting it stops the walk's threads.
+class DirectoryWalkerObject : public Object {
+public:
+    Ptr<DirectoryWalker> walker;
+
+    explicit DirectoryWalkerObject(Ptr<DirectoryWalker> w) : Object(ObjectKind::DIR_WALKER), walker(std::move(w)) {}
+
+    size_t size() const override { return sizeof(DirectoryWalkerObject); }
+};
+
+// Anything that holds Values outside the heap (interpreter frames, globals,
+// argument buffers) registers itself so a collection can find its roots.
+class RootSource {
+public:
+    virtual ~RootSource() = default;
+    virtual void markRoots(Heap& heap) = 0;
+};
+
+struct HeapStats {
+    size_t collections = 0;
+    size_t objectsFreed = 0;
+    size_t bytesFreed = 0;
+    double totalPauseMs = 0.0;
+    double maxPauseMs = 0.0;
+    size_t heapBytes = 0;
+    size_t peakHeapBytes = 0;
+    size_t liveObjects = 0;
+};
+
+// Precise, non-moving mark-sweep collector for the payloads of string,
+// function and struct Values. Collections only run at interpreter safe
+// points (calls and loop back-edges) or when explicitly requested, so
+// C++ code never sees an object disappear underneath it mid-expression.
+class Heap {
+public:
+    static constexpr size_t INITIAL_THRESHOLD = 1024 * 1024;
+
+    explicit Heap(size_t maxBytes = 0);
+    ~Heap();
+
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    static Heap& current();
+    static Heap* setCurrent(Heap* heap);
+
+    StringObject* allocateString(String value);
+    StringObject* allocateMappedString(Ptr<MappedFile> file, std::string_view range);
+    StructObject* allocateStruct(String typeName);
+    TaskObject* allocateTask();
+    ChannelObject* allocateChannel(Ptr<Channel> channel);
+    ArrayObject* allocateArray(size_t size);
+    ReaderObject* allocateReader(Ptr<LineReader> reader);
+    WriterObject* allocateWriter(Ptr<FileWriter> writer);
+    BytesObject* allocateBytes(size_t length, bool zeroed);
+    BytesObject* allocateBytesSlice(const BytesObject& source, size_t offset, size_t length);
+    CsvReaderObject* allocateCsvReader(Ptr<CsvReader> reader);
+    NdjsonReaderObject* allocateNdjsonReader(Ptr<NdjsonReader> reader);
+    DirectoryWalkerObject* allocateDirectoryWalker(Ptr<DirectoryWalker> walker);
+
+    void addRootSource(RootSource* source);
+    void removeRootSource(RootSource* source);
+
+    void pushRoot(const Value& value) { tempRoots.push_back(value); }
+    void popRoot() { tempRoots.pop_back(); }
+
+    // Temporary roots are pushed and popped in stack order per thread of
+    // control, so each task keeps its own set while it is switched out.
+    void swapTempRoots(Vec<Value>& other) { tempRoots.swap(other); }
+
+    bool shouldCollect() const { return bytesAllocated >= nextCollection; }
+    void collect();
+
+    void mark(const Value& value);
+    void mark(Object* object);
+
+    void setMaxBytes(size_t bytes) { maxBytes = bytes; }
+    size_t getMaxBytes() const { return maxBytes; }
+    const HeapStats& getStats() const { return stats; }
+
+private:
+    Object* objects;
+    size_t bytesAllocated;
+    size_t nextCollection;
+    size_t maxBytes;
+    size_t objectCount;
+
+    Vec<Object*> grayStack;
+    Vec<Value> tempRoots;
+    Vec<RootSource*> rootSources;
+    HeapStats stats;
+
+    template<typename T>
+    T* track(T* object);
+
+    void traceReferences();
+    void sweep();
+};
+
+// Keeps a temporary Value alive across a possible collection, e.g. the left
+// operand of a binary expression while the right operand calls a function.
+class TempRoot {
+public:
+    TempRoot(Heap& h, const Value& value) : heap(h), pushed(value.isHeapObject()) {
+        if (pushed) heap.pushRoot(value);
+    }
+
+    ~TempRoot() {
+        if (pushed) heap.popRoot();
+    }
+
+    TempRoot(const TempRoot&) = delete;
+    TempRoot& operator=(const TempRoot&) = delete;
+
+private:
+    Heap& heap;
+    bool pushed;
+};
@@ -1,14 +1,137 @@
 #include "Interpreter.h"
-#include "../builtins/Builtins.h"
 #include "../utils/Error.h"
+#include "../analysis/TypeChecker.h"
+#include "Operators.h"
+#include "ThreadPool.h"
+#include "Channel.h"
+#include "Scheduler.h"
+#include "LineReader.h"
+#include "CsvReader.h"
+#include "MappedFile.h"
+#include "../utils/StringUtil.h"
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstring>
 
-Interpreter::Interpreter() : recursionDepth(0) {
+Interpreter::Interpreter()
+    : recursionDepth(0), argumentDepth(0), returning(false),
+      stepsUntilCheck(Constants::BUDGET_CHECK_INTERVAL), isWorker(false), runningTask(nullptr) {
     globalEnv = MAKE_PTR(Environment, nullptr);
-    currentEnv = globalEnv;
+    currentEnv = globalEnv.get();
+    heap.addRootSource(this);
+    isolate.getEventLoop().setAwaitHook([this](TaskObject* task) { waitFor(task, 0); });
+    isolate.setHost(this);
+}
+
+Interpreter::Interpreter(Interpreter& parent)
+    : recursionDepth(0), argumentDepth(0), returning(false),
+      stepsUntilCheck(Constants::BUDGET_CHECK_INTERVAL), isWorker(true), runningTask(nullptr) {
+    globalEnv = MAKE_PTR(Environment, parent.globalEnv.get());
+    currentEnv = globalEnv.get();
+    heap.setMaxBytes(parent.heap.getMaxBytes());
+    heap.addRootSource(this);
+    isolate.setArguments(parent.isolate.getArguments());
+    isolate.setOutput(&parent.isolate.getOutput());
+    isolate.getEventLoop().setAwaitHook([this](TaskObject* task) { waitFor(task, 0); });
+    isolate.setHost(this);
+}
+
+Interpreter::~Interpreter() {
+    heap.removeRootSource(this);
+}
+
+void Interpreter::markRoots(Heap& gcHeap) {
+    globalEnv->markValues(gcHeap);
+
+    for (int i = 0; i < recursionDepth; ++i) {
+        frames[i].markValues(gcHeap);
+    }
+
+    for (size_t i = 0; i < argumentDepth; ++i) {
+        for (auto& arg : argumentBuffers[i]) {
+            gcHeap.mark(arg);
+        }
+    }
+
+    for (auto& literal : stringLiterals) {
+        gcHeap.mark(literal.second);
+    }
+
+    gcHeap.mark(returnValue);
+    parallelFrame.markValues(gcHeap);
+    isolate.getEventLoop().markRoots(gcHeap);
+}
+
+void Interpreter::safePoint() {
+    if (heap.shouldCollect()) {
+        heap.collect();
+    }
+    if (--stepsUntilCheck == 0) {
+        checkBudget();
+    }
+}
+
+// Charges the steps since the last check to the run's budget, and gives up
+// the thread if a Scheduler slice is over. Worker interpreters only charge:
+// they run inside a parallel loop that their parent is waiting on.
+void Interpreter::checkBudget() {
+    stepsUntilCheck = Constants::BUDGET_CHECK_INTERVAL;
+
+    if (Budget* budget = isolate.getBudget()) {
+        budget->charge(Constants::BUDGET_CHECK_INTERVAL);
+    }
+
+    if (!isWorker && Scheduler::sliceExpired()) {
+        yieldSlice();
+    }
+}
+
+// A task cannot give up the job's fiber from its own, so it goes back to
+// the end of the ready queue and the event loop yields in its place.
+void Interpreter::yieldSlice() {
+    if (!runningTask) {
+        Scheduler::yield();
+        return;
+    }
+
+    isolate.getEventLoop().schedule(runningTask);
+    Fiber::current()->suspend();
+
+    if (runningTask->cancelled) {
+        throw RuntimeError("Task cancelled");
+    }
 }
 
 void Interpreter::execute(Ptr<ProgramNode> program) {
+    IsolateScope scope(isolate, heap);
+
+    std::exception_ptr failure;
+    try {
+        executeProgram(program);
+        // Tasks nobody awaited still run to completion before the program ends.
+        runEventLoop(nullptr, 0);
+    }
+    catch (...) {
+        failure = std::current_exception();
+    }
+
+    size_t stuck = cancelTasks();
+
+    if (Budget* budget = isolate.getBudget()) {
+        budget->add(Constants::BUDGET_CHECK_INTERVAL - stepsUntilCheck);
+    }
+    stepsUntilCheck = Constants::BUDGET_CHECK_INTERVAL;
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    if (stuck > 0) {
+        throw RuntimeError("Deadlock: " + std::to_string(stuck) + " task(s) were still waiting when the program ended");
+    }
+}
+
+void Interpreter::executeProgram(Ptr<ProgramNode> program) {
     for (auto& def : program->definitions) {
         if (def->nodeType == ASTNodeType::FUNC_DEFINITION) {
             auto funcDef = std::static_pointer_cast<FuncDefinitionNode>(def);
@@ -22,288 +145,1255 @@ void Interpreter::execute(Ptr<ProgramNode> program) {
 
     for (auto& def : program->definitions) {
         if (def->nodeType == ASTNodeType::VAR_DEFINITION) {
-            executeDefinition(def);
+            executeDefinition(def.get());
         }
     }
     if (globalEnv->hasFunction("Main")) {
-        try {
-            callFunction("Main", {});
-        }
-        catch (const ReturnException& e) {}
+        callFunction("Main", {});
     }
 }
 
-void Interpreter::executeIfStatement(Ptr<IfNode> node) {
-    Value condition = evaluate(node->condition);
-
-    if (condition.isTruthy()) {
-        for (auto& stmt : node->thenBranch) {
-            executeStatement(stmt);
-        }
+void Interpreter::executeIfStatement(IfNode* node) {
+    if (evaluateCondition(node->condition.get())) {
+        executeBlock(node->thenBranch);
         return;
     }
 
     for (auto& elseIfBranch : node->elseIfBranches) {
-        Value elseIfCondition = evaluate(elseIfBranch.condition);
-        if (elseIfCondition.isTruthy()) {
-            for (auto& stmt : elseIfBranch.body) {
-                executeStatement(stmt);
-            }
+        if (evaluateCondition(elseIfBranch.condition.get())) {
+            executeBlock(elseIfBranch.body);
             return;
         }
     }
 
-    if (!node->elseBranch.empty()) {
-        for (auto& stmt : node->elseBranch) {
-            executeStatement(stmt);
-        }
-    }
+    executeBlock(node->elseBranch);
 }
 
-void Interpreter::executeForStatement(Ptr<ForNode> node) {
-    Value startVal = evaluate(node->start);
-    Value endVal = evaluate(node->end);
+void Interpreter::executeForStatement(ForNode* node) {
+    if (node->source) {
+        executeForEach(node);
+        return;
+    }
 
-    if (!startVal.isInt() || !endVal.isInt()) {
-        throw TypeError("For loop range must be integers");
+    int64_t start;
+    int64_t end;
+
+    if (node->start->staticType == StaticType::INT && node->end->staticType == StaticType::INT) {
+        start = evaluateInt(node->start.get());
+        end = evaluateInt(node->end.get());
     }
+    else {
+        Value startVal = evaluate(node->start.get());
+        Value endVal = evaluate(node->end.get());
 
-    int start = startVal.asInt();
-    int end = endVal.asInt();
+        if (!startVal.isInt() || !endVal.isInt()) {
+            throw TypeError("For loop range must be integers", node->line);
+        }
+
+        start = startVal.asInt();
+        end = endVal.asInt();
+    }
 
     if (start > end) {
         return; 
     }
 
+    // Loops parallelized by the analysis only pay for the pool when the
+    // range is long enough to amortize it.
+    bool worthIt = !node->autoParallel ||
+        static_cast<uint64_t>(end) - static_cast<uint64_t>(start) >= Constants::AUTO_PARALLEL_MIN_ITERATIONS;
+
+    if (node->parallel && worthIt && !ThreadPool::insideTask() && ThreadPool::shared().size() > 1) {
+        executeParallelFor(node, start, end);
+        return;
+    }
+
+    executeRangeFor(node, start, end);
+}
+
+void Interpreter::executeRangeFor(ForNode* node, int64_t start, int64_t end) {
     currentEnv->define(node->iterator, Value::makeInt(start));
-    Value iteratorValue = Value::makeInt(start);
+    Value& iteratorValue = currentEnv->lookup(node->iterator);
     size_t bodySize = node->body.size();
 
-    for (int i = start; i <= end; ++i) {
+    for (int64_t i = start; i <= end; ++i) {
         iteratorValue.intValue = i;
-        currentEnv->set(node->iterator, iteratorValue);
 
         for (size_t j = 0; j < bodySize; ++j) {
-            executeStatement(node->body[j]);
+            executeStatement(node->body[j].get());
+            if (returning) {
+                return;
+            }
+        }
+
+        safePoint();
+    }
+}
+
+// Runs the body once per line of a reader, row of a csv reader, value of
+// an ndjson reader or batch of paths from a walker. Each line is copied out
+// of the reader's buffer into a fresh string, since the body may keep it;
+// each row is a fresh array for the same reason.
+void Interpreter::executeForEach(ForNode* node) {
+    Value source = evaluate(node->source.get());
+    if (!source.isReader() && !source.isCsvReader() && !source.isNdjsonReader() && !source.isDirectoryWalker()) {
+        throw TypeError("For loop source must be a range or a reader, got " + source.getTypeName(), node->line);
+    }
+
+    TempRoot sourceRoot(heap, source);
+
+    currentEnv->define(node->iterator, Value::makeNil());
+    Value& iteratorValue = currentEnv->lookup(node->iterator);
+    size_t bodySize = node->body.size();
+
+    std::string_view line;
+    while (true) {
+        if (source.isReader()) {
+            if (!source.asReader()->nextLine(line)) {
+                break;
+            }
+            iteratorValue = Value::makeString(String(line));
+        }
+        else if (source.isCsvReader()) {
+            iteratorValue = source.asCsvReader()->nextRow();
+            if (iteratorValue.isNil()) {
+                break;
+            }
+        }
+        else if (source.isDirectoryWalker()) {
+            iteratorValue = source.asDirectoryWalker()->nextBatch();
+            if (iteratorValue.isNil()) {
+                break;
+            }
+        }
+        else if (!source.asNdjsonReader()->next(iteratorValue)) {
+            break;
+        }
+
+        for (size_t j = 0; j < bodySize; ++j) {
+            executeStatement(node->body[j].get());
+            if (returning) {
+                return;
+            }
+        }
+
+        safePoint();
+    }
+}
+
+namespace {
+    constexpr size_t CHUNKS_PER_PARTICIPANT = 8;
+
+    // Smaller files are not worth splitting any further.
+    constexpr size_t MIN_SHARD_BYTES = 64 * 1024;
+
+    Value reductionIdentity(ReductionKind kind, const Value& current) {
+        bool isFloat = current.isFloat();
+
+        switch (kind) {
+        case ReductionKind::MIN:
+            return isFloat ? Value::makeFloat(std::numeric_limits<double>::infinity())
+                : Value::makeInt(std::numeric_limits<int64_t>::max());
+        case ReductionKind::MAX:
+            return isFloat ? Value::makeFloat(-std::numeric_limits<double>::infinity())
+                : Value::makeInt(std::numeric_limits<int64_t>::min());
+        default:
+            return isFloat ? Value::makeFloat(0.0) : Value::makeInt(0);
+        }
+    }
+
+    Value combineReduction(ReductionKind kind, const Value& a, const Value& b) {
+        if (a.isInt() && b.isInt()) {
+            switch (kind) {
+            case ReductionKind::MIN: return Value::makeInt(std::min(a.intValue, b.intValue));
+            case ReductionKind::MAX: return Value::makeInt(std::max(a.intValue, b.intValue));
+            default: return Value::makeInt(Operators::applyInt(BinaryOp::ADD, a.intValue, b.intValue));
+            }
+        }
+
+        double l = a.isInt() ? static_cast<double>(a.intValue) : a.floatValue;
+        double r = b.isInt() ? static_cast<double>(b.intValue) : b.floatValue;
+        switch (kind) {
+        case ReductionKind::MIN: return Value::makeFloat(std::min(l, r));
+        case ReductionKind::MAX: return Value::makeFloat(std::max(l, r));
+        default: return Value::makeFloat(l + r);
+        }
+    }
+
+    // Folds one SUM or COUNT result of a parallel.* or file.parallelLines()
+    // call into its chunk's partial.
+    void accumulate(ScriptHost::Aggregate aggregate, const char* caller, const String& function,
+        Value& partial, const Value& result) {
+        if (aggregate == ScriptHost::Aggregate::COUNT) {
+            if (result.isTruthy()) {
+                partial.intValue++;
+            }
+            return;
+        }
+
+        if (!result.isInt() && !result.isFloat()) {
+            throw TypeError(String(caller) + "() requires '" + function + "' to return int or float, got " +
+                result.getTypeName());
+        }
+        partial = combineReduction(ReductionKind::SUM, partial, result);
+    }
+
+    // The start of the line after offset, or size if there is none.
+    size_t nextLineStart(const char* data, size_t size, size_t offset) {
+        const void* newline = std::memchr(data + offset, '\n', size - offset);
+        return newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+    }
+
+    size_t countLines(const char* data, size_t begin, size_t end) {
+        size_t lines = 0;
+        while (begin < end) {
+            begin = nextLineStart(data, end, begin);
+            lines++;
+        }
+        return lines;
+    }
+}
+
+// Creates worker interpreters up to count and points them at the current
+// run's budget, which may have changed since they were made (REPL).
+void Interpreter::prepareWorkers(size_t count) {
+    while (workers.size() < count) {
+        workers.emplace_back(new Interpreter(*this));
+    }
+    for (auto& worker : workers) {
+        worker->isolate.setBudget(isolate.getSharedBudget());
+    }
+}
+
+// Splits the range into chunks that run on the shared pool, each on the
+// worker interpreter of whichever participant picks it up. Partial
+// reduction results are folded in chunk order, so integer results do not
+// depend on scheduling. A chunk's integer sum can overflow where the
+// in-order sum does not, and the other way round; when a chunk overflows
+// or the fold cannot rule out an overflow, a body that only calls pure
+// functions runs again in order here so the result, or the error, is the
+// one a sequential run gives. Any other body may have had effects, such
+// as console output or channel sends, so the overflow is reported.
+void Interpreter::executeParallelFor(ForNode* node, int64_t start, int64_t end) {
+    ThreadPool& pool = ThreadPool::shared();
+
+    prepareWorkers(pool.size());
+
+    size_t reductionCount = node->reductions.size();
+    Vec<Value> identities;
+    for (auto& reduction : node->reductions) {
+        const Value& current = currentEnv->lookup(reduction.variable);
+        if (!current.isInt() && !current.isFloat()) {
+            throw TypeError("Reduction variable '" + reduction.variable + "' must be int or float", node->line);
+        }
+        identities.push_back(reductionIdentity(reduction.kind, current));
+    }
+
+    uint64_t iterations = static_cast<uint64_t>(end) - static_cast<uint64_t>(start) + 1;
+    size_t chunks = static_cast<size_t>(std::min<uint64_t>(iterations, pool.size() * CHUNKS_PER_PARTICIPANT));
+    Vec<ChunkResult> partials(chunks * reductionCount);
+    Environment* outer = currentEnv;
+
+    // Chunks draw random numbers from their own streams, so a seeded run
+    // gives the same results whichever thread picks up which chunk.
+    Vec<Isolate::RandomState> streams = isolate.splitRandom(chunks);
+
+    try {
+        pool.run(chunks, [&](size_t chunk, size_t participant) {
+            uint64_t first = iterations * chunk / chunks;
+            uint64_t last = iterations * (chunk + 1) / chunks;
+            workers[participant]->isolate.setRandomState(streams[chunk]);
+            workers[participant]->runParallelChunk(node, outer,
+                start + static_cast<int64_t>(first), start + static_cast<int64_t>(last - 1),
+                identities, partials.data() + chunk * reductionCount);
+        });
+    }
+    catch (IntegerOverflowError& e) {
+        if (!node->pureBody) {
+            if (e.line == 0) e.line = node->line;
+            throw;
+        }
+        executeRangeFor(node, start, end);
+        return;
+    }
+
+    Vec<Value> results(reductionCount);
+    for (size_t r = 0; r < reductionCount; ++r) {
+        const Reduction& reduction = node->reductions[r];
+        results[r] = currentEnv->lookup(reduction.variable);
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            const ChunkResult& partial = partials[chunk * reductionCount + r];
+            if (!partial.bounds.fitsAfter(results[r])) {
+                if (!node->pureBody) {
+                    throw IntegerOverflowError("Integer overflow in reduction '" + reduction.variable + "'", node->line);
+                }
+                executeRangeFor(node, start, end);
+                return;
+            }
+            results[r] = combineReduction(reduction.kind, results[r], partial.value);
+        }
+    }
+
+    for (size_t r = 0; r < reductionCount; ++r) {
+        currentEnv->lookup(node->reductions[r].variable) = results[r];
+    }
+}
+
+void Interpreter::runParallelChunk(ForNode* node, Environment* outer, int64_t start, int64_t end,
+    const Vec<Value>& identities, ChunkResult* results) {
+    IsolateScope scope(isolate, heap);
+
+    size_t reductionCount = node->reductions.size();
+    parallelFrame.reset(outer);
+    for (size_t r = 0; r < reductionCount; ++r) {
+        parallelFrame.define(node->reductions[r].variable, identities[r]);
+    }
+    parallelFrame.define(node->iterator, Value::makeInt(start));
+
+    // Integer sums and counts, whose bounds the fold needs.
+    Vec<std::pair<Value*, SumBounds*>> sums;
+    for (size_t r = 0; r < reductionCount; ++r) {
+        results[r].bounds = SumBounds();
+        ReductionKind kind = node->reductions[r].kind;
+        if (identities[r].isInt() && kind != ReductionKind::MIN && kind != ReductionKind::MAX) {
+            sums.emplace_back(&parallelFrame.lookup(node->reductions[r].variable), &results[r].bounds);
+        }
+    }
+
+    Value& iteratorValue = parallelFrame.lookup(node->iterator);
+    size_t bodySize = node->body.size();
+    currentEnv = &parallelFrame;
+
+    try {
+        for (int64_t i = start; i <= end; ++i) {
+            iteratorValue.intValue = i;
+
+            for (size_t j = 0; j < bodySize; ++j) {
+                executeStatement(node->body[j].get());
+            }
+            for (auto& sum : sums) {
+                sum.second->note(*sum.first);
+            }
+
+            safePoint();
         }
     }
+    catch (...) {
+        currentEnv = globalEnv.get();
+        parallelFrame.reset(nullptr);
+        throw;
+    }
+
+    for (size_t r = 0; r < reductionCount; ++r) {
+        results[r].value = parallelFrame.lookup(node->reductions[r].variable);
+    }
+
+    currentEnv = globalEnv.get();
+    parallelFrame.reset(nullptr);
 }
 
-void Interpreter::executeDefinition(Ptr<ASTNode> node) {
+// Backs parallel.sum/count/map. Like a parallel for loop the range is split
+// into chunks run by the workers and combined in chunk order, but only
+// functions the analysis found parallel-safe are spread across threads;
+// anything else runs here, one call after another, with the same result.
+Value Interpreter::callOverRange(Aggregate aggregate, const String& function, int64_t first, int64_t last) {
+    FuncDefinitionNode* func = findFunction(function);
+    if (!func) {
+        throw NameError("Undefined function: " + function);
+    }
+    if (func->parameters.size() != 1) {
+        throw RuntimeError("Function '" + function + "' must take exactly one argument to be called over a range");
+    }
+
+    uint64_t iterations = first > last ? 0 : static_cast<uint64_t>(last) - static_cast<uint64_t>(first) + 1;
+    if (iterations > Constants::MAX_ARRAY_LENGTH && aggregate == Aggregate::MAP) {
+        throw RuntimeError("Range too large for an array: " + std::to_string(iterations) + " elements");
+    }
+
+    Value array = aggregate == Aggregate::MAP ? Value::makeArray(static_cast<size_t>(iterations)) : Value::makeNil();
+    TempRoot arrayRoot(heap, array);
+    if (iterations == 0) {
+        return aggregate == Aggregate::MAP ? array : Value::makeInt(0);
+    }
+
+    ThreadPool& pool = ThreadPool::shared();
+    size_t chunks = func->parallelSafe
+        ? static_cast<size_t>(std::min<uint64_t>(iterations, pool.size() * CHUNKS_PER_PARTICIPANT)) : 1;
+    Vec<ChunkResult> partials(chunks);
+
+    // Workers cannot touch this heap, so heap-allocated map results travel
+    // back as messages and are rebuilt here once every chunk is done.
+    Vec<Vec<std::pair<size_t, Message>>> detached(chunks);
+
+    auto runChunk = [&](Interpreter& runner, size_t chunk) {
+        uint64_t begin = iterations * chunk / chunks;
+        uint64_t end = iterations * (chunk + 1) / chunks;
+        Vec<Value> args(1);
+        Value partial = Value::makeInt(0);
+        SumBounds sumBounds;
+
+        for (uint64_t i = begin; i < end; ++i) {
+            args[0] = Value::makeInt(first + static_cast<int64_t>(i));
+            Value result = runner.callUserFunction(func, args);
+
+            if (aggregate != Aggregate::MAP) {
+                accumulate(aggregate, "parallel.sum", function, partial, result);
+                sumBounds.note(partial);
+            }
+            else if (&runner == this || !result.isHeapObject()) {
+                array.asArray()->elements[i] = result;
+            }
+            else {
+                detached[chunk].emplace_back(static_cast<size_t>(i), Message::detach(result));
+            }
+        }
+
+        partials[chunk] = ChunkResult{ partial, sumBounds };
+    };
+
+    if (!func->parallelSafe) {
+        runChunk(*this, 0);
+    }
+    else {
+        prepareWorkers(pool.size());
+
+        Vec<Isolate::RandomState> streams = isolate.splitRandom(chunks);
+
+        bool overflowed = false;
+        try {
+            pool.run(chunks, [&](size_t chunk, size_t participant) {
+                Interpreter& worker = *workers[participant];
+                IsolateScope scope(worker.isolate, worker.heap);
+                worker.isolate.setRandomState(streams[chunk]);
+                runChunk(worker, chunk);
+            });
+        }
+        catch (const IntegerOverflowError&) {
+            if (aggregate == Aggregate::MAP) {
+                throw;
+            }
+            overflowed = true;
+        }
+
+        // As in a parallel for loop, a sum that may have overflowed in a
+        // different place than the in-order sum is redone in order, if the
+        // function is pure so calling it again changes nothing else.
+        if ((overflowed || !foldsInOrder(partials)) && !func->pure) {
+            throw IntegerOverflowError("Integer overflow in parallel.sum() over '" + function + "'");
+        }
+        if (overflowed || !foldsInOrder(partials)) {
+            chunks = 1;
+            partials.assign(1, ChunkResult());
+            runChunk(*this, 0);
+        }
+    }
+
+    if (aggregate == Aggregate::MAP) {
+        for (auto& messages : detached) {
+            for (auto& entry : messages) {
+                array.asArray()->elements[entry.first] = entry.second.attach();
+            }
+        }
+        return array;
+    }
+
+    Value result = Value::makeInt(0);
+    for (auto& partial : partials) {
+        result = combineReduction(ReductionKind::SUM, result, partial.value);
+    }
+    return result;
+}
+
+// True if adding every value the chunks summed, one at a time and in
+// order, onto zero never overflows; the chunk sums can then be combined
+// as they are.
+bool Interpreter::foldsInOrder(const Vec<ChunkResult>& partials) {
+    Value running = Value::makeInt(0);
+    for (auto& partial : partials) {
+        if (!partial.bounds.fitsAfter(running)) {
+            return false;
+        }
+        running = combineReduction(ReductionKind::SUM, running, partial.value);
+    }
+    return true;
+}
+
+// Backs file.parallelLines(). The file is mapped and cut into byte ranges
+// whose edges are moved forward to the next line start, so every line
+// falls in exactly one shard; shards are scanned by the workers straight
+// from the mapping and combined in file order. As with callOverRange, a
+// function that is not parallel-safe gets a single shard run here. Array
+// results need the line count up front, which costs one extra memchr pass
+// over the file.
+Value Interpreter::callOverLines(Aggregate aggregate, const String& function, const String& path) {
+    FuncDefinitionNode* func = findFunction(function);
+    if (!func) {
+        throw NameError("Undefined function: " + function);
+    }
+    if (func->parameters.size() != 1) {
+        throw RuntimeError("Function '" + function + "' must take exactly one argument to be called per line");
+    }
+
+    Ptr<MappedFile> file = MappedFile::open(path);
+    const char* data = file->data();
+    size_t size = file->size();
+
+    ThreadPool& pool = ThreadPool::shared();
+    size_t shards = func->parallelSafe ? std::min(pool.size() * CHUNKS_PER_PARTICIPANT, size / MIN_SHARD_BYTES + 1) : 1;
+
+    Vec<size_t> bounds(shards + 1, size);
+    bounds[0] = 0;
+    for (size_t shard = 1; shard < shards; ++shard) {
+        size_t nominal = static_cast<size_t>(static_cast<uint64_t>(size) * shard / shards);
+        size_t start = std::max(nominal, bounds[shard - 1]);
+        bounds[shard] = start == 0 ? 0 : nextLineStart(data, size, start - 1);
+    }
+
+    // Where each shard's lines start in the result array.
+    Vec<size_t> firstLine(shards + 1, 0);
+    if (aggregate == Aggregate::MAP) {
+        pool.run(shards, [&](size_t shard, size_t) {
+            firstLine[shard + 1] = countLines(data, bounds[shard], bounds[shard + 1]);
+        });
+        for (size_t shard = 0; shard < shards; ++shard) {
+            firstLine[shard + 1] += firstLine[shard];
+        }
+        if (firstLine[shards] > Constants::MAX_ARRAY_LENGTH) {
+            throw RuntimeError("Too many lines for an array: " + std::to_string(firstLine[shards]));
+        }
+    }
+
+    Value array = aggregate == Aggregate::MAP ? Value::makeArray(firstLine[shards]) : Value::makeNil();
+    TempRoot arrayRoot(heap, array);
+
+    Vec<ChunkResult> partials(shards);
+    Vec<Vec<std::pair<size_t, Message>>> detached(shards);
+
+    auto runShard = [&](Interpreter& runner, size_t shard) {
+        size_t position = bounds[shard];
+        size_t end = bounds[shard + 1];
+        size_t index = firstLine[shard];
+        Vec<Value> args(1);
+        Value partial = Value::makeInt(0);
+        SumBounds sumBounds;
+
+        while (position < end) {
+            size_t next = nextLineStart(data, end, position);
+            size_t length = next - position;
+            if (length > 0 && data[position + length - 1] == '\n') length--;
+            if (length > 0 && data[position + length - 1] == '\r') length--;
+
+            // Not yet bound to a parameter when the call's safe point runs.
+            args[0] = Value::makeString(String(data + position, length));
+            TempRoot lineRoot(runner.heap, args[0]);
+            Value result = runner.callUserFunction(func, args);
+            position = next;
+
+            if (aggregate != Aggregate::MAP) {
+                accumulate(aggregate, "file.parallelLines", function, partial, result);
+                sumBounds.note(partial);
+            }
+            else if (&runner == this || !result.isHeapObject()) {
+                array.asArray()->elements[index] = result;
+            }
+            else {
+                detached[shard].emplace_back(index, Message::detach(result));
+            }
+            index++;
+        }
+
+        partials[shard] = ChunkResult{ partial, sumBounds };
+    };
+
+    if (!func->parallelSafe) {
+        runShard(*this, 0);
+    }
+    else {
+        prepareWorkers(pool.size());
+
+        Vec<Isolate::RandomState> streams = isolate.splitRandom(shards);
+
+        bool overflowed = false;
+        try {
+            pool.run(shards, [&](size_t shard, size_t participant) {
+                Interpreter& worker = *workers[participant];
+                IsolateScope scope(worker.isolate, worker.heap);
+                worker.isolate.setRandomState(streams[shard]);
+                runShard(worker, shard);
+            });
+        }
+        catch (const IntegerOverflowError&) {
+            if (aggregate == Aggregate::MAP) {
+                throw;
+            }
+            overflowed = true;
+        }
+
+        if ((overflowed || !foldsInOrder(partials)) && !func->pure) {
+            throw IntegerOverflowError("Integer overflow in file.parallelLines() over '" + function + "'");
+        }
+        if (overflowed || !foldsInOrder(partials)) {
+            bounds[1] = size;
+            partials.assign(1, ChunkResult());
+            runShard(*this, 0);
+        }
+    }
+
+    if (aggregate == Aggregate::MAP) {
+        for (auto& messages : detached) {
+            for (auto& entry : messages) {
+                array.asArray()->elements[entry.first] = entry.second.attach();
+            }
+        }
+        return array;
+    }
+
+    Value result = Value::makeInt(0);
+    for (auto& partial : partials) {
+        result = combineReduction(ReductionKind::SUM, result, partial.value);
+    }
+    return result;
+}
+
+void Interpreter::executeDefinition(ASTNode* node) {
     switch (node->nodeType) {
     case ASTNodeType::VAR_DEFINITION:
-        executeVarDefinition(std::static_pointer_cast<VarDefinitionNode>(node));
+        executeVarDefinition(static_cast<VarDefinitionNode*>(node));
         break;
     case ASTNodeType::STRUCT_DEFINITION:
-        executeStructDefinition(std::static_pointer_cast<StructDefinitionNode>(node));
+        executeStructDefinition(static_cast<StructDefinitionNode*>(node));
         break;
     case ASTNodeType::FUNC_DEFINITION:
-        executeFuncDefinition(std::static_pointer_cast<FuncDefinitionNode>(node));
+        executeFuncDefinition(static_cast<FuncDefinitionNode*>(node));
         break;
     default:
         throw RuntimeError("Unknown definition type");
     }
 }
 
-void Interpreter::executeVarDefinition(Ptr<VarDefinitionNode> node) {
+void Interpreter::executeVarDefinition(VarDefinitionNode* node) {
     if (node->names.size() != node->values.size()) {
         throw RuntimeError("Mismatch between number of names and values in definition", node->line);
     }
 
     for (size_t i = 0; i < node->names.size(); ++i) {
-        Value value = evaluate(node->values[i]);
+        Value value = evaluate(node->values[i].get());
+        if (node->guardType != StaticType::UNKNOWN) {
+            checkStaticType(value, node->guardType, node->names[i], node->line);
+        }
         currentEnv->define(node->names[i], value);
     }
 }
 
-void Interpreter::executeStructDefinition(Ptr<StructDefinitionNode> node) {}
-void Interpreter::executeFuncDefinition(Ptr<FuncDefinitionNode> node) {}
+void Interpreter::executeStructDefinition(StructDefinitionNode* /*node*/) {}
+void Interpreter::executeFuncDefinition(FuncDefinitionNode* /*node*/) {}
 
-void Interpreter::executeStatement(Ptr<ASTNode> node) {
-    switch (node->nodeType) {
-    case ASTNodeType::VAR_DEFINITION:
-        executeVarDefinition(std::static_pointer_cast<VarDefinitionNode>(node));
-        break;
-    case ASTNodeType::ASSIGNMENT:
-        executeAssignment(std::static_pointer_cast<AssignmentNode>(node));
-        break;
-    case ASTNodeType::IF_STMT:
-        executeIfStatement(std::static_pointer_cast<IfNode>(node));
-        break;
-    case ASTNodeType::FOR_STMT:
-        executeForStatement(std::static_pointer_cast<ForNode>(node));
-        break;
-    case ASTNodeType::RETURN_STMT:
-        throw ReturnException(executeReturn(std::static_pointer_cast<ReturnNode>(node)));
-    case ASTNodeType::CALL_EXPR:
-        evaluate(node); 
-        break;
-    default:
-        evaluate(node); 
-        break;
+void Interpreter::executeBlock(const Vec<Ptr<ASTNode>>& body) {
+    for (auto& stmt : body) {
+        executeStatement(stmt.get());
+        if (returning) {
+            return;
+        }
     }
 }
 
-void Interpreter::executeAssignment(Ptr<AssignmentNode> node) {
-    Value value = evaluate(node->value);
+// Overflows are thrown by the operators, which do not know where they
+// are; the innermost statement around one gives it its line.
+void Interpreter::executeStatement(ASTNode* node) {
+    try {
+        switch (node->nodeType) {
+        case ASTNodeType::VAR_DEFINITION:
+            executeVarDefinition(static_cast<VarDefinitionNode*>(node));
+            break;
+        case ASTNodeType::ASSIGNMENT:
+            executeAssignment(static_cast<AssignmentNode*>(node));
+            break;
+        case ASTNodeType::IF_STMT:
+            executeIfStatement(static_cast<IfNode*>(node));
+            break;
+        case ASTNodeType::FOR_STMT:
+            executeForStatement(static_cast<ForNode*>(node));
+            break;
+        case ASTNodeType::RETURN_STMT:
+            returnValue = executeReturn(static_cast<ReturnNode*>(node));
+            returning = true;
+            break;
+        case ASTNodeType::CALL_EXPR:
+            evaluate(node); 
+            break;
+        default:
+            evaluate(node); 
+            break;
+        }
+    }
+    catch (IntegerOverflowError& e) {
+        if (e.line == 0) e.line = node->line;
+        throw;
+    }
+}
+
+void Interpreter::executeAssignment(AssignmentNode* node) {
+    // The checker confines parallel bodies to their own frame, but functions
+    // they call could still reach for a global shared with other workers.
+    if (isWorker && !currentEnv->definesLocally(node->identifier)) {
+        throw RuntimeError("Cannot assign to '" + node->identifier + "' from a parallel for worker", node->line);
+    }
+
+    if (node->value->staticType == StaticType::INT) {
+        int64_t result = evaluateInt(node->value.get());
+        Value& target = currentEnv->lookup(node->identifier);
+        if (target.isInt()) {
+            target.intValue = result;
+        }
+        else {
+            currentEnv->set(node->identifier, Value::makeInt(result));
+        }
+        return;
+    }
+
+    if (node->value->staticType == StaticType::FLOAT) {
+        double result = evaluateFloat(node->value.get());
+        Value& target = currentEnv->lookup(node->identifier);
+        if (target.isFloat()) {
+            target.floatValue = result;
+        }
+        else {
+            currentEnv->set(node->identifier, Value::makeFloat(result));
+        }
+        return;
+    }
+
+    Value value = evaluate(node->value.get());
+    if (node->guardType != StaticType::UNKNOWN) {
+        checkStaticType(value, node->guardType, node->identifier, node->line);
+    }
     currentEnv->set(node->identifier, value);
 }
 
-Value Interpreter::executeReturn(Ptr<ReturnNode> node) {
+Value Interpreter::executeReturn(ReturnNode* node) {
     if (node->value) {
-        return evaluate(node->value);
+        return evaluate(node->value.get());
     }
     return Value::makeNil();
 }
 
-Value Interpreter::evaluate(Ptr<ASTNode> node) {
+Value Interpreter::evaluate(ASTNode* node) {
     if (!node) {
         return Value::makeNil();
     }
 
     switch (node->nodeType) {
     case ASTNodeType::BINARY_EXPR:
-        return evaluateBinary(std::static_pointer_cast<BinaryExprNode>(node));
+        return evaluateBinary(static_cast<BinaryExprNode*>(node));
     case ASTNodeType::UNARY_EXPR:
-        return evaluateUnary(std::static_pointer_cast<UnaryExprNode>(node));
+        return evaluateUnary(static_cast<UnaryExprNode*>(node));
     case ASTNodeType::TERNARY_EXPR:
-        return evaluateTernary(std::static_pointer_cast<TernaryExprNode>(node));
+        return evaluateTernary(static_cast<TernaryExprNode*>(node));
     case ASTNodeType::CALL_EXPR:
-        return evaluateCall(std::static_pointer_cast<CallExprNode>(node));
+        return evaluateCall(static_cast<CallExprNode*>(node));
     case ASTNodeType::LITERAL:
-        return evaluateLiteral(std::static_pointer_cast<LiteralNode>(node));
+        return evaluateLiteral(static_cast<LiteralNode*>(node));
     case ASTNodeType::IDENTIFIER:
-        return evaluateIdentifier(std::static_pointer_cast<IdentifierNode>(node));
+        return evaluateIdentifier(static_cast<IdentifierNode*>(node));
     case ASTNodeType::MEMBER_ACCESS:
-        return evaluateMemberAccess(std::static_pointer_cast<MemberAccessNode>(node));
+        return evaluateMemberAccess(static_cast<MemberAccessNode*>(node));
+    case ASTNodeType::SPAWN_EXPR:
+        return evaluateSpawn(static_cast<SpawnExprNode*>(node));
+    case ASTNodeType::AWAIT_EXPR:
+        return evaluateAwait(static_cast<AwaitExprNode*>(node));
     default:
         throw RuntimeError("Cannot evaluate node type: " + std::to_string(static_cast<int>(node->nodeType)));
     }
 }
 
-Value Interpreter::evaluateBinary(Ptr<BinaryExprNode> node) {
-    Value left = evaluate(node->left);
-    Value right = evaluate(node->right);
+namespace {
+    inline bool isNumeric(StaticType type) {
+        return type == StaticType::INT || type == StaticType::FLOAT;
+    }
+}
 
-    const String& op = node->op;
+Value Interpreter::evaluateBinary(BinaryExprNode* node) {
+    BinaryOp op = node->opCode;
+    StaticType leftType = node->left->staticType;
+    StaticType rightType = node->right->staticType;
 
-    if (left.isInt() && right.isInt()) {
-        int l = left.asInt();
-        int r = right.asInt();
+    if (op == BinaryOp::AND) {
+        return Value::makeBool(evaluateCondition(node->left.get()) && evaluateCondition(node->right.get()));
+    }
+    if (op == BinaryOp::OR) {
+        return Value::makeBool(evaluateCondition(node->left.get()) || evaluateCondition(node->right.get()));
+    }
+
+    if (leftType == StaticType::INT && rightType == StaticType::INT) {
+        int64_t result = Operators::applyInt(op, evaluateInt(node->left.get()), evaluateInt(node->right.get()));
+        if (node->staticType == StaticType::BOOL) {
+            return Value::makeBool(result != 0);
+        }
+        return Value::makeInt(result);
+    }
 
-        switch (op[0]) {
-        case '+': return Value::makeInt(l + r);
-        case '-': return Value::makeInt(l - r);
-        case '*': return Value::makeInt(l * r);
-        case '/':
-            if (r == 0) throw RuntimeError("Division by zero");
-            return Value::makeInt(l / r);
-        case '%':
-            if (r == 0) throw RuntimeError("Modulo by zero");
-            return Value::makeInt(l % r);
-        case '<':
-            if (op.length() == 1) return Value::makeBool(l < r);
-            return Value::makeBool(l <= r); 
-        case '>':
-            if (op.length() == 1) return Value::makeBool(l > r);
-            return Value::makeBool(l >= r);
-        case '=': 
-            return Value::makeBool(l == r);
-        case '!': 
-            return Value::makeBool(l != r);
+    if (isNumeric(leftType) && isNumeric(rightType)) {
+        double l = evaluateFloat(node->left.get());
+        double r = evaluateFloat(node->right.get());
+        if (Operators::isComparison(op)) {
+            return Value::makeBool(Operators::compareFloat(op, l, r));
         }
+        return Value::makeFloat(Operators::applyFloat(op, l, r));
+    }
+
+    Value left = evaluate(node->left.get());
+    TempRoot leftRoot(heap, left);
+    Value right = evaluate(node->right.get());
+
+    BinaryKernel kernel = Operators::lookup(left.type, right.type, op);
+    if (!kernel) {
+        throw TypeError("Operator '" + node->op + "' cannot be applied to " +
+            left.getTypeName() + " and " + right.getTypeName(), node->line);
     }
+    return kernel(left, right);
 }
 
-Value Interpreter::evaluateUnary(Ptr<UnaryExprNode> node) {
-    Value operand = evaluate(node->operand);
+int64_t Interpreter::evaluateInt(ASTNode* node) {
+    switch (node->nodeType) {
+    case ASTNodeType::LITERAL:
+        return static_cast<LiteralNode*>(node)->intValue;
+    case ASTNodeType::IDENTIFIER:
+        return currentEnv->lookup(static_cast<IdentifierNode*>(node)->name).intValue;
+    case ASTNodeType::BINARY_EXPR: {
+        auto binary = static_cast<BinaryExprNode*>(node);
+        if (binary->left->staticType == StaticType::INT && binary->right->staticType == StaticType::INT) {
+            return Operators::applyInt(binary->opCode, evaluateInt(binary->left.get()), evaluateInt(binary->right.get()));
+        }
+        break;
+    }
+    case ASTNodeType::UNARY_EXPR: {
+        auto unary = static_cast<UnaryExprNode*>(node);
+        if (unary->operand->staticType == StaticType::INT) {
+            return Operators::applyInt(BinaryOp::SUB, 0, evaluateInt(unary->operand.get()));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return evaluate(node).intValue;
+}
+
+// Evaluates an expression statically known to be INT or FLOAT as an unboxed
+// double, promoting int subexpressions on the way.
+double Interpreter::evaluateFloat(ASTNode* node) {
+    if (node->staticType == StaticType::INT) {
+        return static_cast<double>(evaluateInt(node));
+    }
+
+    switch (node->nodeType) {
+    case ASTNodeType::LITERAL:
+        return static_cast<LiteralNode*>(node)->floatValue;
+    case ASTNodeType::IDENTIFIER:
+        return currentEnv->lookup(static_cast<IdentifierNode*>(node)->name).floatValue;
+    case ASTNodeType::BINARY_EXPR: {
+        auto binary = static_cast<BinaryExprNode*>(node);
+        if (Operators::isArithmetic(binary->opCode) &&
+            isNumeric(binary->left->staticType) && isNumeric(binary->right->staticType)) {
+            return Operators::applyFloat(binary->opCode, evaluateFloat(binary->left.get()), evaluateFloat(binary->right.get()));
+        }
+        break;
+    }
+    case ASTNodeType::UNARY_EXPR: {
+        auto unary = static_cast<UnaryExprNode*>(node);
+        if (isNumeric(unary->operand->staticType)) {
+            return -evaluateFloat(unary->operand.get());
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    Value value = evaluate(node);
+    return value.isInt() ? static_cast<double>(value.intValue) : value.floatValue;
+}
+
+bool Interpreter::evaluateCondition(ASTNode* node) {
+    if (node->nodeType == ASTNodeType::BINARY_EXPR) {
+        auto binary = static_cast<BinaryExprNode*>(node);
+        StaticType leftType = binary->left->staticType;
+        StaticType rightType = binary->right->staticType;
+
+        switch (binary->opCode) {
+        case BinaryOp::AND:
+            return evaluateCondition(binary->left.get()) && evaluateCondition(binary->right.get());
+        case BinaryOp::OR:
+            return evaluateCondition(binary->left.get()) || evaluateCondition(binary->right.get());
+        default:
+            break;
+        }
+
+        if (leftType == StaticType::INT && rightType == StaticType::INT) {
+            return Operators::applyInt(binary->opCode, evaluateInt(binary->left.get()), evaluateInt(binary->right.get())) != 0;
+        }
+        if (Operators::isComparison(binary->opCode) && isNumeric(leftType) && isNumeric(rightType)) {
+            return Operators::compareFloat(binary->opCode, evaluateFloat(binary->left.get()), evaluateFloat(binary->right.get()));
+        }
+    }
+
+    return evaluate(node).isTruthy();
+}
+
+Value Interpreter::evaluateUnary(UnaryExprNode* node) {
+    Value operand = evaluate(node->operand.get());
 
     if (node->op == "-") {
         if (operand.isInt()) {
-            return Value::makeInt(-operand.asInt());
+            return Value::makeInt(Operators::applyInt(BinaryOp::SUB, 0, operand.asInt()));
+        }
+        if (operand.isFloat()) {
+            return Value::makeFloat(-operand.asFloat());
         }
-        throw TypeError("Unary '-' requires integer operand");
+        throw TypeError("Unary '-' cannot be applied to " + operand.getTypeName(), node->line);
     }
 
     throw RuntimeError("Unknown unary operator: " + node->op);
 }
 
-Value Interpreter::evaluateTernary(Ptr<TernaryExprNode> node) {
-    Value condition = evaluate(node->condition);
+Value Interpreter::evaluateTernary(TernaryExprNode* node) {
+    Value condition = evaluate(node->condition.get());
 
     if (condition.isTruthy()) {
-        return evaluate(node->trueExpr);
+        return evaluate(node->trueExpr.get());
     }
     else {
-        return evaluate(node->falseExpr);
+        return evaluate(node->falseExpr.get());
     }
 }
 
-Value Interpreter::evaluateCall(Ptr<CallExprNode> node) {
-    Vec<Value> args;
-    for (auto& argExpr : node->arguments) {
-        args.push_back(evaluate(argExpr));
+Value Interpreter::evaluateCall(CallExprNode* node) {
+    if (argumentDepth == argumentBuffers.size()) {
+        argumentBuffers.emplace_back();
     }
 
-    return callFunction(node->callee, args);
+    Vec<Value>& args = argumentBuffers[argumentDepth];
+    args.clear();
+    argumentDepth++;
+
+    try {
+        for (auto& argExpr : node->arguments) {
+            args.push_back(evaluate(argExpr.get()));
+        }
+
+        Value result = node->target
+            ? callUserFunction(node->target, args, node->checkArguments)
+            : callFunction(node->callee, args);
+
+        argumentDepth--;
+        return result;
+    }
+    catch (...) {
+        argumentDepth--;
+        throw;
+    }
 }
 
-Value Interpreter::evaluateLiteral(Ptr<LiteralNode> node) {
+Value Interpreter::evaluateLiteral(LiteralNode* node) {
     switch (node->litType) {
-    case LiteralNode::LiteralType::INTEGER:
-        return Value::makeInt(std::stoi(node->value));
-    case LiteralNode::LiteralType::STRING:
-        return Value::makeString(node->value);
+    case LiteralNode::LiteralType::INTEGER: {
+        if (node->staticType == StaticType::INT) {
+            return Value::makeInt(node->intValue);
+        }
+        int64_t value;
+        if (!StringUtil::parseInt(node->value, value)) {
+            throw RuntimeError("Integer literal out of range: " + node->value, node->line);
+        }
+        return Value::makeInt(value);
+    }
+    case LiteralNode::LiteralType::STRING: {
+        auto it = stringLiterals.find(node);
+        if (it != stringLiterals.end()) {
+            return it->second;
+        }
+        Value literal = Value::makeString(node->value);
+        stringLiterals[node] = literal;
+        return literal;
+    }
     case LiteralNode::LiteralType::BOOLEAN:
         return Value::makeBool(node->value == "true");
-    case LiteralNode::LiteralType::FLOAT:
-        return Value::makeFloat(std::stof(node->value));
+    case LiteralNode::LiteralType::FLOAT: {
+        if (node->staticType == StaticType::FLOAT) {
+            return Value::makeFloat(node->floatValue);
+        }
+        double value;
+        if (!StringUtil::parseFloat(node->value, value)) {
+            throw RuntimeError("Invalid float literal: " + node->value, node->line);
+        }
+        return Value::makeFloat(value);
+    }
     default:
         throw RuntimeError("Unknown literal type");
     }
 }
 
-Value Interpreter::evaluateIdentifier(Ptr<IdentifierNode> node) {
-    return currentEnv->get(node->name);
+Value Interpreter::evaluateIdentifier(IdentifierNode* node) {
+    return currentEnv->lookup(node->name);
 }
 
-Value Interpreter::evaluateMemberAccess(Ptr<MemberAccessNode> node) {
+Value Interpreter::evaluateMemberAccess(MemberAccessNode* /*node*/) {
     throw RuntimeError("Member access not yet implemented for non-function contexts");
 }
 
-Value Interpreter::callFunction(const String& name, const Vec<Value>& args) {
-    auto builtinIt = builtinCache.find(name);
+Value Interpreter::evaluateSpawn(SpawnExprNode* node) {
+    if (isWorker) {
+        throw RuntimeError("Cannot spawn a task from a parallel for worker", node->line);
+    }
+
+    CallExprNode* call = node->call.get();
+    EventLoop& loop = isolate.getEventLoop();
+
+    TaskObject* task = loop.createTask();
+    task->coroutine = acquireCoroutine();
 
-    if (builtinIt != builtinCache.end()) {
-        if (builtinIt->second) {
-            return callBuiltinFunction(name, args);
+    Coroutine& coroutine = *task->coroutine;
+    coroutine.callee = call->callee;
+    coroutine.target = call->target;
+    coroutine.checkArguments = call->checkArguments;
+
+    try {
+        for (auto& argExpr : call->arguments) {
+            coroutine.arguments.push_back(evaluate(argExpr.get()));
         }
     }
-    else {
-        bool isBuiltin = isBuiltinFunction(name);
-        builtinCache[name] = isBuiltin;
+    catch (...) {
+        releaseCoroutine(task);
+        loop.fail(task, std::current_exception());
+        throw;
+    }
+
+    loop.schedule(task);
+    return Value::makeTask(task);
+}
+
+Value Interpreter::evaluateAwait(AwaitExprNode* node) {
+    Value handle = evaluate(node->task.get());
+    if (!handle.isTask()) {
+        throw TypeError("await expects a task, got " + handle.getTypeName(), node->line);
+    }
+
+    TaskObject* task = handle.asTask();
+
+    if (!task->isFinished()) {
+        if (isWorker) {
+            throw RuntimeError("Cannot await a task from a parallel for worker", node->line);
+        }
+
+        if (task == runningTask) {
+            throw RuntimeError("A task cannot await itself", node->line);
+        }
+
+        TempRoot root(heap, handle);
+        waitFor(task, node->line);
+    }
+
+    if (task->state == TaskObject::State::FAILED) {
+        std::rethrow_exception(task->error);
+    }
+    return task->result;
+}
+
+// Suspends the running task until `task` finishes, or drives the event loop
+// when called on the thread's own stack. Builtins that block (channels)
+// reach this through the event loop's await hook.
+void Interpreter::waitFor(TaskObject* task, int line) {
+    if (task->isFinished()) {
+        return;
+    }
+
+    if (!runningTask) {
+        runEventLoop(task, line);
+        return;
+    }
+
+    task->waiters.push_back(runningTask);
+    Fiber::current()->suspend();
+
+    if (runningTask->cancelled) {
+        throw RuntimeError("Task cancelled while waiting", line);
+    }
+}
+
+// Runs ready tasks until `until` finishes, or until nothing is left to run
+// when it is null. Only the thread's own stack drives the loop; a task that
+// awaits suspends back to it instead.
+void Interpreter::runEventLoop(TaskObject* until, int line) {
+    EventLoop& loop = isolate.getEventLoop();
+
+    while (true) {
+        loop.poll();
+
+        if (until && until->isFinished()) {
+            return;
+        }
+
+        if (TaskObject* next = loop.nextReady()) {
+            resumeTask(next);
+            if (!isWorker && Scheduler::sliceExpired()) {
+                Scheduler::yield();
+            }
+            continue;
+        }
+
+        if (until ? loop.hasPendingWork() : loop.hasBackgroundWork()) {
+            loop.wait();
+            continue;
+        }
+
+        if (!until) {
+            return;
+        }
+        throw RuntimeError("Deadlock: the awaited task can never finish", line);
+    }
+}
+
+void Interpreter::resumeTask(TaskObject* task) {
+    Coroutine& coroutine = *task->coroutine;
+
+    if (!coroutine.started) {
+        if (!coroutine.fiber) {
+            coroutine.fiber = std::make_unique<Fiber>();
+        }
+        coroutine.fiber->start(&Interpreter::taskEntry, this);
+        coroutine.started = true;
+    }
+
+    swapState(coroutine.state);
+    runningTask = task;
+    coroutine.fiber->resume();
+    runningTask = nullptr;
+    swapState(coroutine.state);
+
+    if (task->isFinished()) {
+        releaseCoroutine(task);
+    }
+}
+
+void Interpreter::taskEntry(void* interpreter) {
+    static_cast<Interpreter*>(interpreter)->runTask();
+}
+
+void Interpreter::runTask() {
+    TaskObject* task = runningTask;
+    Coroutine& coroutine = *task->coroutine;
+    EventLoop& loop = isolate.getEventLoop();
+
+    try {
+        Value result = coroutine.target
+            ? callUserFunction(coroutine.target, coroutine.arguments, coroutine.checkArguments)
+            : callFunction(coroutine.callee, coroutine.arguments);
+        loop.complete(task, result);
+    }
+    catch (...) {
+        loop.fail(task, std::current_exception());
+    }
+}
+
+// Fails every spawned task that has not finished, unwinding suspended ones
+// so their stacks are released. Called once the program is over, when such
+// tasks are either waiting on each other or abandoned after an error.
+size_t Interpreter::cancelTasks() {
+    EventLoop& loop = isolate.getEventLoop();
+    size_t cancelled = 0;
 
-        if (isBuiltin) {
-            return callBuiltinFunction(name, args);
+    for (TaskObject* task : loop.pendingTasks()) {
+        if (task->isFinished() || !task->coroutine) {
+            continue;
+        }
+
+        task->cancelled = true;
+        cancelled++;
+
+        if (task->coroutine->started) {
+            resumeTask(task);
+        }
+        else {
+            releaseCoroutine(task);
+            loop.fail(task, std::make_exception_ptr(RuntimeError("Task cancelled before it started")));
         }
     }
 
+    return cancelled;
+}
+
+std::unique_ptr<Coroutine> Interpreter::acquireCoroutine() {
+    std::unique_ptr<Coroutine> coroutine;
+
+    if (idleCoroutines.empty()) {
+        coroutine = std::make_unique<Coroutine>();
+    }
+    else {
+        coroutine = std::move(idleCoroutines.back());
+        idleCoroutines.pop_back();
+    }
+
+    coroutine->state.currentEnv = globalEnv.get();
+    return coroutine;
+}
+
+void Interpreter::releaseCoroutine(TaskObject* task) {
+    std::unique_ptr<Coroutine> coroutine = std::move(task->coroutine);
+
+    coroutine->arguments.clear();
+    coroutine->started = false;
+    coroutine->state.recursionDepth = 0;
+    coroutine->state.argumentDepth = 0;
+    coroutine->state.returning = false;
+    coroutine->state.returnValue = Value::makeNil();
+    coroutine->state.tempRoots.clear();
+
+    if (idleCoroutines.size() < Constants::TASK_POOL_SIZE) {
+        idleCoroutines.push_back(std::move(coroutine));
+    }
+}
+
+void Interpreter::swapState(ExecutionState& state) {
+    std::swap(currentEnv, state.currentEnv);
+    std::swap(recursionDepth, state.recursionDepth);
+    frames.swap(state.frames);
+    argumentBuffers.swap(state.argumentBuffers);
+    std::swap(argumentDepth, state.argumentDepth);
+    std::swap(returning, state.returning);
+    std::swap(returnValue, state.returnValue);
+    heap.swapTempRoots(state.tempRoots);
+}
+
+Value Interpreter::callFunction(const String& name, const Vec<Value>& args) {
+    if (const BuiltinFunction* builtin = resolveBuiltin(name)) {
+        return (*builtin)(args);
+    }
+
+    if (FuncDefinitionNode* func = findFunction(name)) {
+        return callUserFunction(func, args);
+    }
+
+    throw NameError("Undefined function: " + name);
+}
+
+FuncDefinitionNode* Interpreter::findFunction(const String& name) {
     auto funcIt = functionCache.find(name);
     if (funcIt != functionCache.end()) {
-        return callUserFunction(funcIt->second, args);
+        return funcIt->second.get();
     }
 
     if (currentEnv->hasFunction(name)) {
         auto func = currentEnv->getFunction(name);
         functionCache[name] = func;
-        return callUserFunction(func, args);
+        return func.get();
     }
 
-    throw NameError("Undefined function: " + name);
+    return nullptr;
 }
 
-Value Interpreter::callUserFunction(Ptr<FuncDefinitionNode> func, const Vec<Value>& args) {
+Value Interpreter::callUserFunction(FuncDefinitionNode* func, const Vec<Value>& args, bool checkArguments) {
     checkRecursionDepth();
+    safePoint();
 
     if (args.size() != func->parameters.size()) {
         throw RuntimeError("Function '" + func->name + "' expects " +
@@ -311,44 +1401,99 @@ Value Interpreter::callUserFunction(Ptr<FuncDefinitionNode> func, const Vec<Valu
             std::to_string(args.size()));
     }
 
-    auto funcEnv = MAKE_PTR(Environment, currentEnv);
+    if (checkArguments) {
+        for (size_t i = 0; i < func->parameters.size(); ++i) {
+            const Parameter& param = func->parameters[i];
+            if (param.staticType != StaticType::UNKNOWN) {
+                checkStaticType(args[i], param.staticType, param.name, func->line);
+            }
+        }
+    }
+
+    if (static_cast<size_t>(recursionDepth) == frames.size()) {
+        frames.emplace_back(globalEnv.get());
+    }
+
+    Environment* funcEnv = &frames[recursionDepth];
+    funcEnv->reset(globalEnv.get());
 
     for (size_t i = 0; i < func->parameters.size(); ++i) {
         funcEnv->define(func->parameters[i].name, args[i]);
     }
 
-    auto prevEnv = currentEnv;
+    Environment* prevEnv = currentEnv;
     currentEnv = funcEnv;
     recursionDepth++;
 
     try {
-        for (auto& stmt : func->body) {
-            executeStatement(stmt);
-        }
-
+        executeBlock(func->body);
+    }
+    catch (...) {
         currentEnv = prevEnv;
         recursionDepth--;
+        returning = false;
+        throw;
+    }
 
-        return Value::makeNil();
+    currentEnv = prevEnv;
+    recursionDepth--;
 
+    if (returning) {
+        returning = false;
+        return std::move(returnValue);
     }
-    catch (const ReturnException& e) {
-        currentEnv = prevEnv;
-        recursionDepth--;
-        return e.value;
-    }
-}
 
-Value Interpreter::callBuiltinFunction(const String& name, const Vec<Value>& args) {
-    return BuiltinRegistry::instance().callFunction(name, args);
+    return Value::makeNil();
 }
 
-bool Interpreter::isBuiltinFunction(const String& name) const {
-    return BuiltinRegistry::instance().hasFunction(name);
+const BuiltinFunction* Interpreter::resolveBuiltin(const String& name) {
+    auto it = builtinBindings.find(name);
+    if (it != builtinBindings.end()) {
+        return it->second;
+    }
+
+    const BuiltinFunction* builtin = BuiltinRegistry::instance().findFunction(name);
+    builtinBindings[name] = builtin;
+    return builtin;
 }
 
 void Interpreter::checkRecursionDepth() {
     if (recursionDepth >= Constants::MAX_RECURSION_DEPTH) {
         throw RuntimeError("Maximum recursion depth exceeded");
     }
+
+    // Task stacks are far smaller than the main thread's, so on a fiber
+    // (a task, or a run under the Scheduler) the limit is the space
+    // actually left on it.
+    Fiber* fiber = Fiber::current();
+    if (fiber && fiber->stackRemaining() < Constants::TASK_STACK_MARGIN) {
+        throw RuntimeError(runningTask ? "Maximum recursion depth exceeded in task" : "Maximum recursion depth exceeded");
+    }
+}
+
+void Interpreter::checkStaticType(const Value& value, StaticType expected, const String& name, int line) {
+    bool matches;
+
+    switch (expected) {
+    case StaticType::INT: matches = value.isInt(); break;
+    case StaticType::FLOAT: matches = value.isFloat(); break;
+    case StaticType::STRING: matches = value.isString(); break;
+    case StaticType::BOOL: matches = value.isBool(); break;
+    case StaticType::STRUCT: matches = value.isStruct(); break;
+    case StaticType::TASK: matches = value.isTask(); break;
+    case StaticType::CHANNEL: matches = value.isChannel(); break;
+    case StaticType::ARRAY: matches = value.isArray(); break;
+    case StaticType::READER: matches = value.isReader(); break;
+    case StaticType::WRITER: matches = value.isWriter(); break;
+    case StaticType::BYTES: matches = value.isBytes(); break;
+    case StaticType::CSV_READER: matches = value.isCsvReader(); break;
+    case StaticType::NDJSON_READER: matches = value.isNdjsonReader(); break;
+    case StaticType::DIR_WALKER: matches = value.isDirectoryWalker(); break;
+    default: matches = true; break;
+    }
+
+    if (!matches) {
+        throw TypeError("Cannot assign " + value.getTypeName() + " to " +
+            TypeChecker::typeName(expected) + " '" + name + "'", line);
+    }
 }
\ No newline at end of file
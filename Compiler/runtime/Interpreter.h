@@ -4,49 +4,156 @@
 #include "../parser/AST.h"
 #include "Value.h"
 #include "Environment.h"
+#include "Heap.h"
+#include "Isolate.h"
+#include "Coroutine.h"
+#include "../builtins/Builtins.h"
+#include "../utils/CheckedMath.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <unordered_map>
 
-class Interpreter {
+class Interpreter : public RootSource, public ScriptHost {
 public:
     Interpreter();
+    ~Interpreter() override;
+
     void execute(Ptr<ProgramNode> program);
+    void markRoots(Heap& heap) override;
+    Value callOverRange(Aggregate aggregate, const String& function, int64_t first, int64_t last) override;
+    Value callOverLines(Aggregate aggregate, const String& function, const String& path) override;
+
+    Heap& getHeap() { return heap; }
+    Isolate& getIsolate() { return isolate; }
 
 private:
+    // The lowest and highest values an integer sum took while a chunk ran
+    // from zero. Adding the chunk's values one at a time onto a running
+    // total overflows exactly when the total plus either bound does not
+    // fit, which lets chunks be folded with the result an in-order run
+    // would give.
+    struct SumBounds {
+        int64_t low = 0;
+        int64_t high = 0;
+
+        void note(const Value& sum) {
+            if (sum.isInt()) {
+                low = std::min(low, sum.intValue);
+                high = std::max(high, sum.intValue);
+            }
+        }
+
+        bool fitsAfter(const Value& running) const {
+            int64_t ignored;
+            return !running.isInt() || (!CheckedMath::addOverflow(running.intValue, low, ignored) &&
+                !CheckedMath::addOverflow(running.intValue, high, ignored));
+        }
+    };
+
+    // One reduction's result for a chunk of a parallel loop, with the
+    // lowest and highest values an integer sum passed through on the way.
+    struct ChunkResult {
+        Value value;
+        SumBounds bounds;
+    };
+
+    explicit Interpreter(Interpreter& parent);
+
+    // An Interpreter is an isolate: globals, builtin bindings, RNG state and
+    // heap are all owned here, so separate instances can run on separate
+    // threads without sharing mutable state.
+    Heap heap;
+    Isolate isolate;
     Ptr<Environment> globalEnv;
-    Ptr<Environment> currentEnv;
+    Environment* currentEnv;
     int recursionDepth;
 
+    // Call frames and argument buffers are pooled per nesting depth and
+    // reused, so steady-state calls do not allocate.
+    std::deque<Environment> frames;
+    std::deque<Vec<Value>> argumentBuffers;
+    size_t argumentDepth;
+
+    bool returning;
+    Value returnValue;
+
+    // Safe points left until the budget is charged and the time slice
+    // checked again.
+    size_t stepsUntilCheck;
+
+    std::unordered_map<const LiteralNode*, Value> stringLiterals;
+
+    // Worker interpreters for parallel for loops, one per pool participant,
+    // kept across loops. A worker's globals chain to the parent's, and its
+    // parallelFrame holds the iterator, private reduction copies and body
+    // locals for the chunk it is running.
+    Vec<std::unique_ptr<Interpreter>> workers;
+    Environment parallelFrame;
+    bool isWorker;
+
+    // Spawned tasks run on fibers and share this interpreter's globals.
+    // runningTask is null on the thread's own stack, which is also where
+    // the event loop runs; finished coroutines are kept for reuse.
+    TaskObject* runningTask;
+    Vec<std::unique_ptr<Coroutine>> idleCoroutines;
+
     Map<String, Ptr<FuncDefinitionNode>> functionCache;
-    Map<String, bool> builtinCache;
-
-    void executeDefinition(Ptr<ASTNode> node);
-    void executeVarDefinition(Ptr<VarDefinitionNode> node);
-    void executeForStatement(Ptr<ForNode> node);
-    void executeIfStatement(Ptr<IfNode> node);
-    void executeStructDefinition(Ptr<StructDefinitionNode> node);
-    void executeFuncDefinition(Ptr<FuncDefinitionNode> node);
-
-    void executeStatement(Ptr<ASTNode> node);
-    void executeAssignment(Ptr<AssignmentNode> node);
-    Value executeReturn(Ptr<ReturnNode> node);
-
-    Value evaluate(Ptr<ASTNode> node);
-    Value evaluateBinary(Ptr<BinaryExprNode> node);
-    Value evaluateUnary(Ptr<UnaryExprNode> node);
-    Value evaluateTernary(Ptr<TernaryExprNode> node);
-    Value evaluateCall(Ptr<CallExprNode> node);
-    Value evaluateLiteral(Ptr<LiteralNode> node);
-    Value evaluateIdentifier(Ptr<IdentifierNode> node);
-    Value evaluateMemberAccess(Ptr<MemberAccessNode> node);
+    Map<String, const BuiltinFunction*> builtinBindings;
+
+    void executeProgram(Ptr<ProgramNode> program);
+    void executeDefinition(ASTNode* node);
+    void executeVarDefinition(VarDefinitionNode* node);
+    void executeForStatement(ForNode* node);
+    void executeForEach(ForNode* node);
+    void executeRangeFor(ForNode* node, int64_t start, int64_t end);
+    void executeParallelFor(ForNode* node, int64_t start, int64_t end);
+    void runParallelChunk(ForNode* node, Environment* outer, int64_t start, int64_t end,
+        const Vec<Value>& identities, ChunkResult* results);
+    static bool foldsInOrder(const Vec<ChunkResult>& partials);
+    FuncDefinitionNode* findFunction(const String& name);
+    void prepareWorkers(size_t count);
+    void executeIfStatement(IfNode* node);
+    void executeStructDefinition(StructDefinitionNode* node);
+    void executeFuncDefinition(FuncDefinitionNode* node);
+
+    void executeBlock(const Vec<Ptr<ASTNode>>& body);
+    void executeStatement(ASTNode* node);
+    void executeAssignment(AssignmentNode* node);
+    Value executeReturn(ReturnNode* node);
+
+    Value evaluate(ASTNode* node);
+    Value evaluateBinary(BinaryExprNode* node);
+    Value evaluateUnary(UnaryExprNode* node);
+    Value evaluateTernary(TernaryExprNode* node);
+    Value evaluateCall(CallExprNode* node);
+    Value evaluateLiteral(LiteralNode* node);
+    Value evaluateIdentifier(IdentifierNode* node);
+    Value evaluateMemberAccess(MemberAccessNode* node);
+    Value evaluateSpawn(SpawnExprNode* node);
+    Value evaluateAwait(AwaitExprNode* node);
+
+    int64_t evaluateInt(ASTNode* node);
+    bool evaluateCondition(ASTNode* node);
+    double evaluateFloat(ASTNode* node);
 
     Value callFunction(const String& name, const Vec<Value>& args);
-    Value callUserFunction(Ptr<FuncDefinitionNode> func, const Vec<Value>& args);
-    Value callBuiltinFunction(const String& name, const Vec<Value>& args);
+    Value callUserFunction(FuncDefinitionNode* func, const Vec<Value>& args, bool checkArguments = true);
+    const BuiltinFunction* resolveBuiltin(const String& name);
 
-    bool isBuiltinFunction(const String& name) const;
-    void checkRecursionDepth();
+    void waitFor(TaskObject* task, int line);
+    void runEventLoop(TaskObject* until, int line);
+    void resumeTask(TaskObject* task);
+    void runTask();
+    static void taskEntry(void* interpreter);
+    size_t cancelTasks();
+    std::unique_ptr<Coroutine> acquireCoroutine();
+    void releaseCoroutine(TaskObject* task);
+    void swapState(ExecutionState& state);
 
-    struct ReturnException {
-        Value value;
-        explicit ReturnException(const Value& v) : value(v) {}
-    };
-};
\ No newline at end of file
+    void checkRecursionDepth();
+    void safePoint();
+    void checkBudget();
+    void yieldSlice();
+    void checkStaticType(const Value& value, StaticType expected, const String& name, int line);
+};
@@ -0,0 +1,55 @@
+#include "Isolate.h"
+#include <iostream>
+#include <random>
+
+namespace {
+    thread_local Isolate* currentIsolate = nullptr;
+}
+
+Isolate::Isolate() : output(&std::cout), host(nullptr) {
+    std::random_device device;
+    randomState.random.reseed((static_cast<uint64_t>(device()) << 32) ^ device());
+}
+
+Isolate::~Isolate() {
+    if (currentIsolate == this) {
+        currentIsolate = nullptr;
+    }
+}
+
+Vec<Isolate::RandomState> Isolate::splitRandom(size_t count) {
+    Vec<RandomState> streams(count);
+
+    for (auto& stream : streams) {
+        randomState.random.jump();
+        stream.random = randomState.random;
+    }
+    randomState.random.jump();
+
+    for (auto& generator : randomState.generators) {
+        for (auto& stream : streams) {
+            generator.second.jump();
+            stream.generators[generator.first] = generator.second;
+        }
+        generator.second.jump();
+    }
+
+    return streams;
+}
+
+Isolate& Isolate::current() {
+    if (currentIsolate) {
+        return *currentIsolate;
+    }
+
+    // Builtins called outside any interpreter (e.g. from tools) get a
+    // private per-thread isolate rather than sharing one.
+    thread_local Isolate fallback;
+    return fallback;
+}
+
+Isolate* Isolate::setCurrent(Isolate* isolate) {
+    Isolate* previous = currentIsolate;
+    currentIsolate = isolate;
+    return previous;
+}
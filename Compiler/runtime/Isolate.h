@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../Common.h"
+#include "Heap.h"
+#include "EventLoop.h"
+#include "Xoshiro.h"
+#include "Budget.h"
+#include <ostream>
+
+// Lets builtins call back into the script, e.g. parallel.map() invoking a
+// user function once per index. Implemented by the Interpreter that owns
+// the isolate.
+class ScriptHost {
+public:
+    enum class Aggregate { SUM, COUNT, MAP };
+
+    virtual ~ScriptHost() = default;
+
+    // Calls function(i) for every i in [first, last] and sums the results,
+    // counts the truthy ones, or collects them into an array in index order.
+    virtual Value callOverRange(Aggregate aggregate, const String& function, int64_t first, int64_t last) = 0;
+
+    // The same over the lines of a file, each passed as a string without
+    // its line ending; array results are in line order.
+    virtual Value callOverLines(Aggregate aggregate, const String& function, const String& path) = 0;
+};
+
+// State that builtins need but that must not be shared between interpreters
+// running on different threads. Every Interpreter owns one Isolate and makes
+// it current on its thread for the duration of execute().
+class Isolate {
+public:
+    // The default generator plus any created by random.seed(name, seed).
+    struct RandomState {
+        Xoshiro256 random;
+        Map<String, Xoshiro256> generators;
+    };
+
+    Isolate();
+    ~Isolate();
+
+    Isolate(const Isolate&) = delete;
+    Isolate& operator=(const Isolate&) = delete;
+
+    static Isolate& current();
+    static Isolate* setCurrent(Isolate* isolate);
+
+    Xoshiro256& getRandom() { return randomState.random; }
+    Map<String, Xoshiro256>& getGenerators() { return randomState.generators; }
+
+    // Splits every generator into count streams that do not overlap each
+    // other or what this isolate draws afterwards, so a parallel loop can
+    // give each chunk its own reproducible sequence.
+    Vec<RandomState> splitRandom(size_t count);
+    void setRandomState(const RandomState& state) { randomState = state; }
+
+    EventLoop& getEventLoop() { return eventLoop; }
+
+    // Script arguments, as read by system.argc() and system.arg().
+    void setArguments(Vec<String> args) { arguments = std::move(args); }
+    const Vec<String>& getArguments() const { return arguments; }
+
+    // Where console.print and console.write go; std::cout unless a batch
+    // run captures the output of each script separately.
+    void setOutput(std::ostream* stream) { output = stream; }
+    std::ostream& getOutput() { return *output; }
+
+    // Limits of the current run, shared with the isolates of its parallel
+    // workers; null when the run is unlimited.
+    void setBudget(Ptr<Budget> runBudget) { budget = std::move(runBudget); }
+    Budget* getBudget() const { return budget.get(); }
+    const Ptr<Budget>& getSharedBudget() const { return budget; }
+
+    void setHost(ScriptHost* scriptHost) { host = scriptHost; }
+    ScriptHost* getHost() const { return host; }
+
+private:
+    RandomState randomState;
+    EventLoop eventLoop;
+    Vec<String> arguments;
+    std::ostream* output;
+    ScriptHost* host;
+    Ptr<Budget> budget;
+};
+
+// Makes an isolate and its heap current on this thread, restoring whatever
+// was current before on scope exit (interpreters may nest, e.g. the REPL).
+class IsolateScope {
+public:
+    IsolateScope(Isolate& isolate, Heap& heap)
+        : previousIsolate(Isolate::setCurrent(&isolate)), previousHeap(Heap::setCurrent(&heap)) {}
+
+    ~IsolateScope() {
+        Heap::setCurrent(previousHeap);
+        Isolate::setCurrent(previousIsolate);
+    }
+
+    IsolateScope(const IsolateScope&) = delete;
+    IsolateScope& operator=(const IsolateScope&) = delete;
+
+private:
+    Isolate* previousIsolate;
+    Heap* previousHeap;
+};
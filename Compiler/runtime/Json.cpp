@@ -0,0 +1,722 @@
+#include "Json.h"
+#include "Heap.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_USE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 64;
+
+    // Index and output buffers that grew past this are given back after use.
+    constexpr size_t MAX_KEPT_BUFFER = 16 * 1024 * 1024;
+
+    int lowestBit(uint64_t mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+#ifdef _M_X64
+        _BitScanForward64(&index, mask);
+#else
+        if (!_BitScanForward(&index, static_cast<unsigned long>(mask))) {
+            _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+            index += 32;
+        }
+#endif
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(mask);
+#endif
+    }
+
+    // Bit i of the result is the parity of bits 0..i of x.
+    uint64_t prefixXor(uint64_t x) {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    bool isStructural(char c) {
+        return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+    }
+
+    bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // One bit per byte of a 64-byte block.
+    struct BlockMasks {
+        uint64_t quote = 0;
+        uint64_t backslash = 0;
+        uint64_t structural = 0;
+        uint64_t space = 0;
+        uint64_t control = 0;
+    };
+
+    BlockMasks classify(const char* block) {
+        BlockMasks masks;
+#ifdef JSON_USE_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lowercase = _mm_set1_epi8(0x20);
+        // '[' and ']' are '{' and '}' without the 0x20 bit.
+        const __m128i openBrace = _mm_set1_epi8('{');
+        const __m128i closeBrace = _mm_set1_epi8('}');
+        const __m128i colon = _mm_set1_epi8(':');
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i carriageReturn = _mm_set1_epi8('\r');
+        const __m128i lastControl = _mm_set1_epi8(0x1F);
+
+        for (int i = 0; i < 4; ++i) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+            __m128i folded = _mm_or_si128(bytes, lowercase);
+            __m128i structural = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma)));
+            __m128i whitespace = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, newline), _mm_cmpeq_epi8(bytes, carriageReturn)));
+            __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(bytes, lastControl), lastControl);
+
+            int shift = i * 16;
+            masks.quote |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote))) << shift;
+            masks.backslash |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash))) << shift;
+            masks.structural |= static_cast<uint64_t>(_mm_movemask_epi8(structural)) << shift;
+            masks.space |= static_cast<uint64_t>(_mm_movemask_epi8(whitespace)) << shift;
+            masks.control |= static_cast<uint64_t>(_mm_movemask_epi8(control)) << shift;
+        }
+#else
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            char c = block[i];
+            uint64_t bit = uint64_t(1) << i;
+            if (c == '"') masks.quote |= bit;
+            if (c == '\\') masks.backslash |= bit;
+            if (isStructural(c)) masks.structural |= bit;
+            if (isSpace(c)) masks.space |= bit;
+            if (static_cast<unsigned char>(c) < 0x20) masks.control |= bit;
+        }
+#endif
+        return masks;
+    }
+
+    // The offsets found by stage one. Not a Vec, which would zero-fill
+    // memory that is about to be overwritten whenever it grows.
+    class TokenIndex {
+    public:
+        TokenIndex() : count(0), capacity(0) {}
+
+        void clear() { count = 0; }
+
+        void release() {
+            offsets.reset();
+            count = capacity = 0;
+        }
+
+        size_t bytes() const { return capacity * sizeof(uint32_t); }
+
+        // Where to write the next offsets, with room for at least n.
+        uint32_t* reserve(size_t n) {
+            if (capacity - count < n) {
+                size_t grown = std::max(capacity * 2, count + n);
+                std::unique_ptr<uint32_t[]> larger(new uint32_t[grown]);
+                if (count > 0) {
+                    std::memcpy(larger.get(), offsets.get(), count * sizeof(uint32_t));
+                }
+                offsets = std::move(larger);
+                capacity = grown;
+            }
+            return offsets.get() + count;
+        }
+
+        void setEnd(const uint32_t* end) { count = static_cast<size_t>(end - offsets.get()); }
+        uint32_t* limit() const { return offsets.get() + capacity; }
+
+        size_t size() const { return count; }
+        uint32_t operator[](size_t i) const { return offsets[i]; }
+
+    private:
+        std::unique_ptr<uint32_t[]> offsets;
+        size_t count;
+        size_t capacity;
+    };
+
+    [[noreturn]] void fail(size_t offset, size_t line, const String& message) {
+        String where = line > 0 ? " on line " + std::to_string(line) + " at offset " : " at offset ";
+        throw RuntimeError("Invalid JSON" + where + std::to_string(offset) + ": " + message);
+    }
+
+    // Stage one: the offsets of every structural character, unescaped
+    // quote, and first byte of a number or literal outside strings.
+    void buildIndex(std::string_view text, size_t line, TokenIndex& positions) {
+        if (text.size() > std::numeric_limits<uint32_t>::max()) {
+            throw RuntimeError("JSON text is larger than 4 GB");
+        }
+
+        // Carried from one block to the next: whether its first byte is
+        // escaped, is inside a string, or continues a number or literal.
+        uint64_t escapedCarry = 0;
+        uint64_t inStringCarry = 0;
+        uint64_t scalarCarry = 0;
+        char tail[BLOCK_SIZE];
+        uint32_t* out = positions.reserve(BLOCK_SIZE);
+        uint32_t* limit = positions.limit();
+
+        for (size_t base = 0; base < text.size(); base += BLOCK_SIZE) {
+            const char* block = text.data() + base;
+            if (text.size() - base < BLOCK_SIZE) {
+                // The last block is padded with spaces, which change nothing.
+                std::memset(tail, ' ', BLOCK_SIZE);
+                std::memcpy(tail, block, text.size() - base);
+                block = tail;
+            }
+            BlockMasks masks = classify(block);
+
+            // A backslash escapes the byte after it unless it is escaped
+            // itself; backslashes are rare enough to walk one by one.
+            uint64_t escaped = escapedCarry;
+            uint64_t backslashes = masks.backslash & ~escapedCarry;
+            escapedCarry = 0;
+            while (backslashes) {
+                int bit = lowestBit(backslashes);
+                if (bit == 63) {
+                    escapedCarry = 1;
+                    break;
+                }
+                uint64_t next = uint64_t(1) << (bit + 1);
+                escaped |= next;
+                backslashes &= ~(next | (next >> 1));
+            }
+
+            // Opening quotes and the bytes after them are inside strings;
+            // closing quotes are not.
+            uint64_t quotes = masks.quote & ~escaped;
+            uint64_t inString = prefixXor(quotes) ^ inStringCarry;
+            inStringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+            if (masks.control & inString) {
+                fail(base + lowestBit(masks.control & inString), line, "control character in string");
+            }
+
+            uint64_t scalar = ~(masks.structural | masks.space | quotes | inString);
+            uint64_t scalarStarts = scalar & ~((scalar << 1) | scalarCarry);
+            scalarCarry = scalar >> 63;
+
+            uint64_t tokens = (masks.structural & ~inString) | quotes | scalarStarts;
+            if (limit - out < static_cast<std::ptrdiff_t>(BLOCK_SIZE)) {
+                positions.setEnd(out);
+                out = positions.reserve(BLOCK_SIZE);
+                limit = positions.limit();
+            }
+            while (tokens) {
+                *out++ = static_cast<uint32_t>(base + lowestBit(tokens));
+                tokens &= tokens - 1;
+            }
+        }
+        positions.setEnd(out);
+
+        if (inStringCarry) {
+            fail(text.size(), line, "unterminated string");
+        }
+    }
+
+    void appendUtf8(String& out, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    // Stage two: builds values by walking the index. Nothing here can
+    // trigger a collection, so values under construction need no roots.
+    class Parser {
+    public:
+        Parser(std::string_view json, size_t lineNumber, const TokenIndex& index)
+            : text(json), line(lineNumber), positions(index), next(0) {}
+
+        Value parseDocument() {
+            if (positions.size() == 0) {
+                fail(text.size(), line, "no value");
+            }
+            Value value = parseValue(0);
+            if (next != positions.size()) {
+                fail(positions[next], line, "unexpected text after the value");
+            }
+            return value;
+        }
+
+    private:
+        std::string_view text;
+        size_t line;
+        const TokenIndex& positions;
+        size_t next;
+        Vec<Value> elements;
+
+        size_t take() {
+            if (next == positions.size()) {
+                fail(text.size(), line, "unexpected end of text");
+            }
+            return positions[next++];
+        }
+
+        bool endsToken(size_t offset) const {
+            return offset == text.size() || isStructural(text[offset]) || isSpace(text[offset]);
+        }
+
+        Value parseValue(size_t depth) {
+            size_t at = take();
+            switch (text[at]) {
+            case '{':
+                return parseObject(depth + 1, at);
+            case '[':
+                return parseArray(depth + 1, at);
+            case '"':
+                return Value::makeString(parseString(at));
+            case 't':
+                expectLiteral(at, "true");
+                return Value::makeBool(true);
+            case 'f':
+                expectLiteral(at, "false");
+                return Value::makeBool(false);
+            case 'n':
+                expectLiteral(at, "null");
+                return Value::makeNil();
+            default:
+                return parseNumber(at);
+            }
+        }
+
+        Value parseObject(size_t depth, size_t at) {
+            if (depth > Json::MAX_DEPTH) {
+                fail(at, line, "nested too deeply");
+            }
+
+            Value object = Value::makeStruct(Json::OBJECT_TYPE);
+            Map<String, Value>& fields = object.asStruct()->fields;
+
+            size_t token = take();
+            if (text[token] == '}') {
+                return object;
+            }
+
+            while (true) {
+                if (text[token] != '"') {
+                    fail(token, line, "expected a string key");
+                }
+                String key = parseString(token);
+
+                token = take();
+                if (text[token] != ':') {
+                    fail(token, line, "expected ':'");
+                }
+                fields.insert_or_assign(std::move(key), parseValue(depth));
+
+                token = take();
+                if (text[token] == '}') {
+                    return object;
+                }
+                if (text[token] != ',') {
+                    fail(token, line, "expected ',' or '}'");
+                }
+                token = take();
+            }
+        }
+
+        // Elements collect on a stack shared by all nesting levels until
+        // the array's length is known.
+        Value parseArray(size_t depth, size_t at) {
+            if (depth > Json::MAX_DEPTH) {
+                fail(at, line, "nested too deeply");
+            }
+
+            if (next < positions.size() && text[positions[next]] == ']') {
+                next++;
+                return Value::makeArray(0);
+            }
+
+            size_t first = elements.size();
+            while (true) {
+                elements.push_back(parseValue(depth));
+
+                size_t token = take();
+                if (text[token] == ']') {
+                    break;
+                }
+                if (text[token] != ',') {
+                    fail(token, line, "expected ',' or ']'");
+                }
+            }
+
+            Value array = Value::makeArray(elements.size() - first);
+            std::move(elements.begin() + static_cast<std::ptrdiff_t>(first), elements.end(),
+                array.asArray()->elements.begin());
+            elements.resize(first);
+            return array;
+        }
+
+        // The index holds the closing quote right after the opening one.
+        String parseString(size_t at) {
+            size_t close = take();
+            std::string_view body = text.substr(at + 1, close - at - 1);
+            if (!std::memchr(body.data(), '\\', body.size())) {
+                return String(body);
+            }
+
+            String out;
+            out.reserve(body.size());
+            size_t i = 0;
+            while (i < body.size()) {
+                const void* found = std::memchr(body.data() + i, '\\', body.size() - i);
+                size_t escape = found ? static_cast<size_t>(static_cast<const char*>(found) - body.data()) : body.size();
+                out.append(body.data() + i, escape - i);
+                if (escape == body.size()) {
+                    break;
+                }
+
+                size_t offset = at + 1 + escape;
+                char kind = body[escape + 1];
+                i = escape + 2;
+                switch (kind) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t codePoint = parseHex(body, i, offset);
+                    i += 4;
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                        if (i + 1 >= body.size() || body[i] != '\\' || body[i + 1] != 'u') {
+                            fail(offset, line, "unpaired surrogate in \\u escape");
+                        }
+                        uint32_t low = parseHex(body, i + 2, offset);
+                        if (low < 0xDC00 || low >= 0xE000) {
+                            fail(offset, line, "unpaired surrogate in \\u escape");
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                    else if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+                        fail(offset, line, "unpaired surrogate in \\u escape");
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    fail(offset, line, "invalid escape");
+                }
+            }
+            return out;
+        }
+
+        uint32_t parseHex(std::string_view body, size_t from, size_t offset) const {
+            uint32_t value;
+            if (from + 4 > body.size()) {
+                fail(offset, line, "invalid \\u escape");
+            }
+            auto result = std::from_chars(body.data() + from, body.data() + from + 4, value, 16);
+            if (result.ec != std::errc() || result.ptr != body.data() + from + 4) {
+                fail(offset, line, "invalid \\u escape");
+            }
+            return value;
+        }
+
+        void expectLiteral(size_t at, std::string_view literal) const {
+            if (text.compare(at, literal.size(), literal) != 0 || !endsToken(at + literal.size())) {
+                fail(at, line, "unexpected character");
+            }
+        }
+
+        // Checks the JSON number grammar, which is stricter than
+        // from_chars, then converts: to an int when there is no fraction
+        // or exponent and it fits, otherwise to a float.
+        Value parseNumber(size_t at) const {
+            size_t end = at;
+            auto digits = [&]() {
+                size_t start = end;
+                while (end < text.size() && text[end] >= '0' && text[end] <= '9') {
+                    end++;
+                }
+                return end > start;
+            };
+
+            if (end < text.size() && text[end] == '-') {
+                end++;
+            }
+            if (end < text.size() && text[end] == '0') {
+                end++;
+            }
+            else if (!digits()) {
+                fail(at, line, "unexpected character");
+            }
+
+            bool integral = true;
+            if (end < text.size() && text[end] == '.') {
+                integral = false;
+                end++;
+                if (!digits()) {
+                    fail(at, line, "invalid number");
+                }
+            }
+            if (end < text.size() && (text[end] == 'e' || text[end] == 'E')) {
+                integral = false;
+                end++;
+                if (end < text.size() && (text[end] == '+' || text[end] == '-')) {
+                    end++;
+                }
+                if (!digits()) {
+                    fail(at, line, "invalid number");
+                }
+            }
+            if (!endsToken(end)) {
+                fail(at, line, "invalid number");
+            }
+
+            const char* first = text.data() + at;
+            const char* last = text.data() + end;
+            if (integral) {
+                int64_t number;
+                if (std::from_chars(first, last, number).ec == std::errc()) {
+                    return Value::makeInt(number);
+                }
+            }
+
+            double number;
+            if (std::from_chars(first, last, number).ec != std::errc()) {
+                fail(at, line, "number out of range");
+            }
+            return Value::makeFloat(number);
+        }
+    };
+
+    // The first byte from p on that a JSON string must escape, or end.
+    const char* findEscape(const char* p, const char* end) {
+#ifdef JSON_USE_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lastControl = _mm_set1_epi8(0x1F);
+
+        while (end - p >= 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+                _mm_cmpeq_epi8(_mm_max_epu8(bytes, lastControl), lastControl));
+            int mask = _mm_movemask_epi8(hits);
+            if (mask != 0) {
+                return p + lowestBit(static_cast<uint64_t>(mask));
+            }
+            p += 16;
+        }
+#endif
+        while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) {
+            ++p;
+        }
+        return p;
+    }
+
+    void writeString(String& out, std::string_view text) {
+        static const char HEX[] = "0123456789abcdef";
+
+        out += '"';
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* stop = findEscape(p, end);
+            out.append(p, static_cast<size_t>(stop - p));
+            if (stop == end) {
+                break;
+            }
+
+            unsigned char c = static_cast<unsigned char>(*stop);
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += HEX[c >> 4];
+                out += HEX[c & 0xF];
+            }
+            p = stop + 1;
+        }
+        out += '"';
+    }
+
+    void writeIndent(String& out, int indent, size_t depth) {
+        if (indent > 0) {
+            out += '\n';
+            out.append(static_cast<size_t>(indent) * depth, ' ');
+        }
+    }
+
+    void writeValue(String& out, const Value& value, int indent, size_t depth) {
+        if (depth > Json::MAX_DEPTH) {
+            throw RuntimeError("Value is nested too deeply for JSON, or contains itself");
+        }
+
+        char digits[32];
+        switch (value.type) {
+        case ValueType::INTEGER: {
+            auto result = std::to_chars(digits, digits + sizeof(digits), value.asInt());
+            out.append(digits, result.ptr);
+            break;
+        }
+        case ValueType::FLOAT: {
+            double number = value.asFloat();
+            if (!std::isfinite(number)) {
+                out += "null";
+                break;
+            }
+            auto result = std::to_chars(digits, digits + sizeof(digits), number);
+            out.append(digits, result.ptr);
+            // Keeps the value a float when it is parsed back.
+            if (std::string_view(digits, static_cast<size_t>(result.ptr - digits)).find_first_of(".e") == std::string_view::npos) {
+                out += ".0";
+            }
+            break;
+        }
+        case ValueType::STRING:
+            writeString(out, value.asStringView());
+            break;
+        case ValueType::BOOLEAN:
+            out += value.asBool() ? "true" : "false";
+            break;
+        case ValueType::NIL:
+            out += "null";
+            break;
+        case ValueType::ARRAY: {
+            const Vec<Value>& elements = value.asArray()->elements;
+            out += '[';
+            for (size_t i = 0; i < elements.size(); ++i) {
+                if (i > 0) out += ',';
+                writeIndent(out, indent, depth + 1);
+                writeValue(out, elements[i], indent, depth + 1);
+            }
+            if (!elements.empty()) writeIndent(out, indent, depth);
+            out += ']';
+            break;
+        }
+        case ValueType::STRUCT_INSTANCE: {
+            const Map<String, Value>& fields = value.asStruct()->fields;
+            out += '{';
+            bool first = true;
+            for (auto& field : fields) {
+                if (!first) out += ',';
+                first = false;
+                writeIndent(out, indent, depth + 1);
+                writeString(out, field.first);
+                out += indent > 0 ? ": " : ":";
+                writeValue(out, field.second, indent, depth + 1);
+            }
+            if (!fields.empty()) writeIndent(out, indent, depth);
+            out += '}';
+            break;
+        }
+        default:
+            throw TypeError("Cannot convert a " + value.getTypeName() + " to JSON");
+        }
+    }
+}
+
+namespace Json {
+    Value parse(std::string_view text, size_t line) {
+        // Reused, like the output buffer: a fresh index for every line of
+        // an NDJSON file would spend more time allocating than parsing.
+        thread_local TokenIndex positions;
+
+        positions.clear();
+        // Typical JSON has a token every four bytes or so.
+        positions.reserve(text.size() / 4 + BLOCK_SIZE);
+        buildIndex(text, line, positions);
+        Value value = Parser(text, line, positions).parseDocument();
+
+        if (positions.bytes() > MAX_KEPT_BUFFER) {
+            positions.release();
+        }
+        return value;
+    }
+
+    String stringify(const Value& value, int indent) {
+        thread_local String buffer;
+
+        buffer.clear();
+        writeValue(buffer, value, indent, 0);
+
+        String result(buffer);
+        if (buffer.capacity() > MAX_KEPT_BUFFER) {
+            String().swap(buffer);
+        }
+        return result;
+    }
+}
+
+bool NdjsonReader::atEnd() {
+    std::string_view text;
+    while (lines->peekLine(text)) {
+        size_t start = 0;
+        while (start < text.size() && isSpace(text[start])) {
+            start++;
+        }
+        if (start < text.size()) {
+            return false;
+        }
+
+        lines->nextLine(text);
+        lineNumber++;
+    }
+    return true;
+}
+
+bool NdjsonReader::next(Value& value) {
+    std::string_view text;
+    while (lines->nextLine(text)) {
+        lineNumber++;
+        size_t start = 0;
+        while (start < text.size() && isSpace(text[start])) {
+            start++;
+        }
+        if (start == text.size()) {
+            continue;
+        }
+
+        value = Json::parse(text, lineNumber);
+        return true;
+    }
+    return false;
+}
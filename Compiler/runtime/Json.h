@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../Common.h"
+#include "LineReader.h"
+#include <string_view>
+
+// JSON for json.parse() and json.stringify(). Objects are struct instances
+// of type "object", arrays are arrays, and null is nil; integers without a
+// fraction or exponent stay ints when they fit in 64 bits.
+//
+// Parsing is done in two passes, as simdjson does. The first classifies
+// the text 64 bytes at a time with SSE2 (byte by byte elsewhere): it finds
+// the quotes that are not escaped, works out from them which bytes are
+// inside strings, and records the offset of every structural character,
+// quote and start of a number or literal outside strings. The second walks
+// that index to build the values, so it never looks at whitespace or at
+// the inside of a string except to copy it.
+//
+// Stringification writes into a buffer kept per thread, so repeated calls
+// reuse its memory, and copies the finished text out once.
+namespace Json {
+    // Containers may nest this deep, in both directions.
+    constexpr size_t MAX_DEPTH = 1024;
+
+    // Errors give the byte offset of the problem, and the line number too
+    // when line is set (for NDJSON).
+    Value parse(std::string_view text, size_t line = 0);
+
+    // With indent > 0, members go on their own lines, indented that many
+    // spaces per level.
+    String stringify(const Value& value, int indent);
+
+    // The type name of parsed objects.
+    constexpr const char* OBJECT_TYPE = "object";
+}
+
+// Reads newline-delimited JSON for json.lines(): one value per line,
+// skipping blank lines. Errors name the line they are on.
+class NdjsonReader {
+public:
+    explicit NdjsonReader(Ptr<LineReader> reader) : lines(std::move(reader)), lineNumber(0) {}
+
+    // False after the last line or close().
+    bool next(Value& value);
+    // True once only blank lines, if anything, remain.
+    bool atEnd();
+    void close() { lines->discard(); }
+
+private:
+    Ptr<LineReader> lines;
+    size_t lineNumber;
+};
@@ -0,0 +1,211 @@
+#include "LineReader.h"
+#include "../utils/Error.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    int openForReading(const String& path) {
+        return _open(path.c_str(), _O_RDONLY | _O_BINARY | _O_SEQUENTIAL);
+    }
+
+    long readFile(int fd, char* data, size_t capacity) {
+        return _read(fd, data, static_cast<unsigned int>(std::min<size_t>(capacity, INT_MAX)));
+    }
+
+    void closeFile(int fd) {
+        _close(fd);
+    }
+
+    size_t remainingBytes(int fd) {
+        struct _stat64 info;
+        if (_fstat64(fd, &info) != 0 || !(info.st_mode & _S_IFREG)) {
+            return 0;
+        }
+        __int64 position = _telli64(fd);
+        return position >= 0 && position < info.st_size ? static_cast<size_t>(info.st_size - position) : 0;
+    }
+#else
+    int openForReading(const String& path) {
+        return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    long readFile(int fd, char* data, size_t capacity) {
+        return static_cast<long>(::read(fd, data, std::min<size_t>(capacity, INT_MAX)));
+    }
+
+    void closeFile(int fd) {
+        ::close(fd);
+    }
+
+    size_t remainingBytes(int fd) {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            return 0;
+        }
+        off_t position = lseek(fd, 0, SEEK_CUR);
+        return position >= 0 && position < info.st_size ? static_cast<size_t>(info.st_size - position) : 0;
+    }
+#endif
+}
+
+Ptr<LineReader> LineReader::open(const String& path) {
+    int fd = openForReading(path);
+    if (fd < 0) {
+        throw RuntimeError("Failed to open file: " + path);
+    }
+    return MAKE_PTR(LineReader, fd, true);
+}
+
+const Ptr<LineReader>& LineReader::standardInput() {
+    static const Ptr<LineReader> input = [] {
+        Ptr<LineReader> reader = MAKE_PTR(LineReader, 0, false);
+        reader->flushesOutput = true;
+        return reader;
+    }();
+    return input;
+}
+
+LineReader::LineReader(int input, bool owns)
+    : fd(input), owned(owns), flushesOutput(false), buffer(BUFFER_SIZE), begin(0), end(0) {}
+
+LineReader::~LineReader() {
+    close();
+}
+
+void LineReader::close() {
+    if (fd >= 0) {
+        if (owned) {
+            closeFile(fd);
+        }
+        fd = -1;
+    }
+}
+
+void LineReader::discard() {
+    close();
+    begin = end = 0;
+}
+
+bool LineReader::nextLine(std::string_view& line) {
+    size_t scanned = begin;
+
+    while (true) {
+        const char* data = buffer.data();
+        const void* newline = std::memchr(data + scanned, '\n', end - scanned);
+
+        if (newline) {
+            size_t stop = static_cast<size_t>(static_cast<const char*>(newline) - data);
+            size_t length = stop - begin;
+            if (length > 0 && data[stop - 1] == '\r') {
+                length--;
+            }
+            line = std::string_view(data + begin, length);
+            begin = stop + 1;
+            return true;
+        }
+
+        scanned = end;
+        size_t consumed = begin;
+        if (!fill()) {
+            if (begin == end) {
+                return false;
+            }
+            line = std::string_view(buffer.data() + begin, end - begin);
+            begin = end;
+            return true;
+        }
+        scanned -= consumed;
+    }
+}
+
+// The line is a view into the buffer, so it starts where reading resumes.
+bool LineReader::peekLine(std::string_view& line) {
+    if (!nextLine(line)) {
+        return false;
+    }
+    begin = static_cast<size_t>(line.data() - buffer.data());
+    return true;
+}
+
+bool LineReader::atEnd() {
+    std::string_view line;
+    return !peekLine(line);
+}
+
+// The rest is read through the line buffer and appended, rather than read
+// into the string directly: growing the string would zero each new block
+// before the read fills it, and a pipe may fill only a little of it. The
+// size of a regular file is known, so the string is allocated once.
+void LineReader::readRest(String& text) {
+    if (fd >= 0) {
+        text.reserve(text.size() + (end - begin) + remainingBytes(fd));
+    }
+    text.append(buffer.data() + begin, end - begin);
+    begin = end = 0;
+
+    while (fd >= 0) {
+        size_t read = readSome(buffer.data(), buffer.size());
+        if (read == 0) {
+            close();
+            break;
+        }
+        text.append(buffer.data(), read);
+    }
+}
+
+// Moves the unread tail to the front and reads more after it, growing the
+// buffer only when the tail already fills it. False at the end of the file.
+bool LineReader::fill() {
+    if (fd < 0) {
+        return false;
+    }
+
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (end == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    size_t read = readSome(buffer.data() + end, buffer.size() - end);
+    if (read == 0) {
+        close();
+        return false;
+    }
+
+    end += read;
+    return true;
+}
+
+size_t LineReader::readSome(char* data, size_t capacity) {
+    if (flushesOutput) {
+        std::cout.flush();
+    }
+
+    while (true) {
+        long read = readFile(fd, data, capacity);
+        if (read >= 0) {
+            return static_cast<size_t>(read);
+        }
+        if (errno != EINTR) {
+            close();
+            throw RuntimeError("Failed to read file");
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../Common.h"
+#include <string_view>
+
+// Reads a file line by line through one buffer that is reused for the
+// whole file, so memory stays the same however large the file is. The
+// buffer is filled with read(2) straight from the descriptor, a megabyte
+// at a time, with no stdio or iostream buffer in between. Lines are found
+// with memchr over the buffered bytes and returned as views into the
+// buffer, valid until the next call; only a line longer than the buffer
+// makes it grow. "\n" and "\r\n" both end a line, and a last line without
+// a newline is still returned. The file is closed as soon as the end is
+// reached.
+class LineReader {
+public:
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+
+    static Ptr<LineReader> open(const String& path);
+
+    // The process's stdin, shared by console.readLine(), console.readAll()
+    // and console.lines() so that they can be mixed. Like std::cin, it
+    // flushes std::cout before every read, so a prompt shows before the
+    // script waits for input. Reaching the end or closing it does not
+    // close the descriptor.
+    static const Ptr<LineReader>& standardInput();
+
+    // Takes ownership of fd when owned is set.
+    LineReader(int fd, bool owned);
+    ~LineReader();
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    bool nextLine(std::string_view& line);
+    // Like nextLine(), but the line is handed out again by the next call.
+    bool peekLine(std::string_view& line);
+    // True once no line is left. Like the reads, it waits for input on a
+    // pipe or terminal until a line or the end arrives.
+    bool atEnd();
+    // Appends everything not yet read, buffered or not, and leaves the
+    // reader at the end.
+    void readRest(String& text);
+    // close() still hands out the lines already buffered; discard() drops
+    // them too, so the next nextLine() is false.
+    void close();
+    void discard();
+    bool isClosed() const { return fd < 0; }
+
+private:
+    int fd;
+    bool owned;
+    bool flushesOutput;
+    Vec<char> buffer;
+    size_t begin;
+    size_t end;
+
+    bool fill();
+    // One read(2) into [data, data + capacity), retried if interrupted;
+    // 0 at the end of the file.
+    size_t readSome(char* data, size_t capacity);
+};
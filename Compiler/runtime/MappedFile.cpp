@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+#include "../utils/Error.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+Ptr<MappedFile> MappedFile::open(const String& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw RuntimeError("Failed to open file: " + path);
+    }
+
+    Ptr<MappedFile> mapped(new MappedFile());
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw RuntimeError("Failed to read file size: " + path);
+    }
+
+    // Empty files cannot be mapped; they are just an empty string.
+    if (size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (!view) {
+            CloseHandle(file);
+            throw RuntimeError("Failed to map file: " + path);
+        }
+        mapped->bytes = static_cast<const char*>(view);
+        mapped->length = static_cast<size_t>(size.QuadPart);
+    }
+
+    CloseHandle(file);
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+    if (bytes) {
+        UnmapViewOfFile(bytes);
+    }
+}
+
+#else
+
+Ptr<MappedFile> MappedFile::open(const String& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw RuntimeError("Failed to open file: " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        throw RuntimeError("Not a regular file: " + path);
+    }
+
+    Ptr<MappedFile> mapped(new MappedFile());
+
+    // Empty files cannot be mapped; they are just an empty string.
+    if (info.st_size > 0) {
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            throw RuntimeError("Failed to map file: " + path);
+        }
+        madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+        mapped->bytes = static_cast<const char*>(view);
+        mapped->length = static_cast<size_t>(info.st_size);
+    }
+
+    // The mapping keeps the file's pages reachable without the descriptor.
+    ::close(fd);
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+    if (bytes) {
+        munmap(const_cast<char*>(bytes), length);
+    }
+}
+
+#endif
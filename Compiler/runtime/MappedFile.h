@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../Common.h"
+#include <string_view>
+
+// A whole file mapped read-only into memory. The bytes are paged in from
+// the page cache on first touch and never copied; the mapping is released
+// when the last reference goes away. Strings returned by file.map() hold
+// one, so a multi-gigabyte input costs address space rather than heap.
+//
+// The mapping reflects the file as it is on disk: if another process
+// changes or truncates the file while it is mapped, the string changes
+// with it (or touching the lost pages faults). Use file.read() for files
+// that may change.
+class MappedFile {
+public:
+    static Ptr<MappedFile> open(const String& path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(bytes, length); }
+
+private:
+    MappedFile() : bytes(nullptr), length(0) {}
+
+    const char* bytes;
+    size_t length;
+};
@@ -0,0 +1,181 @@
+#include "Operators.h"
+
+namespace {
+    constexpr size_t TYPE_COUNT = static_cast<size_t>(ValueType::COUNT);
+    constexpr size_t OP_COUNT = static_cast<size_t>(BinaryOp::COUNT);
+
+    template<ValueType T>
+    inline double numeric(const Value& value) {
+        if constexpr (T == ValueType::INTEGER) {
+            return static_cast<double>(value.intValue);
+        }
+        else {
+            return value.floatValue;
+        }
+    }
+
+    template<BinaryOp Op>
+    struct IntKernel {
+        static Value apply(const Value& l, const Value& r) {
+            int64_t result = Operators::applyInt(Op, l.intValue, r.intValue);
+            if constexpr (Operators::isComparison(Op)) {
+                return Value::makeBool(result != 0);
+            }
+            else {
+                return Value::makeInt(result);
+            }
+        }
+    };
+
+    // Float kernels are instantiated per operand type pair so mixed int/float
+    // promotion costs a single conversion and no runtime type test.
+    template<ValueType L, ValueType R>
+    struct FloatKernel {
+        template<BinaryOp Op>
+        struct Of {
+            static Value apply(const Value& l, const Value& r) {
+                if constexpr (Operators::isComparison(Op)) {
+                    return Value::makeBool(Operators::compareFloat(Op, numeric<L>(l), numeric<R>(r)));
+                }
+                else {
+                    return Value::makeFloat(Operators::applyFloat(Op, numeric<L>(l), numeric<R>(r)));
+                }
+            }
+        };
+    };
+
+    template<BinaryOp Op>
+    struct StringKernel {
+        static Value apply(const Value& l, const Value& r) {
+            std::string_view a = l.asStringView();
+            std::string_view b = r.asStringView();
+
+            if constexpr (Op == BinaryOp::ADD) {
+                String result;
+                result.reserve(a.size() + b.size());
+                result += a;
+                result += b;
+                return Value::makeString(std::move(result));
+            }
+            else if constexpr (Op == BinaryOp::EQUAL) {
+                return Value::makeBool(a == b);
+            }
+            else if constexpr (Op == BinaryOp::NOT_EQUAL) {
+                return Value::makeBool(a != b);
+            }
+            else {
+                int order = a.compare(b);
+                if constexpr (Op == BinaryOp::LESS) return Value::makeBool(order < 0);
+                if constexpr (Op == BinaryOp::LESS_EQUAL) return Value::makeBool(order <= 0);
+                if constexpr (Op == BinaryOp::GREATER) return Value::makeBool(order > 0);
+                return Value::makeBool(order >= 0);
+            }
+        }
+    };
+
+    template<BinaryOp Op>
+    struct BoolKernel {
+        static Value apply(const Value& l, const Value& r) {
+            bool equal = l.boolValue == r.boolValue;
+            return Value::makeBool(Op == BinaryOp::EQUAL ? equal : !equal);
+        }
+    };
+
+    template<BinaryOp Op>
+    struct NilKernel {
+        static Value apply(const Value& /*l*/, const Value& /*r*/) {
+            return Value::makeBool(Op == BinaryOp::EQUAL);
+        }
+    };
+
+    class KernelTable {
+    public:
+        KernelTable() : kernels{} {
+            const ValueType INT = ValueType::INTEGER;
+            const ValueType FLOAT = ValueType::FLOAT;
+
+            addArithmetic<IntKernel>(INT, INT);
+            addComparisons<IntKernel>(INT, INT);
+
+            addArithmetic<FloatKernel<ValueType::FLOAT, ValueType::FLOAT>::Of>(FLOAT, FLOAT);
+            addComparisons<FloatKernel<ValueType::FLOAT, ValueType::FLOAT>::Of>(FLOAT, FLOAT);
+            addArithmetic<FloatKernel<ValueType::INTEGER, ValueType::FLOAT>::Of>(INT, FLOAT);
+            addComparisons<FloatKernel<ValueType::INTEGER, ValueType::FLOAT>::Of>(INT, FLOAT);
+            addArithmetic<FloatKernel<ValueType::FLOAT, ValueType::INTEGER>::Of>(FLOAT, INT);
+            addComparisons<FloatKernel<ValueType::FLOAT, ValueType::INTEGER>::Of>(FLOAT, INT);
+
+            add(ValueType::STRING, ValueType::STRING, BinaryOp::ADD, &StringKernel<BinaryOp::ADD>::apply);
+            addComparisons<StringKernel>(ValueType::STRING, ValueType::STRING);
+
+            addEquality<BoolKernel>(ValueType::BOOLEAN, ValueType::BOOLEAN);
+            addEquality<NilKernel>(ValueType::NIL, ValueType::NIL);
+        }
+
+        BinaryKernel get(ValueType left, ValueType right, BinaryOp op) const {
+            return kernels[static_cast<size_t>(left)][static_cast<size_t>(right)][static_cast<size_t>(op)];
+        }
+
+    private:
+        BinaryKernel kernels[TYPE_COUNT][TYPE_COUNT][OP_COUNT];
+
+        void add(ValueType left, ValueType right, BinaryOp op, BinaryKernel kernel) {
+            kernels[static_cast<size_t>(left)][static_cast<size_t>(right)][static_cast<size_t>(op)] = kernel;
+        }
+
+        template<template<BinaryOp> class K>
+        void addArithmetic(ValueType left, ValueType right) {
+            add(left, right, BinaryOp::ADD, &K<BinaryOp::ADD>::apply);
+            add(left, right, BinaryOp::SUB, &K<BinaryOp::SUB>::apply);
+            add(left, right, BinaryOp::MUL, &K<BinaryOp::MUL>::apply);
+            add(left, right, BinaryOp::DIV, &K<BinaryOp::DIV>::apply);
+            add(left, right, BinaryOp::MOD, &K<BinaryOp::MOD>::apply);
+        }
+
+        template<template<BinaryOp> class K>
+        void addEquality(ValueType left, ValueType right) {
+            add(left, right, BinaryOp::EQUAL, &K<BinaryOp::EQUAL>::apply);
+            add(left, right, BinaryOp::NOT_EQUAL, &K<BinaryOp::NOT_EQUAL>::apply);
+        }
+
+        template<template<BinaryOp> class K>
+        void addComparisons(ValueType left, ValueType right) {
+            add(left, right, BinaryOp::LESS, &K<BinaryOp::LESS>::apply);
+            add(left, right, BinaryOp::LESS_EQUAL, &K<BinaryOp::LESS_EQUAL>::apply);
+            add(left, right, BinaryOp::GREATER, &K<BinaryOp::GREATER>::apply);
+            add(left, right, BinaryOp::GREATER_EQUAL, &K<BinaryOp::GREATER_EQUAL>::apply);
+            addEquality<K>(left, right);
+        }
+    };
+
+    const KernelTable kernelTable;
+}
+
+BinaryKernel Operators::lookup(ValueType left, ValueType right, BinaryOp op) {
+    if (op >= BinaryOp::COUNT) {
+        return nullptr;
+    }
+    return kernelTable.get(left, right, op);
+}
+
+void Operators::throwOverflow(BinaryOp op) {
+    throw IntegerOverflowError("Integer overflow in '" + symbol(op) + "'");
+}
+
+String Operators::symbol(BinaryOp op) {
+    switch (op) {
+    case BinaryOp::ADD: return "+";
+    case BinaryOp::SUB: return "-";
+    case BinaryOp::MUL: return "*";
+    case BinaryOp::DIV: return "/";
+    case BinaryOp::MOD: return "%";
+    case BinaryOp::LESS: return "<";
+    case BinaryOp::LESS_EQUAL: return "<=";
+    case BinaryOp::GREATER: return ">";
+    case BinaryOp::GREATER_EQUAL: return ">=";
+    case BinaryOp::EQUAL: return "==";
+    case BinaryOp::NOT_EQUAL: return "!=";
+    case BinaryOp::AND: return "&&";
+    case BinaryOp::OR: return "||";
+    default: return "?";
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../Common.h"
+#include "../parser/AST.h"
+#include "../utils/Error.h"
+#include "../utils/CheckedMath.h"
+#include "Value.h"
+#include <cmath>
+
+using BinaryKernel = Value(*)(const Value& left, const Value& right);
+
+// Binary operators are dispatched through a (left type x right type x op)
+// table of kernels. The scalar helpers below are shared by the kernels and
+// by the interpreter's unboxed int/float fast paths so both agree exactly.
+namespace Operators {
+    BinaryKernel lookup(ValueType left, ValueType right, BinaryOp op);
+    String symbol(BinaryOp op);
+
+    constexpr bool isArithmetic(BinaryOp op) {
+        return op <= BinaryOp::MOD;
+    }
+
+    constexpr bool isComparison(BinaryOp op) {
+        return op >= BinaryOp::LESS && op <= BinaryOp::NOT_EQUAL;
+    }
+
+    constexpr bool isLogical(BinaryOp op) {
+        return op == BinaryOp::AND || op == BinaryOp::OR;
+    }
+
+    [[noreturn]] void throwOverflow(BinaryOp op);
+
+    // Comparisons yield 0 or 1 so int conditions never have to box a bool.
+    inline int64_t applyInt(BinaryOp op, int64_t l, int64_t r) {
+        int64_t result;
+        switch (op) {
+        case BinaryOp::ADD:
+            if (CheckedMath::addOverflow(l, r, result)) throwOverflow(op);
+            return result;
+        case BinaryOp::SUB:
+            if (CheckedMath::subOverflow(l, r, result)) throwOverflow(op);
+            return result;
+        case BinaryOp::MUL:
+            if (CheckedMath::mulOverflow(l, r, result)) throwOverflow(op);
+            return result;
+        case BinaryOp::DIV:
+            if (r == 0) throw RuntimeError("Division by zero");
+            if (r == -1 && l == INT64_MIN) throwOverflow(op);
+            return l / r;
+        case BinaryOp::MOD:
+            if (r == 0) throw RuntimeError("Modulo by zero");
+            if (r == -1) return 0;
+            return l % r;
+        case BinaryOp::LESS: return l < r;
+        case BinaryOp::LESS_EQUAL: return l <= r;
+        case BinaryOp::GREATER: return l > r;
+        case BinaryOp::GREATER_EQUAL: return l >= r;
+        case BinaryOp::EQUAL: return l == r;
+        case BinaryOp::NOT_EQUAL: return l != r;
+        default:
+            throw RuntimeError("Unknown operator: " + symbol(op));
+        }
+    }
+
+    inline double applyFloat(BinaryOp op, double l, double r) {
+        switch (op) {
+        case BinaryOp::ADD: return l + r;
+        case BinaryOp::SUB: return l - r;
+        case BinaryOp::MUL: return l * r;
+        case BinaryOp::DIV:
+            if (r == 0.0) throw RuntimeError("Division by zero");
+            return l / r;
+        case BinaryOp::MOD:
+            if (r == 0.0) throw RuntimeError("Modulo by zero");
+            return std::fmod(l, r);
+        default:
+            throw RuntimeError("Unknown operator: " + symbol(op));
+        }
+    }
+
+    inline bool compareFloat(BinaryOp op, double l, double r) {
+        switch (op) {
+        case BinaryOp::LESS: return l < r;
+        case BinaryOp::LESS_EQUAL: return l <= r;
+        case BinaryOp::GREATER: return l > r;
+        case BinaryOp::GREATER_EQUAL: return l >= r;
+        case BinaryOp::EQUAL: return l == r;
+        case BinaryOp::NOT_EQUAL: return l != r;
+        default:
+            throw RuntimeError("Unknown operator: " + symbol(op));
+        }
+    }
+}
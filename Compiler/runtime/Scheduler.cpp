@@ -0,0 +1,131 @@
+#include "Scheduler.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace {
+    // A job runs a whole interpreter, deep script recursion included, so it
+    // gets a stack the size of a typical main thread's. Pages are only
+    // committed as they are touched.
+    constexpr size_t JOB_STACK_SIZE = 8 * 1024 * 1024;
+}
+
+thread_local Scheduler::Slot* Scheduler::currentSlot = nullptr;
+
+Scheduler::Slot::Slot() : fiber(JOB_STACK_SIZE) {}
+
+Scheduler::Scheduler(size_t threads, size_t slots, std::chrono::microseconds sliceLength)
+    : threadCount(std::max<size_t>(threads, 1)), slotsPerThread(std::max<size_t>(slots, 1)),
+      slice(sliceLength), slices(0), yields(0) {}
+
+void Scheduler::run(size_t count, const Job& job) {
+    Batch batch;
+    batch.job = &job;
+    batch.count = count;
+    batch.next = 0;
+
+    // The calling thread takes part like the others.
+    size_t threads = std::min(threadCount, std::max<size_t>(count, 1));
+    Vec<std::thread> helpers;
+    for (size_t i = 1; i < threads; ++i) {
+        helpers.emplace_back([this, &batch] { work(batch); });
+    }
+
+    work(batch);
+
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+bool Scheduler::sliceExpired() {
+    return currentSlot && Clock::now() >= currentSlot->sliceEnd;
+}
+
+void Scheduler::yield() {
+    currentSlot->fiber.suspend();
+}
+
+Scheduler::Stats Scheduler::getStats() const {
+    Stats stats;
+    stats.slices = slices.load();
+    stats.yields = yields.load();
+    return stats;
+}
+
+void Scheduler::work(Batch& batch) {
+    std::deque<std::unique_ptr<Slot>> ready;
+    Vec<std::unique_ptr<Slot>> idle;
+
+    while (true) {
+        while (ready.size() < slotsPerThread) {
+            size_t index = batch.next.fetch_add(1);
+            if (index >= batch.count) {
+                break;
+            }
+
+            std::unique_ptr<Slot> slot;
+            if (!idle.empty()) {
+                slot = std::move(idle.back());
+                idle.pop_back();
+            }
+            else {
+                slot = std::make_unique<Slot>();
+            }
+
+            slot->batch = &batch;
+            slot->index = index;
+            slot->finished = false;
+            slot->isolate = nullptr;
+            slot->heap = nullptr;
+            slot->fiber.start(&Scheduler::entry, slot.get());
+            ready.push_back(std::move(slot));
+        }
+
+        if (ready.empty()) {
+            return;
+        }
+
+        std::unique_ptr<Slot> slot = std::move(ready.front());
+        ready.pop_front();
+
+        slot->sliceEnd = Clock::now() + slice;
+        currentSlot = slot.get();
+        Isolate* previousIsolate = Isolate::setCurrent(slot->isolate);
+        Heap* previousHeap = Heap::setCurrent(slot->heap);
+        slot->fiber.resume();
+        slot->isolate = Isolate::setCurrent(previousIsolate);
+        slot->heap = Heap::setCurrent(previousHeap);
+        currentSlot = nullptr;
+        slices++;
+
+        if (slot->finished) {
+            idle.push_back(std::move(slot));
+        }
+        else {
+            yields++;
+            ready.push_back(std::move(slot));
+        }
+    }
+}
+
+void Scheduler::entry(void* data) {
+    Slot* slot = static_cast<Slot*>(data);
+
+    try {
+        (*slot->batch->job)(slot->index);
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(slot->batch->errorMutex);
+        if (!slot->batch->error) {
+            slot->batch->error = std::current_exception();
+        }
+    }
+
+    slot->finished = true;
+}
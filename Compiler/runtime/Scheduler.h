@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../Common.h"
+#include "Fiber.h"
+#include "Heap.h"
+#include "Isolate.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+// Time-slices many independent jobs (whole script runs) over a fixed number
+// of threads. Each job runs on its own fiber; when its slice is used up the
+// interpreter running it calls yield() at its next safe point and the
+// thread moves on to the next job it holds, round robin. A single runaway
+// script therefore delays the others on its thread by one slice per turn
+// instead of holding the thread until it finishes.
+//
+// A job never changes threads once started, since interpreter state and
+// the current isolate are thread-local. The isolate and heap a job made
+// current are put back whenever it resumes. Each thread keeps up to
+// slotsPerThread jobs in flight and takes new ones from a shared counter,
+// so threads that finish early pick up the remaining work.
+class Scheduler {
+public:
+    using Job = std::function<void(size_t index)>;
+
+    struct Stats {
+        size_t slices = 0;
+        size_t yields = 0;
+    };
+
+    Scheduler(size_t threads, size_t slotsPerThread, std::chrono::microseconds slice);
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Runs job(i) for i in [0, count) and returns when all have finished.
+    // Jobs are expected to handle their own errors; the first exception
+    // that escapes one is rethrown here after the rest have run.
+    void run(size_t count, const Job& job);
+
+    // Inside a job, on its own stack or a task fiber it resumed: true once
+    // its slice is over. Only the job's own stack may yield().
+    static bool sliceExpired();
+    static void yield();
+
+    Stats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Batch {
+        const Job* job;
+        size_t count;
+        std::atomic<size_t> next;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    struct Slot {
+        Batch* batch = nullptr;
+        size_t index = 0;
+        bool finished = false;
+        Clock::time_point sliceEnd;
+        Isolate* isolate = nullptr;
+        Heap* heap = nullptr;
+        Fiber fiber;
+
+        Slot();
+    };
+
+    size_t threadCount;
+    size_t slotsPerThread;
+    std::chrono::microseconds slice;
+
+    std::atomic<size_t> slices;
+    std::atomic<size_t> yields;
+
+    static thread_local Slot* currentSlot;
+
+    void work(Batch& batch);
+    static void entry(void* slot);
+};
@@ -0,0 +1,162 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+    std::atomic<size_t> configuredSize{ 0 };
+    thread_local bool inTask = false;
+}
+
+ThreadPool::ThreadPool(size_t participants)
+    : current(nullptr), generation(0), activeWorkers(0), cancelled(false), stopping(false) {
+    participants = std::max<size_t>(participants, 1);
+    queues.resize(participants);
+
+    for (size_t i = 1; i < participants; ++i) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(defaultSize());
+    return pool;
+}
+
+void ThreadPool::setDefaultSize(size_t participants) {
+    configuredSize = participants;
+}
+
+size_t ThreadPool::defaultSize() {
+    size_t size = configuredSize;
+    if (size == 0) {
+        size = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    return size;
+}
+
+bool ThreadPool::insideTask() {
+    return inTask;
+}
+
+void ThreadPool::run(size_t count, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+
+    if (inTask || queues.size() == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i, 0);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> batch(runMutex);
+
+    size_t participants = queues.size();
+    for (size_t p = 0; p < participants; ++p) {
+        std::lock_guard<std::mutex> lock(queues[p].mutex);
+        for (size_t i = p * count / participants; i < (p + 1) * count / participants; ++i) {
+            queues[p].tasks.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &task;
+        cancelled = false;
+        error = nullptr;
+        activeWorkers = threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    inTask = true;
+    drain(0);
+    inTask = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return activeWorkers == 0; });
+    current = nullptr;
+
+    if (error) {
+        std::exception_ptr failure = error;
+        error = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::workerLoop(size_t participant) {
+    inTask = true;
+    size_t seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        drain(participant);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--activeWorkers == 0) {
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::drain(size_t participant) {
+    size_t task;
+    while (takeTask(participant, task)) {
+        if (!cancelled) {
+            try {
+                (*current)(task, participant);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                cancelled = true;
+            }
+        }
+    }
+}
+
+bool ThreadPool::takeTask(size_t participant, size_t& task) {
+    {
+        Queue& own = queues[participant];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue& victim = queues[(participant + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Common.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Fixed-size pool used for data-parallel work. run() splits a batch of
+// tasks across per-participant deques; each participant drains its own
+// deque from the back and, once empty, steals from the front of the others,
+// so uneven tasks still balance. The calling thread is participant 0 and
+// works alongside the pool threads instead of just waiting.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t task, size_t participant)>;
+
+    explicit ThreadPool(size_t participants);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Shared pool sized by setDefaultSize() (the --threads option) or the
+    // hardware concurrency; created on first use.
+    static ThreadPool& shared();
+    static void setDefaultSize(size_t participants);
+    static size_t defaultSize();
+
+    // True on pool threads and on a caller inside run(); nested run() calls
+    // execute inline so a task can never wait on its own pool.
+    static bool insideTask();
+
+    size_t size() const { return queues.size(); }
+
+    // Runs task(i, participant) for i in [0, count) and blocks until all
+    // tasks finish. The first exception thrown cancels remaining tasks and
+    // is rethrown here.
+    void run(size_t count, const Task& task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::deque<Queue> queues;
+    Vec<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::mutex runMutex;
+
+    const Task* current;
+    size_t generation;
+    size_t activeWorkers;
+    std::atomic<bool> cancelled;
+    std::exception_ptr error;
+    bool stopping;
+
+    void workerLoop(size_t participant);
+    void drain(size_t participant);
+    bool takeTask(size_t participant, size_t& task);
+};
@@ -1,21 +1,202 @@
 #include "Value.h"
+#include "Heap.h"
+#include "../utils/StringUtil.h"
+
+Value Value::makeString(String val) {
+    Value v;
+    v.type = ValueType::STRING;
+    v.object = Heap::current().allocateString(std::move(val));
+    return v;
+}
+
+Value Value::makeMappedString(Ptr<MappedFile> file) {
+    std::string_view range = file->view();
+    return makeMappedString(std::move(file), range);
+}
+
+Value Value::makeMappedString(Ptr<MappedFile> file, std::string_view range) {
+    Value v;
+    v.type = ValueType::STRING;
+    v.object = Heap::current().allocateMappedString(std::move(file), range);
+    return v;
+}
+
+Value Value::makeFunction(const String& name) {
+    Value v;
+    v.type = ValueType::FUNCTION;
+    v.object = Heap::current().allocateString(name);
+    return v;
+}
+
+Value Value::makeStruct(const String& typeName) {
+    Value v;
+    v.type = ValueType::STRUCT_INSTANCE;
+    v.object = Heap::current().allocateStruct(typeName);
+    return v;
+}
+
+Value Value::makeTask(TaskObject* task) {
+    Value v;
+    v.type = ValueType::TASK;
+    v.object = task;
+    return v;
+}
+
+Value Value::makeChannel(Ptr<Channel> channel) {
+    Value v;
+    v.type = ValueType::CHANNEL;
+    v.object = Heap::current().allocateChannel(std::move(channel));
+    return v;
+}
+
+Value Value::makeArray(size_t size) {
+    Value v;
+    v.type = ValueType::ARRAY;
+    v.object = Heap::current().allocateArray(size);
+    return v;
+}
+
+Value Value::makeReader(Ptr<LineReader> reader) {
+    Value v;
+    v.type = ValueType::READER;
+    v.object = Heap::current().allocateReader(std::move(reader));
+    return v;
+}
+
+Value Value::makeWriter(Ptr<FileWriter> writer) {
+    Value v;
+    v.type = ValueType::WRITER;
+    v.object = Heap::current().allocateWriter(std::move(writer));
+    return v;
+}
+
+Value Value::makeBytes(size_t length, bool zeroed) {
+    Value v;
+    v.type = ValueType::BYTES;
+    v.object = Heap::current().allocateBytes(length, zeroed);
+    return v;
+}
+
+Value Value::makeBytesSlice(const Value& source, size_t offset, size_t length) {
+    Value v;
+    v.type = ValueType::BYTES;
+    v.object = Heap::current().allocateBytesSlice(*source.asBytes(), offset, length);
+    return v;
+}
+
+Value Value::makeCsvReader(Ptr<CsvReader> reader) {
+    Value v;
+    v.type = ValueType::CSV_READER;
+    v.object = Heap::current().allocateCsvReader(std::move(reader));
+    return v;
+}
+
+Value Value::makeNdjsonReader(Ptr<NdjsonReader> reader) {
+    Value v;
+    v.type = ValueType::NDJSON_READER;
+    v.object = Heap::current().allocateNdjsonReader(std::move(reader));
+    return v;
+}
+
+Value Value::makeDirectoryWalker(Ptr<DirectoryWalker> walker) {
+    Value v;
+    v.type = ValueType::DIR_WALKER;
+    v.object = Heap::current().allocateDirectoryWalker(std::move(walker));
+    return v;
+}
+
+const String& Value::asString() const {
+    return static_cast<StringObject*>(object)->str();
+}
+
+std::string_view Value::asStringView() const {
+    return static_cast<StringObject*>(object)->view();
+}
+
+const String& Value::asFunctionName() const {
+    return static_cast<StringObject*>(object)->value;
+}
+
+StructObject* Value::asStruct() const {
+    return static_cast<StructObject*>(object);
+}
+
+TaskObject* Value::asTask() const {
+    return static_cast<TaskObject*>(object);
+}
+
+const Ptr<Channel>& Value::asChannel() const {
+    return static_cast<ChannelObject*>(object)->channel;
+}
+
+ArrayObject* Value::asArray() const {
+    return static_cast<ArrayObject*>(object);
+}
+
+const Ptr<LineReader>& Value::asReader() const {
+    return static_cast<ReaderObject*>(object)->reader;
+}
+
+const Ptr<FileWriter>& Value::asWriter() const {
+    return static_cast<WriterObject*>(object)->writer;
+}
+
+BytesObject* Value::asBytes() const {
+    return static_cast<BytesObject*>(object);
+}
+
+const Ptr<CsvReader>& Value::asCsvReader() const {
+    return static_cast<CsvReaderObject*>(object)->reader;
+}
+
+const Ptr<NdjsonReader>& Value::asNdjsonReader() const {
+    return static_cast<NdjsonReaderObject*>(object)->reader;
+}
+
+const Ptr<DirectoryWalker>& Value::asDirectoryWalker() const {
+    return static_cast<DirectoryWalkerObject*>(object)->walker;
+}
 
 String Value::toString() const {
     switch (type) {
     case ValueType::INTEGER:
         return std::to_string(intValue);
     case ValueType::STRING:
-        return stringValue;
+        return String(asStringView());
     case ValueType::FLOAT:
-        return std::to_string(floatValue);
+        return StringUtil::formatFloat(floatValue);
     case ValueType::BOOLEAN:
         return boolValue ? "true" : "false";
     case ValueType::NIL:
         return "nil";
     case ValueType::FUNCTION:
-        return "<function " + functionName + ">";
+        return "<function " + asFunctionName() + ">";
     case ValueType::STRUCT_INSTANCE:
-        return "<struct " + structTypeName + ">";
+        return "<struct " + asStruct()->typeName + ">";
+    case ValueType::TASK:
+        return asTask()->isFinished() ? "<task done>" : "<task pending>";
+    case ValueType::CHANNEL:
+        return "<channel>";
+    case ValueType::READER:
+        return "<reader>";
+    case ValueType::WRITER:
+        return "<writer>";
+    case ValueType::CSV_READER:
+        return "<csv>";
+    case ValueType::NDJSON_READER:
+        return "<ndjson>";
+    case ValueType::DIR_WALKER:
+        return "<walker>";
+    case ValueType::BYTES:
+        return "<bytes " + std::to_string(asBytes()->length) + ">";
+    case ValueType::ARRAY: {
+        String text = "[";
+        for (auto& element : asArray()->elements) {
+            if (text.size() > 1) text += ", ";
+            text += element.isString() ? "\"" + element.asString() + "\"" : element.toString();
+        }
+        return text + "]";
+    }
     default:
         return "<unknown>";
     }
@@ -30,6 +211,15 @@ String Value::getTypeName() const {
     case ValueType::NIL: return "nil";
     case ValueType::FUNCTION: return "function";
     case ValueType::STRUCT_INSTANCE: return "struct";
+    case ValueType::TASK: return "task";
+    case ValueType::CHANNEL: return "channel";
+    case ValueType::ARRAY: return "array";
+    case ValueType::READER: return "reader";
+    case ValueType::WRITER: return "writer";
+    case ValueType::BYTES: return "bytes";
+    case ValueType::CSV_READER: return "csv";
+    case ValueType::NDJSON_READER: return "ndjson";
+    case ValueType::DIR_WALKER: return "walker";
     default: return "unknown";
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,20 @@
 #pragma once
 #include "../Common.h"
+#include <cstdint>
+#include <string_view>
+
+class Object;
+class StructObject;
+class ArrayObject;
+class TaskObject;
+class Channel;
+class MappedFile;
+class LineReader;
+class FileWriter;
+class BytesObject;
+class CsvReader;
+class NdjsonReader;
+class DirectoryWalker;
 
 enum class ValueType {
     INTEGER,
@@ -8,9 +23,23 @@ enum class ValueType {
     BOOLEAN,
     NIL,
     FUNCTION,
-    STRUCT_INSTANCE
+    STRUCT_INSTANCE,
+    TASK,
+    CHANNEL,
+    ARRAY,
+    READER,
+    WRITER,
+    BYTES,
+    CSV_READER,
+    NDJSON_READER,
+    DIR_WALKER,
+    COUNT
 };
 
+// Values are small tagged unions; strings, function names, struct
+// instances, arrays, byte buffers, task, channel, reader, writer, csv,
+// ndjson and walker handles live on the garbage-collected Heap and are shared by
+// pointer.
 class Value {
 public:
     inline bool isInt() const { return type == ValueType::INTEGER; }
@@ -18,44 +47,39 @@ public:
     inline bool isString() const { return type == ValueType::STRING; }
     inline bool isBool() const { return type == ValueType::BOOLEAN; }
 
-    inline int asInt() const { return intValue; }
-    inline float asFloat() const { return floatValue; }
+    inline int64_t asInt() const { return intValue; }
+    inline double asFloat() const { return floatValue; }
     inline bool asBool() const { return boolValue; }
 
     ValueType type;
 
-    int intValue;
-    float floatValue;   
-    String stringValue;
-    bool boolValue;
+    union {
+        int64_t intValue;
+        double floatValue;
+        bool boolValue;
+        Object* object;
+    };
 
-    String functionName;
+    Value() : type(ValueType::NIL), object(nullptr) {}
 
-    Map<String, Value> structFields;
-    String structTypeName;
-
-    Value() : type(ValueType::NIL), intValue(0), floatValue(0.0f), boolValue(false) {}
-
-    static Value makeInt(int val) {
+    static Value makeInt(int64_t val) {
         Value v;
         v.type = ValueType::INTEGER;
         v.intValue = val;
         return v;
     }
 
-    static Value makeFloat(float val) {
+    static Value makeFloat(double val) {
         Value v;
         v.type = ValueType::FLOAT;
         v.floatValue = val;
         return v;
     }
 
-    static Value makeString(const String& val) {
-        Value v;
-        v.type = ValueType::STRING;
-        v.stringValue = val;
-        return v;
-    }
+    static Value makeString(String val);
+    static Value makeMappedString(Ptr<MappedFile> file);
+    // A string viewing range, which must lie inside file's mapping.
+    static Value makeMappedString(Ptr<MappedFile> file, std::string_view range);
 
     static Value makeBool(bool val) {
         Value v;
@@ -68,18 +92,57 @@ public:
         return Value();
     }
 
-    static Value makeFunction(const String& name) {
-        Value v;
-        v.type = ValueType::FUNCTION;
-        v.functionName = name;
-        return v;
-    }
+    static Value makeFunction(const String& name);
+    static Value makeStruct(const String& typeName);
+    static Value makeTask(TaskObject* task);
+    static Value makeChannel(Ptr<Channel> channel);
+    static Value makeArray(size_t size);
+    static Value makeReader(Ptr<LineReader> reader);
+    static Value makeWriter(Ptr<FileWriter> writer);
+    // New bytes, zeroed unless the caller is about to overwrite them all.
+    static Value makeBytes(size_t length, bool zeroed = true);
+    // length bytes of source from offset on, sharing its storage.
+    static Value makeBytesSlice(const Value& source, size_t offset, size_t length);
+    static Value makeCsvReader(Ptr<CsvReader> reader);
+    static Value makeNdjsonReader(Ptr<NdjsonReader> reader);
+    static Value makeDirectoryWalker(Ptr<DirectoryWalker> walker);
 
     bool isNil() const { return type == ValueType::NIL; }
     bool isFunction() const { return type == ValueType::FUNCTION; }
     bool isStruct() const { return type == ValueType::STRUCT_INSTANCE; }
+    bool isTask() const { return type == ValueType::TASK; }
+    bool isChannel() const { return type == ValueType::CHANNEL; }
+    bool isArray() const { return type == ValueType::ARRAY; }
+    bool isReader() const { return type == ValueType::READER; }
+    bool isWriter() const { return type == ValueType::WRITER; }
+    bool isBytes() const { return type == ValueType::BYTES; }
+    bool isCsvReader() const { return type == ValueType::CSV_READER; }
+    bool isNdjsonReader() const { return type == ValueType::NDJSON_READER; }
+    bool isDirectoryWalker() const { return type == ValueType::DIR_WALKER; }
+    bool isHeapObject() const {
+        return type == ValueType::STRING || type == ValueType::FUNCTION ||
+            type == ValueType::STRUCT_INSTANCE || type == ValueType::TASK ||
+            type == ValueType::CHANNEL || type == ValueType::ARRAY ||
+            type == ValueType::READER || type == ValueType::WRITER ||
+            type == ValueType::BYTES || type == ValueType::CSV_READER ||
+            type == ValueType::NDJSON_READER || type == ValueType::DIR_WALKER;
+    }
             
-    const String& asString() const { return stringValue; }
+    const String& asString() const;
+    // The string's bytes without copying; also valid for mapped strings,
+    // which asString() has to copy out first.
+    std::string_view asStringView() const;
+    const String& asFunctionName() const;
+    StructObject* asStruct() const;
+    TaskObject* asTask() const;
+    const Ptr<Channel>& asChannel() const;
+    ArrayObject* asArray() const;
+    const Ptr<LineReader>& asReader() const;
+    const Ptr<FileWriter>& asWriter() const;
+    BytesObject* asBytes() const;
+    const Ptr<CsvReader>& asCsvReader() const;
+    const Ptr<NdjsonReader>& asNdjsonReader() const;
+    const Ptr<DirectoryWalker>& asDirectoryWalker() const;
 
     String toString() const;
     String getTypeName() const;
@@ -87,8 +150,8 @@ public:
     bool isTruthy() const {
         if (isBool()) return boolValue;
         if (isInt()) return intValue != 0;
-        if (isFloat()) return floatValue != 0.0f;               
-        if (isString()) return !stringValue.empty();
+        if (isFloat()) return floatValue != 0.0;               
+        if (isString()) return !asStringView().empty();
         return false;
     }
-};
\ No newline at end of file
+};
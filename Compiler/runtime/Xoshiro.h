@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// xoshiro256** (Blackman and Vigna): 256 bits of state, a few cycles per
+// 64-bit value and no allocation, so each isolate can own one. jump()
+// advances the state by 2^128 values, which splits one seeded generator
+// into non-overlapping streams for parallel work.
+class Xoshiro256 {
+public:
+    explicit Xoshiro256(uint64_t seed = 0) { reseed(seed); }
+
+    // Expands a 64-bit seed with splitmix64, as the authors recommend, so
+    // nearby seeds still give unrelated states.
+    void reseed(uint64_t seed) {
+        for (auto& word : state) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+
+        return result;
+    }
+
+    void jump() {
+        static const uint64_t polynomial[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+
+        uint64_t jumped[4] = { 0, 0, 0, 0 };
+        for (uint64_t word : polynomial) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (word & (1ULL << bit)) {
+                    for (int i = 0; i < 4; ++i) {
+                        jumped[i] ^= state[i];
+                    }
+                }
+                next();
+            }
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            state[i] = jumped[i];
+        }
+    }
+
+    // Uniform in [0, bound) without modulo bias (Lemire's method); bound 0
+    // means the full 64-bit range.
+    uint64_t below(uint64_t bound) {
+        if (bound == 0) {
+            return next();
+        }
+
+        uint64_t high;
+        uint64_t low = multiply(next(), bound, high);
+        if (low < bound) {
+            uint64_t threshold = (0 - bound) % bound;
+            while (low < threshold) {
+                low = multiply(next(), bound, high);
+            }
+        }
+        return high;
+    }
+
+    // Uniform in [min, max], both inclusive.
+    int64_t between(int64_t min, int64_t max) {
+        uint64_t span = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+        return static_cast<int64_t>(static_cast<uint64_t>(min) + below(span));
+    }
+
+    // Uniform in [0, 1) with all 53 bits of the mantissa random.
+    double unit() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static uint64_t multiply(uint64_t a, uint64_t b, uint64_t& high) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return _umul128(a, b, &high);
+#elif defined(__SIZEOF_INT128__)
+        unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        high = static_cast<uint64_t>(product >> 64);
+        return static_cast<uint64_t>(product);
+#else
+        uint64_t aLow = a & 0xffffffffULL, aHigh = a >> 32;
+        uint64_t bLow = b & 0xffffffffULL, bHigh = b >> 32;
+        uint64_t lowLow = aLow * bLow;
+        uint64_t highLow = aHigh * bLow;
+        uint64_t lowHigh = aLow * bHigh;
+        uint64_t middle = (lowLow >> 32) + (highLow & 0xffffffffULL) + lowHigh;
+        high = aHigh * bHigh + (highLow >> 32) + (middle >> 32);
+        return (middle << 32) | (lowLow & 0xffffffffULL);
+#endif
+    }
+};
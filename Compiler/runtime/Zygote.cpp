@@ -0,0 +1,354 @@
+#include "Zygote.h"
+#include "../utils/Error.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+namespace Zygote {
+    void serve(const String& socketPath, const Runner& runner) {
+        throw RuntimeError("--zygote is not supported on this platform");
+    }
+
+    int connect(const String& socketPath, const String& script, const Vec<String>& arguments) {
+        throw RuntimeError("--connect is not supported on this platform");
+    }
+
+    String resolvePath(const String& path) {
+        return path;
+    }
+}
+
+#else
+
+namespace {
+    // A request is a 4-byte payload length sent together with the caller's
+    // stdin, stdout and stderr, followed by the payload: working directory,
+    // script and arguments, each terminated by a NUL. The reply is the run's
+    // exit status as 4 bytes.
+    constexpr int PASSED_FDS = 3;
+
+    // Requests are read in the forked child, so a slow client only holds
+    // up its own child, and that one gives up after the timeout.
+    constexpr uint32_t MAX_REQUEST_BYTES = 1024 * 1024;
+    constexpr int REQUEST_TIMEOUT_SECONDS = 5;
+
+    int childSignalPipe[2] = { -1, -1 };
+
+    void onChildExit(int) {
+        int saved = errno;
+        char byte = 0;
+        ssize_t ignored = write(childSignalPipe[1], &byte, 1);
+        (void)ignored;
+        errno = saved;
+    }
+
+    [[noreturn]] void fail(const String& what) {
+        throw RuntimeError(what + ": " + std::strerror(errno));
+    }
+
+    sockaddr_un socketAddress(const String& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw RuntimeError("Socket path too long: " + path);
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return address;
+    }
+
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool readAll(int fd, char* data, size_t size) {
+        while (size > 0) {
+            ssize_t got = ::read(fd, data, size);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                return false;
+            }
+            data += got;
+            size -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    bool receiveRequest(int connection, int fds[PASSED_FDS], Vec<String>& fields) {
+        uint32_t length = 0;
+        iovec io{ &length, sizeof(length) };
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * PASSED_FDS)];
+        msghdr message{};
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t got;
+        do {
+            got = recvmsg(connection, &message, 0);
+        } while (got < 0 && errno == EINTR);
+
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        if (got != sizeof(length) || !header || header->cmsg_type != SCM_RIGHTS ||
+            header->cmsg_len != CMSG_LEN(sizeof(int) * PASSED_FDS)) {
+            return false;
+        }
+        std::memcpy(fds, CMSG_DATA(header), sizeof(int) * PASSED_FDS);
+
+        String payload(length <= MAX_REQUEST_BYTES ? length : 0, '\0');
+        if (length > MAX_REQUEST_BYTES || !readAll(connection, &payload[0], length)) {
+            for (int i = 0; i < PASSED_FDS; ++i) {
+                close(fds[i]);
+            }
+            return false;
+        }
+
+        size_t start = 0;
+        while (start < payload.size()) {
+            size_t end = payload.find('\0', start);
+            if (end == String::npos) {
+                end = payload.size();
+            }
+            fields.push_back(payload.substr(start, end - start));
+            start = end + 1;
+        }
+        return true;
+    }
+
+    [[noreturn]] void runChild(int listener, int connection, const Map<pid_t, int>& clients,
+        const Zygote::Runner& runner) {
+        signal(SIGCHLD, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+        close(listener);
+        close(childSignalPipe[0]);
+        close(childSignalPipe[1]);
+        for (auto& client : clients) {
+            close(client.second);
+        }
+
+        timeval timeout{ REQUEST_TIMEOUT_SECONDS, 0 };
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        int fds[PASSED_FDS];
+        Vec<String> fields;
+        bool received = receiveRequest(connection, fds, fields);
+        close(connection);
+        if (!received) {
+            std::_Exit(1);
+        }
+
+        for (int i = 0; i < PASSED_FDS; ++i) {
+            dup2(fds[i], i);
+            close(fds[i]);
+        }
+
+        int code = 1;
+        if (fields.size() < 2 || chdir(fields[0].c_str()) != 0) {
+            std::fprintf(stderr, "Error: invalid zygote request\n");
+        }
+        else {
+            Vec<String> arguments(fields.begin() + 2, fields.end());
+            code = runner(Zygote::resolvePath(fields[1]), arguments);
+        }
+
+        std::fflush(nullptr);
+        std::exit(code);
+    }
+}
+
+namespace Zygote {
+    String resolvePath(const String& path) {
+        char* resolved = realpath(path.c_str(), nullptr);
+        if (!resolved) {
+            return path;
+        }
+
+        String result(resolved);
+        std::free(resolved);
+        return result;
+    }
+
+    void serve(const String& socketPath, const Runner& runner) {
+        sockaddr_un address = socketAddress(socketPath);
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) {
+            fail("socket");
+        }
+
+        // A socket left by an earlier server is replaced, but nothing else.
+        struct stat existing;
+        if (lstat(socketPath.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                throw RuntimeError("Cannot bind " + socketPath + ": file exists and is not a socket");
+            }
+            unlink(socketPath.c_str());
+        }
+
+        // Non-blocking, so a client that gives up between poll() and
+        // accept() does not leave the server waiting for the next one.
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            fail("Cannot bind " + socketPath);
+        }
+        if (listen(listener, 128) != 0) {
+            fail("listen");
+        }
+
+        // Children are reaped as they exit and their status is relayed to
+        // the client still waiting on the connection.
+        if (pipe(childSignalPipe) != 0) {
+            fail("pipe");
+        }
+        struct sigaction action{};
+        action.sa_handler = onChildExit;
+        action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+        sigaction(SIGCHLD, &action, nullptr);
+
+        // A client may be gone by the time its status is written.
+        signal(SIGPIPE, SIG_IGN);
+
+        Map<pid_t, int> clients;
+
+        while (true) {
+            pollfd watched[2] = { { listener, POLLIN, 0 }, { childSignalPipe[0], POLLIN, 0 } };
+            if (poll(watched, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail("poll");
+            }
+
+            if (watched[1].revents & POLLIN) {
+                char drained[64];
+                ssize_t ignored = read(childSignalPipe[0], drained, sizeof(drained));
+                (void)ignored;
+
+                int status;
+                pid_t pid;
+                while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                    auto it = clients.find(pid);
+                    if (it == clients.end()) {
+                        continue;
+                    }
+
+                    int32_t code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+                    writeAll(it->second, reinterpret_cast<const char*>(&code), sizeof(code));
+                    close(it->second);
+                    clients.erase(it);
+                }
+            }
+
+            if (!(watched[0].revents & POLLIN)) {
+                continue;
+            }
+
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                continue;
+            }
+
+            pid_t pid = fork();
+            if (pid == 0) {
+                runChild(listener, connection, clients, runner);
+            }
+
+            if (pid < 0) {
+                int32_t code = 1;
+                writeAll(connection, reinterpret_cast<const char*>(&code), sizeof(code));
+                close(connection);
+                continue;
+            }
+            clients[pid] = connection;
+        }
+    }
+
+    int connect(const String& socketPath, const String& script, const Vec<String>& arguments) {
+        sockaddr_un address = socketAddress(socketPath);
+
+        int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connection < 0) {
+            fail("socket");
+        }
+        if (::connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            fail("Cannot connect to " + socketPath);
+        }
+
+        char cwd[4096];
+        if (!getcwd(cwd, sizeof(cwd))) {
+            fail("getcwd");
+        }
+
+        String payload = String(cwd) + '\0' + script + '\0';
+        for (auto& argument : arguments) {
+            payload += argument;
+            payload += '\0';
+        }
+
+        if (payload.size() > MAX_REQUEST_BYTES) {
+            throw RuntimeError("Zygote request too large: " + std::to_string(payload.size()) + " bytes");
+        }
+
+        uint32_t length = static_cast<uint32_t>(payload.size());
+        iovec io{ &length, sizeof(length) };
+
+        int fds[PASSED_FDS] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+        msghdr message{};
+        message.msg_iov = &io;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(fds));
+        std::memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+        if (sendmsg(connection, &message, 0) != sizeof(length) ||
+            !writeAll(connection, payload.data(), payload.size())) {
+            fail("Cannot send request to " + socketPath);
+        }
+
+        int32_t code = 1;
+        if (!readAll(connection, reinterpret_cast<char*>(&code), sizeof(code))) {
+            close(connection);
+            throw RuntimeError("Zygote closed the connection without an exit status");
+        }
+
+        close(connection);
+        return code;
+    }
+}
+
+#endif
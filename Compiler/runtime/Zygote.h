@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../Common.h"
+#include <functional>
+
+// Pre-forking server for many short runs. The server loads the runtime
+// once, then serves requests on a Unix domain socket by forking a child
+// per request; the child inherits everything already loaded copy-on-write
+// and runs the script on the caller's own stdin, stdout and stderr, which
+// travel with the request as SCM_RIGHTS. The client waits for the child's
+// exit status, so it behaves like running the script directly.
+//
+// Only available on POSIX systems. fork() keeps just the calling thread,
+// so the server must not start any threads (thread pool, background I/O)
+// before serving; children start their own on first use.
+namespace Zygote {
+    using Runner = std::function<int(const String& script, const Vec<String>& arguments)>;
+
+    // Serves until the process is killed. runner executes in the forked
+    // child, after it has switched to the caller's descriptors and working
+    // directory, and gets the script as an absolute path (see
+    // resolvePath); its result is the child's exit code.
+    void serve(const String& socketPath, const Runner& runner);
+
+    // Canonical absolute path, or path unchanged if it cannot be resolved.
+    String resolvePath(const String& path);
+
+    // Sends the request to the server at socketPath and returns the exit
+    // code of the run.
+    int connect(const String& socketPath, const String& script, const Vec<String>& arguments);
+}
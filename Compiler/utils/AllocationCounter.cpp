@@ -0,0 +1,54 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local size_t allocations = 0;
+
+    void* allocate(std::size_t size) {
+        allocations++;
+        if (size == 0) {
+            size = 1;
+        }
+
+        while (true) {
+            void* ptr = std::malloc(size);
+            if (ptr) {
+                return ptr;
+            }
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* allocateNothrow(std::size_t size) noexcept {
+        try {
+            return allocate(size);
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+}
+
+namespace AllocationCounter {
+    size_t count() {
+        return allocations;
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocateNothrow(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocateNothrow(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+// Counts calls to the global operator new made by the current thread. Used
+// by system.allocations() so scripts can assert that a hot loop stays off
+// the heap.
+namespace AllocationCounter {
+    size_t count();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// Overflow-checked 64-bit integer arithmetic. Each function stores the
+// wrapped result in `out` and returns true if the exact result did not fit.
+namespace CheckedMath {
+    inline bool addOverflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_add_overflow(a, b, &out);
+#else
+        out = static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+        return ((a ^ out) & (b ^ out)) < 0;
+#endif
+    }
+
+    inline bool subOverflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_sub_overflow(a, b, &out);
+#else
+        out = static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+        return ((a ^ b) & (a ^ out)) < 0;
+#endif
+    }
+
+    inline bool mulOverflow(int64_t a, int64_t b, int64_t& out) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_mul_overflow(a, b, &out);
+#elif defined(_M_X64)
+        int64_t high;
+        out = _mul128(a, b, &high);
+        return high != (out >> 63);
+#else
+        out = static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+        if (a == 0 || b == 0) return false;
+        if ((a == -1 && b == std::numeric_limits<int64_t>::min()) ||
+            (b == -1 && a == std::numeric_limits<int64_t>::min())) return true;
+        return out / b != a;
+#endif
+    }
+}
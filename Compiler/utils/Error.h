@@ -69,4 +69,26 @@ public:
     }
 
     String getType() const override { return "NameError"; }
-};
\ No newline at end of file
+};
+// An integer operation whose exact result does not fit in 64 bits. Reported
+// as a RuntimeError; parallel reductions catch it to rerun pure bodies in
+// order.
+class IntegerOverflowError : public RuntimeError {
+public:
+    IntegerOverflowError(const String& msg, int ln = 0)
+        : RuntimeError(msg, ln) {
+    }
+};
+
+// A script ran past one of its execution limits (steps, time, heap).
+// Derives from RuntimeError so existing handlers still report it.
+class BudgetExceededError : public RuntimeError {
+public:
+    String resource;
+
+    BudgetExceededError(const String& res, const String& msg)
+        : RuntimeError(msg), resource(res) {
+    }
+
+    String getType() const override { return "BudgetExceededError"; }
+};
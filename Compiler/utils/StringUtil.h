@@ -3,6 +3,8 @@
 #include "../Common.h"
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <sstream>
 #include <vector>
 
@@ -133,6 +135,35 @@ namespace StringUtil {
         return true;
     }
 
+    // Parses the whole string; fails on trailing characters or out-of-range values.
+    inline bool parseInt(const String& str, int64_t& out) {
+        const char* end = str.data() + str.size();
+        auto result = std::from_chars(str.data(), end, out);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    inline bool parseFloat(const String& str, double& out) {
+        const char* end = str.data() + str.size();
+        auto result = std::from_chars(str.data(), end, out);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    // Shortest representation that round-trips, always with a decimal point
+    // or exponent so floats stay distinguishable from ints when printed.
+    inline String formatFloat(double value) {
+        char buffer[64];
+        double magnitude = value < 0 ? -value : value;
+        bool fixed = magnitude == 0.0 || (magnitude >= 1e-5 && magnitude < 1e16);
+        auto result = fixed
+            ? std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed)
+            : std::to_chars(buffer, buffer + sizeof(buffer), value);
+        String text(buffer, result.ptr);
+        if (text.find_first_of(".eni") == String::npos) {
+            text += ".0";
+        }
+        return text;
+    }
+
     inline String escape(const String& str) {
         String result;
         for (char c : str) {